@@ -0,0 +1,51 @@
+// Named vs anonymous segment setup, and the cost of handing a segment to a
+// peer by fd.
+//
+//   bench_anonymous_segment [bytes]
+//
+// "named" is shm_open + ftruncate + mmap + shm_unlink; "anonymous" is
+// memfd_create + ftruncate + mmap. "send+recv+adopt" passes the fd over a
+// socketpair and maps it on the other end, i.e. the full rendezvous that
+// replaces a name lookup.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#if !defined(_WIN32)
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
+int main(int argc, char** argv) {
+#if !defined(_WIN32)
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+    const char* name = "/shm_bench_anon";
+
+    (void)shm::segment::remove(name);
+    bench::report("named create+remove", bench::best_ns_per_op(200, 1, [&] {
+        shm::segment s(name, bytes, shm::segment::open_mode::create_only);
+        bench::do_not_optimize(s.data());
+        (void)shm::segment::remove(name);
+    }));
+
+    bench::report("anonymous create", bench::best_ns_per_op(200, 1, [&] {
+        shm::segment s(shm::anonymous_segment, bytes);
+        bench::do_not_optimize(s.data());
+    }));
+
+    shm::segment creator(shm::anonymous_segment, bytes);
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return 1;
+    bench::report("send+recv+adopt", bench::best_ns_per_op(200, 1, [&] {
+        shm::send_fd(sv[0], creator.fd());
+        shm::segment view(shm::adopt_fd, shm::recv_fd(sv[1]));
+        bench::do_not_optimize(view.data());
+    }));
+    ::close(sv[0]);
+    ::close(sv[1]);
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Batch offset decode/encode against a per-element get() loop.
+//
+//   bench_decode_n [elements-per-array]
+//
+// Build with -mavx2, -mavx512f or on an ARMv8 target to exercise the SIMD
+// kernels; a plain build measures the branch-free scalar fallback.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+
+namespace {
+
+struct SegTag {};
+
+struct Item {
+    std::uint64_t v[2];
+};
+
+const char* isa_name() {
+#if defined(SHM_SIMD_AVX512)
+    return "avx512";
+#elif defined(SHM_SIMD_AVX2)
+    return "avx2";
+#elif defined(SHM_SIMD_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+template <class OffsetT>
+void run(const char* offset_name, std::size_t n, std::size_t null_every) {
+    using P = shm::segment_offset_ptr<Item, SegTag, OffsetT>;
+
+    const std::size_t items = 1u << 16;
+    std::vector<Item> region(items);
+    shm::segment_base<SegTag>::set(region.data());
+
+    bench::rng r(7);
+    std::vector<Item*> raw(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        raw[i] = (null_every && i % null_every == 0) ? nullptr : &region[r.next() % items];
+    }
+    std::vector<P> enc(n);
+    for (std::size_t i = 0; i < n; ++i) enc[i] = P(raw[i]);
+    std::vector<Item*> out(n);
+
+    const std::size_t reps = 20;
+    const std::size_t iters = (std::size_t{1} << 24) / (n ? n : 1) + 1;
+
+    const double scalar_dec = bench::best_ns_per_op(reps, iters * n, [&] {
+        for (std::size_t k = 0; k < iters; ++k) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = enc[i].get();
+            bench::clobber();
+        }
+    });
+    const double batch_dec = bench::best_ns_per_op(reps, iters * n, [&] {
+        for (std::size_t k = 0; k < iters; ++k) {
+            shm::decode_n(enc.data(), n, out.data());
+            bench::clobber();
+        }
+    });
+    const double scalar_enc = bench::best_ns_per_op(reps, iters * n, [&] {
+        for (std::size_t k = 0; k < iters; ++k) {
+            for (std::size_t i = 0; i < n; ++i) enc[i] = raw[i];
+            bench::clobber();
+        }
+    });
+    const double batch_enc = bench::best_ns_per_op(reps, iters * n, [&] {
+        for (std::size_t k = 0; k < iters; ++k) {
+            shm::encode_n(raw.data(), n, enc.data());
+            bench::clobber();
+        }
+    });
+
+    std::printf("%-9s n=%-6zu nulls=1/%-3zu  decode: get() %6.3f  decode_n %6.3f   "
+                "encode: assign %6.3f  encode_n %6.3f  (ns/elem)\n",
+                offset_name, n, null_every, scalar_dec, batch_dec, scalar_enc, batch_enc);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, 256);
+    std::printf("kernel: %s\n", isa_name());
+    for (std::size_t nulls : {std::size_t{0}, std::size_t{4}}) {
+        run<std::uint32_t>("uint32_t", n, nulls);
+        run<std::int32_t>("int32_t", n, nulls);
+        run<std::uint64_t>("uint64_t", n, nulls);
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// fat_offset_ptr (segment_table lookup) against segment_offset_ptr.
+//
+//   bench_fat_offset_ptr [nodes] [segments]
+//
+// The fat-pointer list is spread round-robin over `segments` buffers so that
+// consecutive hops change segment id; the segment_offset_ptr list lives in one
+// buffer of the same total size.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+#include <memory>
+
+namespace {
+
+struct SegTag {};
+
+struct FatNode {
+    shm::fat_offset_ptr<FatNode> next;
+    std::uint64_t payload;
+};
+
+struct SegNode {
+    shm::segment_offset_ptr<SegNode, SegTag, std::uint32_t> next;
+    std::uint32_t pad;
+    std::uint64_t payload;
+};
+
+static_assert(sizeof(FatNode) == sizeof(SegNode));
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+    const std::size_t k = std::min<std::size_t>(bench::arg_or(argc, argv, 2, 50), shm::segment_table::capacity);
+    const std::size_t per = (n + k - 1) / k;
+
+    const auto order = bench::random_cycle(n, 99);
+
+    // Fat pointers over k segments.
+    std::vector<std::unique_ptr<bench::aligned_buffer>> segs;
+    for (std::size_t s = 0; s < k; ++s) {
+        segs.push_back(std::make_unique<bench::aligned_buffer>(per * sizeof(FatNode)));
+        std::memset(segs.back()->p, 0, segs.back()->n);
+        shm::segment_table::set(static_cast<shm::segment_id>(s), segs.back()->p, segs.back()->n);
+    }
+    auto fat_at = [&](std::size_t i) {
+        return reinterpret_cast<FatNode*>(segs[i % k]->p) + i / k;
+    };
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t from = order[i], to = order[(i + 1) % n];
+        fat_at(from)->next = shm::fat_offset_ptr<FatNode>(static_cast<shm::segment_id>(to % k), fat_at(to));
+    }
+
+    // segment_offset_ptr over one segment.
+    bench::aligned_buffer one(n * sizeof(SegNode));
+    std::memset(one.p, 0, one.n);
+    shm::segment_base<SegTag>::set(one.p);
+    auto* seg_nodes = reinterpret_cast<SegNode*>(one.p);
+    for (std::size_t i = 0; i < n; ++i) {
+        seg_nodes[order[i]].next = &seg_nodes[order[(i + 1) % n]];
+    }
+
+    const double fat_chase = bench::best_ns_per_op(5, n, [&] {
+        FatNode* cur = fat_at(order[0]);
+        for (std::size_t i = 0; i < n; ++i) cur = cur->next.get();
+        bench::do_not_optimize(cur);
+    });
+    const double seg_chase = bench::best_ns_per_op(5, n, [&] {
+        SegNode* cur = &seg_nodes[order[0]];
+        for (std::size_t i = 0; i < n; ++i) cur = cur->next.get();
+        bench::do_not_optimize(cur);
+    });
+
+    const double fat_decode = bench::best_ns_per_op(5, n, [&] {
+        std::uintptr_t acc = 0;
+        for (std::size_t i = 0; i < n; ++i) acc += reinterpret_cast<std::uintptr_t>(fat_at(i)->next.get());
+        bench::do_not_optimize(acc);
+    });
+    const double seg_decode = bench::best_ns_per_op(5, n, [&] {
+        std::uintptr_t acc = 0;
+        for (std::size_t i = 0; i < n; ++i) acc += reinterpret_cast<std::uintptr_t>(seg_nodes[i].next.get());
+        bench::do_not_optimize(acc);
+    });
+
+    std::printf("nodes=%zu segments=%zu\n", n, k);
+    std::printf("%-36s chase %8.3f ns/hop   decode %7.3f ns/link\n", "fat_offset_ptr", fat_chase, fat_decode);
+    std::printf("%-36s chase %8.3f ns/hop   decode %7.3f ns/link\n", "segment_offset_ptr<uint32_t>", seg_chase, seg_decode);
+
+    for (std::size_t s = 0; s < k; ++s) shm::segment_table::clear(static_cast<shm::segment_id>(s));
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Flush strategies for a file-backed segment.
+//
+//   bench_file_flush [bytes] [updates] [dir]
+//
+// Each round scatters `updates` 8-byte writes over the segment and then
+// flushes them: the whole mapping with msync(MS_SYNC), only the chunks
+// recorded with mark_dirty(), or an async writeback kick. "mark_dirty" is
+// the per-update bookkeeping cost on the write path.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstdio>
+#include <string>
+
+int main(int argc, char** argv) {
+#if !defined(_WIN32)
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{256} << 20);
+    const std::size_t updates = bench::arg_or(argc, argv, 2, 1000);
+    const std::string dir = argc > 3 ? argv[3] : "/tmp";
+    const std::string path = dir + "/shm_bench_file_flush";
+
+    std::remove(path.c_str());
+    shm::segment s(shm::file_backed, path.c_str(), bytes, shm::segment::open_mode::create_only);
+    auto* words = static_cast<std::uint64_t*>(s.data());
+    const std::size_t n = s.data_size() / sizeof(std::uint64_t);
+    for (std::size_t i = 0; i < n; i += 512) words[i] = i;
+    (void)s.flush();
+
+    bench::rng r(7);
+    auto scatter = [&](bool mark) {
+        for (std::size_t k = 0; k < updates; ++k) {
+            const std::size_t i = r.next() % n;
+            words[i] += 1;
+            if (mark) s.mark_dirty(i * sizeof(std::uint64_t), sizeof(std::uint64_t));
+        }
+    };
+
+    bench::report("flush() sync, whole mapping", bench::best_ns_per_op(5, 1, [&] {
+        scatter(false);
+        (void)s.flush();
+    }));
+    bench::report("flush_dirty() sync", bench::best_ns_per_op(5, 1, [&] {
+        scatter(true);
+        (void)s.flush_dirty();
+    }));
+    bench::report("flush_dirty() async", bench::best_ns_per_op(5, 1, [&] {
+        scatter(true);
+        (void)s.flush_dirty(shm::flush_mode::async);
+    }));
+    (void)s.flush();
+
+    bench::report("mark_dirty", bench::best_ns_per_op(5, updates, [&] {
+        for (std::size_t k = 0; k < updates; ++k) {
+            s.mark_dirty((r.next() % n) * sizeof(std::uint64_t), sizeof(std::uint64_t));
+        }
+    }));
+    (void)s.flush_dirty();
+
+    std::remove(path.c_str());
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    return 0;
+}
@@ -0,0 +1,106 @@
+// fixed_anchor against segment_anchor, self_anchor and raw pointers.
+//
+//   bench_fixed_anchor [nodes]
+//
+// All lists live in one shm::segment mapped at a fixed address. "chase" and
+// "decode" are as in bench_scaled_offset_ptr. "decode+clobber" adds a compiler
+// barrier per link, which forces segment_anchor to reload its base on every
+// decode, as it would across opaque calls; fixed_anchor has no base to reload.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct SegTag {};
+
+constexpr shm::detail::uptr kBase =
+    static_cast<shm::detail::uptr>(sizeof(void*) == 8 ? 0x5b0000000000ull : 0x50000000ull);
+
+template <class Link>
+struct alignas(16) Node {
+    Link next;
+    std::uint32_t payload;
+};
+
+template <class Link, class Make, class Read>
+void run(const char* name, std::byte* mem, std::size_t n, Make make, Read read) {
+    using N = Node<Link>;
+    std::memset(mem, 0, n * sizeof(N));
+
+    N* nodes = reinterpret_cast<N*>(mem);
+    const auto order = bench::random_cycle(n, 42);
+    for (std::size_t i = 0; i < n; ++i) {
+        N* cur = ::new (&nodes[order[i]]) N{};
+        cur->payload = static_cast<std::uint32_t>(i);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        make(nodes[order[i]].next, &nodes[order[(i + 1) % n]]);
+    }
+
+    const double chase = bench::best_ns_per_op(5, n, [&] {
+        N* cur = &nodes[order[0]];
+        for (std::size_t i = 0; i < n; ++i) cur = read(cur->next);
+        bench::do_not_optimize(cur);
+    });
+
+    const double decode = bench::best_ns_per_op(5, n, [&] {
+        std::uintptr_t acc = 0;
+        for (std::size_t i = 0; i < n; ++i) acc += reinterpret_cast<std::uintptr_t>(read(nodes[i].next));
+        bench::do_not_optimize(acc);
+    });
+
+    const double clobbered = bench::best_ns_per_op(5, n, [&] {
+        std::uintptr_t acc = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            acc += reinterpret_cast<std::uintptr_t>(read(nodes[i].next));
+            bench::clobber();
+        }
+        bench::do_not_optimize(acc);
+    });
+
+    std::printf("%-32s chase %8.3f ns/hop   decode %7.3f ns/link   decode+clobber %7.3f ns/link\n",
+                name, chase, decode, clobbered);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+
+    const std::string name = "/shm_bench_fixed_anchor";
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment_options opts;
+    opts.fixed_address = reinterpret_cast<void*>(kBase);
+    shm::segment seg(name.c_str(), n * 32, shm::segment::open_mode::create_only, opts);
+    seg.bind<SegTag>();
+    auto* mem = static_cast<std::byte*>(seg.base());
+
+    struct RawLink { void* p; };
+    using Fixed = shm::fixed_offset_ptr<void, kBase, std::uint32_t>;
+    using Seg   = shm::segment_offset_ptr<void, SegTag, std::uint32_t>;
+    using Self  = shm::offset_ptr<void, shm::self_anchor, std::int32_t>;
+
+    run<RawLink>("raw pointer", mem, n,
+        [](RawLink& l, void* t) { l.p = t; },
+        [](const RawLink& l) { return static_cast<Node<RawLink>*>(l.p); });
+
+    run<Fixed>("fixed_offset_ptr<uint32_t>", mem, n,
+        [](Fixed& l, void* t) { l = Fixed(t); },
+        [](const Fixed& l) { return static_cast<Node<Fixed>*>(l.get()); });
+
+    run<Seg>("segment_offset_ptr<uint32_t>", mem, n,
+        [](Seg& l, void* t) { l = Seg(t); },
+        [](const Seg& l) { return static_cast<Node<Seg>*>(l.get()); });
+
+    run<Self>("offset_ptr<self_anchor>", mem, n,
+        [](Self& l, void* t) { l = t; },
+        [](const Self& l) { return static_cast<Node<Self>*>(l.get()); });
+
+    (void)shm::segment::remove(name.c_str());
+    return 0;
+}
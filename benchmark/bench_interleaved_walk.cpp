@@ -0,0 +1,144 @@
+// interleaved_walk against one-chain-at-a-time traversal.
+//
+//   bench_interleaved_walk [nodes] [chain_length]
+//
+// "chains": `nodes / chain_length` linked lists whose nodes are scattered
+// over the whole buffer; every chain is walked to the end.
+// "hash probe": a chained hash table with one bucket per four entries; each
+// lookup walks its bucket until the key matches.
+// Both are reported as ns per visited node for the plain loop and for
+// interleaved_walk at several widths.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+
+namespace {
+
+struct SegTag {};
+
+struct Node {
+    std::uint64_t key;
+    shm::segment_offset_ptr<Node, SegTag> next;
+    std::uint32_t pad[13];
+};
+static_assert(sizeof(Node) == 64);
+
+std::uint64_t hash(std::uint64_t k) noexcept {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    return k;
+}
+
+template <std::size_t W>
+double chains_interleaved(Node* const* heads, std::size_t chains, std::size_t visits) {
+    return bench::best_ns_per_op(5, visits, [&] {
+        std::uint64_t acc = 0;
+        shm::interleaved_walk<W>(heads, chains, [&](std::size_t, Node* n) {
+            acc += n->key;
+            return n->next.get();
+        });
+        bench::do_not_optimize(acc);
+    });
+}
+
+// Bucket heads are resolved in a first pass; those loads are independent, so
+// the core overlaps them without help. The chain steps are then interleaved.
+template <std::size_t W>
+double probe_interleaved(const shm::segment_offset_ptr<Node, SegTag>* table, std::size_t buckets,
+                         Node** heads, const std::uint64_t* keys, std::size_t lookups, std::size_t visits) {
+    return bench::best_ns_per_op(5, visits, [&] {
+        for (std::size_t i = 0; i < lookups; ++i) heads[i] = table[hash(keys[i]) % buckets].get();
+        std::size_t hits = 0;
+        shm::interleaved_walk<W>(heads, lookups, [&](std::size_t i, Node* n) -> Node* {
+            if (n->key == keys[i]) { ++hits; return nullptr; }
+            return n->next.get();
+        });
+        bench::do_not_optimize(hits);
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n   = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+    const std::size_t len = bench::arg_or(argc, argv, 2, std::size_t{32});
+
+    bench::aligned_buffer buf(n * sizeof(Node));
+    std::memset(buf.p, 0, buf.n);
+    shm::segment_base<SegTag>::set(buf.p);
+    Node* nodes = reinterpret_cast<Node*>(buf.p);
+    const auto order = bench::random_cycle(n, 7);
+
+    // Chain walk.
+    const std::size_t chains = n / len;
+    std::vector<Node*> heads(chains);
+    for (std::size_t c = 0; c < chains; ++c) {
+        heads[c] = &nodes[order[c * len]];
+        for (std::size_t j = 0; j < len; ++j) {
+            Node* cur = &nodes[order[c * len + j]];
+            cur->key = c * len + j;
+            cur->next = (j + 1 < len) ? &nodes[order[c * len + j + 1]] : nullptr;
+        }
+    }
+    const std::size_t visits = chains * len;
+
+    const double plain = bench::best_ns_per_op(5, visits, [&] {
+        std::uint64_t acc = 0;
+        for (std::size_t c = 0; c < chains; ++c) {
+            for (Node* cur = heads[c]; cur; cur = cur->next.get()) acc += cur->key;
+        }
+        bench::do_not_optimize(acc);
+    });
+
+    std::printf("chains: %zu x %zu nodes\n", chains, len);
+    bench::report("  sequential", plain);
+    bench::report("  interleaved_walk<4>",  chains_interleaved<4>(heads.data(), chains, visits));
+    bench::report("  interleaved_walk<8>",  chains_interleaved<8>(heads.data(), chains, visits));
+    bench::report("  interleaved_walk<16>", chains_interleaved<16>(heads.data(), chains, visits));
+    bench::report("  interleaved_walk<32>", chains_interleaved<32>(heads.data(), chains, visits));
+
+    // Hash probe: rebuild the same nodes into buckets.
+    const std::size_t buckets = n / 4;
+    std::vector<shm::segment_offset_ptr<Node, SegTag>> table(buckets);
+    for (std::size_t i = 0; i < n; ++i) {
+        Node* e = &nodes[order[i]];
+        e->key = i * 2654435761u + 1;
+        auto& b = table[hash(e->key) % buckets];
+        e->next = b;
+        b = shm::segment_offset_ptr<Node, SegTag>(e);
+    }
+
+    const std::size_t lookups = n / 2;
+    std::vector<std::uint64_t> keys(lookups);
+    bench::rng r(11);
+    for (auto& k : keys) k = (r.next() % n) * 2654435761u + 1;
+
+    // Node visits per lookup are identical for every variant; count once.
+    std::size_t probe_visits = 0;
+    for (std::size_t i = 0; i < lookups; ++i) {
+        for (Node* cur = table[hash(keys[i]) % buckets].get(); cur; cur = cur->next.get()) {
+            ++probe_visits;
+            if (cur->key == keys[i]) break;
+        }
+    }
+
+    std::vector<Node*> probe_heads(lookups);
+    const double probe_plain = bench::best_ns_per_op(5, probe_visits, [&] {
+        std::size_t hits = 0;
+        for (std::size_t i = 0; i < lookups; ++i) {
+            for (Node* cur = table[hash(keys[i]) % buckets].get(); cur; cur = cur->next.get()) {
+                if (cur->key == keys[i]) { ++hits; break; }
+            }
+        }
+        bench::do_not_optimize(hits);
+    });
+
+    std::printf("hash probe: %zu lookups, %zu buckets\n", lookups, buckets);
+    bench::report("  sequential", probe_plain);
+    bench::report("  interleaved_walk<8>",  probe_interleaved<8>(table.data(), buckets, probe_heads.data(), keys.data(), lookups, probe_visits));
+    bench::report("  interleaved_walk<16>", probe_interleaved<16>(table.data(), buckets, probe_heads.data(), keys.data(), lookups, probe_visits));
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Byte ring in a shm::segment: wrap-around handled by splitting vs a
+// mirrored mapping.
+//
+//   bench_mirror_ring [ring_bytes] [max_message]
+//
+// Each op appends one variable-sized message at the head and "parses" it
+// (sums its bytes) from the same position. "split" is an ordinary segment:
+// the writer issues two memcpys when a message crosses the end and the
+// reader copies it into a scratch buffer to get a contiguous view. "mirror"
+// copies and reads in place through ring_view(). Small rings wrap often and
+// show the difference most.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+std::uint64_t parse(const std::byte* p, std::size_t n) noexcept {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += static_cast<std::uint8_t>(p[i]);
+    return sum;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+#if !defined(_WIN32)
+    const std::size_t ring = bench::arg_or(argc, argv, 1, std::size_t{64} << 10);
+    const std::size_t max_msg = bench::arg_or(argc, argv, 2, std::size_t{1500});
+    constexpr std::size_t kOps = 1 << 20;
+
+    std::vector<std::size_t> sizes(4096);
+    bench::rng r{7};
+    for (auto& n : sizes) n = 1 + static_cast<std::size_t>(r.next() % max_msg);
+    std::vector<std::byte> msg(max_msg, std::byte{0x2a});
+    std::vector<std::byte> scratch(max_msg);
+
+    shm::segment_options mo;
+    mo.mirror = true;
+    shm::segment plain(shm::anonymous_segment, ring);
+    shm::segment mirrored(shm::anonymous_segment, ring, mo);
+
+    bench::report("split: write+parse", bench::best_ns_per_op(5, kOps, [&] {
+        auto* base = static_cast<std::byte*>(plain.data());
+        std::size_t head = 0;
+        std::uint64_t acc = 0;
+        for (std::size_t i = 0; i < kOps; ++i) {
+            const std::size_t n = sizes[i & (sizes.size() - 1)];
+            const std::size_t pos = head % ring;
+            const std::size_t first = (std::min)(n, ring - pos);
+            std::memcpy(base + pos, msg.data(), first);
+            if (first < n) std::memcpy(base, msg.data() + first, n - first);
+
+            const std::byte* view = base + pos;
+            if (first < n) {
+                std::memcpy(scratch.data(), base + pos, first);
+                std::memcpy(scratch.data() + first, base, n - first);
+                view = scratch.data();
+            }
+            acc += parse(view, n);
+            head += n;
+        }
+        bench::do_not_optimize(acc);
+    }));
+
+    bench::report("mirror: write+parse", bench::best_ns_per_op(5, kOps, [&] {
+        std::size_t head = 0;
+        std::uint64_t acc = 0;
+        for (std::size_t i = 0; i < kOps; ++i) {
+            const std::size_t n = sizes[i & (sizes.size() - 1)];
+            auto v = mirrored.ring_view(head, n);
+            std::memcpy(v.data(), msg.data(), n);
+            acc += parse(v.data(), n);
+            head += n;
+        }
+        bench::do_not_optimize(acc);
+    }));
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    return 0;
+}
@@ -0,0 +1,85 @@
+// offset_ref (raw displacement, no null branch) against offset_ptr.
+//
+//   bench_offset_ref [nodes]
+//
+// Same list layout and measurements as bench_scaled_offset_ptr: "chase" is
+// latency bound, "decode" is throughput bound.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+
+namespace {
+
+struct SegTag {};
+
+struct alignas(16) Payload {
+    std::uint64_t pad[2];
+};
+
+template <class Link>
+struct alignas(16) Node {
+    Link next;
+    std::uint32_t payload;
+};
+
+// Links are typed as Payload to keep Node non-recursive; reads cast back.
+// offset_ref has no default state, so links are placement-constructed.
+template <class Link, class Make, class Read>
+void run(const char* name, std::size_t n, Make make, Read read) {
+    using N = Node<Link>;
+    bench::aligned_buffer buf(n * sizeof(N));
+    std::memset(buf.p, 0, buf.n);
+    shm::segment_base<SegTag>::set(buf.p);
+
+    N* nodes = reinterpret_cast<N*>(buf.p);
+    const auto order = bench::random_cycle(n, 42);
+    for (std::size_t i = 0; i < n; ++i) {
+        make(nodes[order[i]].next, &nodes[order[(i + 1) % n]]);
+        nodes[order[i]].payload = static_cast<std::uint32_t>(i);
+    }
+
+    const double chase = bench::best_ns_per_op(5, n, [&] {
+        N* cur = &nodes[order[0]];
+        for (std::size_t i = 0; i < n; ++i) cur = read(cur->next);
+        bench::do_not_optimize(cur);
+    });
+
+    const double decode = bench::best_ns_per_op(5, n, [&] {
+        std::uintptr_t acc = 0;
+        for (std::size_t i = 0; i < n; ++i) acc += reinterpret_cast<std::uintptr_t>(read(nodes[i].next));
+        bench::do_not_optimize(acc);
+    });
+
+    std::printf("%-36s chase %8.3f ns/hop   decode %7.3f ns/link\n", name, chase, decode);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+
+    using SegPtr  = shm::segment_offset_ptr<Payload, SegTag, std::uint32_t>;
+    using SegRef  = shm::segment_offset_ref<Payload, SegTag, std::uint32_t>;
+    using SelfPtr = shm::offset_ptr<Payload, shm::self_reloc_anchor, std::int32_t>;
+    using SelfRef = shm::offset_ref<Payload, shm::self_reloc_anchor, std::int32_t>;
+
+    run<SegPtr>("segment_offset_ptr<uint32_t>", n,
+        [](SegPtr& l, void* t) { ::new (&l) SegPtr(static_cast<Payload*>(t)); },
+        [](const SegPtr& l) { return reinterpret_cast<Node<SegPtr>*>(l.get()); });
+
+    run<SegRef>("segment_offset_ref<uint32_t>", n,
+        [](SegRef& l, void* t) { ::new (&l) SegRef(*static_cast<Payload*>(t)); },
+        [](const SegRef& l) { return reinterpret_cast<Node<SegRef>*>(l.address()); });
+
+    run<SelfPtr>("offset_ptr<self_reloc_anchor>", n,
+        [](SelfPtr& l, void* t) { ::new (&l) SelfPtr(static_cast<Payload*>(t)); },
+        [](const SelfPtr& l) { return reinterpret_cast<Node<SelfPtr>*>(l.get()); });
+
+    run<SelfRef>("offset_ref<self_reloc_anchor>", n,
+        [](SelfRef& l, void* t) { ::new (&l) SelfRef(*static_cast<Payload*>(t)); },
+        [](const SelfRef& l) { return reinterpret_cast<Node<SelfRef>*>(l.address()); });
+
+    return 0;
+}
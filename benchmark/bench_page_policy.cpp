@@ -0,0 +1,64 @@
+// Random 8-byte loads over a segment under each page_policy, with the
+// huge-page coverage the kernel actually granted.
+//
+//   bench_page_policy [bytes] [loads]
+//
+// The access pattern is dependent (each load picks the next index), so the
+// result is dominated by TLB and cache misses rather than load throughput.
+// hugetlb rows are skipped when the host has no hugetlbfs pool.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace {
+
+struct policy {
+    const char* label;
+    shm::page_policy pages;
+};
+
+constexpr policy kPolicies[] = {
+    {"thp_advise",     shm::page_policy::thp_advise},
+    {"system_default", shm::page_policy::system_default},
+    {"thp_never",      shm::page_policy::thp_never},
+    {"hugetlb_2m",     shm::page_policy::hugetlb_2m},
+    {"hugetlb_1g",     shm::page_policy::hugetlb_1g},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{1} << 30);
+    const std::size_t loads = bench::arg_or(argc, argv, 2, std::size_t{1} << 22);
+    const std::string name = "/shm_bench_pages";
+
+    for (const policy& p : kPolicies) {
+        shm::segment_options o;
+        o.pages = p.pages;
+        (void)shm::segment::remove(name.c_str(), o);
+        try {
+            shm::segment s(name.c_str(), bytes, shm::segment::open_mode::create_only, o);
+            auto* words = static_cast<std::uint64_t*>(s.data());
+            const std::size_t n = s.data_size() / sizeof(std::uint64_t);
+
+            bench::rng r(42);
+            for (std::size_t i = 0; i < n; ++i) words[i] = r.next() % n;
+
+            const double ns = bench::best_ns_per_op(3, loads, [&] {
+                std::uint64_t i = 0;
+                for (std::size_t k = 0; k < loads; ++k) i = words[i];
+                bench::do_not_optimize(i);
+            });
+            std::printf("%-16s %10.3f ns/load   huge-page backed: %zu / %zu MiB\n", p.label, ns,
+                        s.huge_page_bytes() >> 20, s.size() >> 20);
+        } catch (const std::exception& e) {
+            std::printf("%-16s skipped (%s)\n", p.label, e.what());
+        }
+        (void)shm::segment::remove(name.c_str(), o);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Copy-on-write private views: setup, first-write and reset costs.
+//
+//   bench_private_view [bytes] [touched_fraction_percent]
+//
+// "open" maps a view. "cow writes" writes one byte on each of the touched
+// pages through the view, so each write pays a page copy; "shared writes"
+// is the same loop on the shared mapping for reference. "discard" drops
+// the private copies, and "reopen" is the alternative reset: destroying
+// the view and opening a new one.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+int main(int argc, char** argv) {
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{64} << 20);
+    const std::size_t percent = bench::arg_or(argc, argv, 2, std::size_t{10});
+    const char* name = "/shm_bench_private_view";
+    constexpr std::size_t kPage = 4096;
+    const std::size_t stride = percent ? kPage * 100 / percent : bytes;
+    const std::size_t touched = (bytes + stride - 1) / stride;
+
+    (void)shm::segment::remove(name);
+    shm::segment live(name, bytes, shm::segment::open_mode::create_only);
+    std::memset(live.data(), 1, bytes);
+
+    bench::report("open", bench::best_ns_per_op(20, 1, [&] {
+        auto v = live.open_private_view();
+        bench::do_not_optimize(v->data());
+    }));
+
+    auto view = live.open_private_view();
+    auto* v = static_cast<unsigned char*>(view->data());
+    auto* p = static_cast<unsigned char*>(live.data());
+
+    bench::report("cow writes (per page)", bench::best_ns_per_op(5, touched, [&] {
+        (void)view->discard();
+        for (std::size_t i = 0; i < bytes; i += stride) v[i] = 2;
+        bench::clobber();
+    }));
+    bench::report("shared writes (per page)", bench::best_ns_per_op(5, touched, [&] {
+        for (std::size_t i = 0; i < bytes; i += stride) p[i] = 1;
+        bench::clobber();
+    }));
+
+    // Resets are timed alone; the pages are dirtied again before each one.
+    auto best_reset = [&](auto&& reset) {
+        double best = 1e300;
+        for (int r = 0; r < 5; ++r) {
+            for (std::size_t i = 0; i < bytes; i += stride) v[i] = 2;
+            const auto t0 = std::chrono::steady_clock::now();
+            reset();
+            best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+        }
+        return best;
+    };
+    bench::report("discard", best_reset([&] { (void)view->discard(); }));
+    bench::report("reopen", best_reset([&] {
+        view.reset();
+        view = live.open_private_view();
+        v = static_cast<unsigned char*>(view->data());
+    }));
+
+    view.reset();
+    (void)shm::segment::remove(name);
+    return 0;
+}
@@ -0,0 +1,67 @@
+// relocate_range against element-wise copy construction for self-relative
+// links.
+//
+//   bench_relocate_range [elements]
+//
+// Models a vector growth step: n elements holding self_anchor links (half
+// into the array, half to an external object) move to a new buffer.
+// "copy-construct" is what a container does today: one rebasing copy per
+// field, which also leaves the intra-array links aimed at the old buffer.
+// "relocate_range" copies and fixes both kinds of link in one pass.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+struct Elem {
+    std::uint64_t key;
+    shm::offset_ptr<Elem> sibling;
+    shm::offset_ptr<std::uint64_t> shared;
+};
+
+} // namespace
+
+template <>
+struct shm::link_fields<Elem> {
+    static constexpr auto value = std::make_tuple(&Elem::sibling, &Elem::shared);
+};
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 18);
+
+    // One allocation: [external object | array A | array B], so every
+    // self-relative displacement fits in int32.
+    bench::aligned_buffer mem((2 * n + 1) * sizeof(Elem));
+    auto* external = reinterpret_cast<std::uint64_t*>(mem.p);
+    *external = 42;
+    auto* src = reinterpret_cast<Elem*>(mem.p) + 1;
+    auto* dst = src + n;
+
+    bench::rng r(5);
+    for (std::size_t i = 0; i < n; ++i) ::new (&src[i]) Elem{i, nullptr, nullptr};
+    for (std::size_t i = 0; i < n; ++i) {
+        src[i].sibling = &src[r.next() % n];
+        src[i].shared = external;
+    }
+
+    const double copy = bench::best_ns_per_op(5, n, [&] {
+        for (std::size_t i = 0; i < n; ++i) ::new (&dst[i]) Elem(src[i]);
+        bench::clobber();
+    });
+
+    // Ping-pong so every run starts from valid objects.
+    const double reloc = bench::best_ns_per_op(6, n, [&] {
+        shm::relocate_range(dst, src, n);
+        std::swap(src, dst);
+        bench::clobber();
+    });
+
+    std::printf("elements=%zu (%zu bytes each)\n", n, sizeof(Elem));
+    bench::report("copy-construct (rebasing copies)", copy);
+    bench::report("relocate_range", reloc);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Decode cost of scaled offsets against plain segment offsets and raw pointers.
+//
+//   bench_scaled_offset_ptr [nodes]
+//
+// "chase" walks a randomly permuted singly linked list (latency bound, shows
+// whether the extra shift is hidden behind the load). "decode" turns an array
+// of independent links into addresses (throughput bound, shows the raw ALU
+// cost of the encoding).
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+
+namespace {
+
+struct SegTag {};
+
+template <class Link>
+struct alignas(16) Node {
+    Link next;
+    std::uint32_t payload;
+};
+
+template <class Link, class Make, class Read>
+void run(const char* name, std::size_t n, Make make, Read read) {
+    using N = Node<Link>;
+    bench::aligned_buffer buf(n * sizeof(N));
+    std::memset(buf.p, 0, buf.n);
+    shm::segment_base<SegTag>::set(buf.p);
+
+    N* nodes = reinterpret_cast<N*>(buf.p);
+    const auto order = bench::random_cycle(n, 42);
+    for (std::size_t i = 0; i < n; ++i) {
+        N* cur = ::new (&nodes[order[i]]) N{};
+        cur->payload = static_cast<std::uint32_t>(i);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        make(nodes[order[i]].next, &nodes[order[(i + 1) % n]]);
+    }
+
+    const double chase = bench::best_ns_per_op(5, n, [&] {
+        N* cur = &nodes[order[0]];
+        for (std::size_t i = 0; i < n; ++i) cur = read(cur->next);
+        bench::do_not_optimize(cur);
+    });
+
+    const double decode = bench::best_ns_per_op(5, n, [&] {
+        std::uintptr_t acc = 0;
+        for (std::size_t i = 0; i < n; ++i) acc += reinterpret_cast<std::uintptr_t>(read(nodes[i].next));
+        bench::do_not_optimize(acc);
+    });
+
+    std::printf("%-40s chase %8.3f ns/hop   decode %7.3f ns/link\n", name, chase, decode);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+
+    struct RawLink { void* p; };
+    using Seg32    = shm::segment_offset_ptr<void, SegTag, std::uint32_t>;
+    using Seg64    = shm::segment_offset_ptr<void, SegTag, std::uint64_t>;
+    using Scaled16 = shm::scaled_segment_offset_ptr<void, SegTag, std::uint32_t, 16>;
+
+    run<RawLink>("raw pointer", n,
+        [](RawLink& l, void* t) { l.p = t; },
+        [](const RawLink& l) { return static_cast<Node<RawLink>*>(l.p); });
+
+    run<Seg32>("segment_offset_ptr<uint32_t>", n,
+        [](Seg32& l, void* t) { l = Seg32(t); },
+        [](const Seg32& l) { return static_cast<Node<Seg32>*>(l.get()); });
+
+    run<Seg64>("segment_offset_ptr<uint64_t>", n,
+        [](Seg64& l, void* t) { l = Seg64(t); },
+        [](const Seg64& l) { return static_cast<Node<Seg64>*>(l.get()); });
+
+    run<Scaled16>("scaled_segment_offset_ptr<uint32_t, 16>", n,
+        [](Scaled16& l, void* t) { l = Scaled16(t); },
+        [](const Scaled16& l) { return static_cast<Node<Scaled16>*>(l.get()); });
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Effect of segment::advise on a following scan.
+//
+//   bench_segment_advise [bytes]
+//
+// The segment is filled, then advice::dontneed drops this process's page
+// mappings so the scan starts from the usual post-attach state: data in
+// the page cache, no page tables. Each row applies one advice and then
+// reads one byte per page; "advise" and "scan" are timed separately, and
+// their sum is what a reader pays before it has touched everything.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+struct row {
+    const char* label;
+    bool apply;
+    shm::advice a;
+};
+
+constexpr row kRows[] = {
+    {"none",           false, shm::advice::normal},
+    {"willneed",       true,  shm::advice::willneed},
+    {"sequential",     true,  shm::advice::sequential},
+    {"populate_read",  true,  shm::advice::populate_read},
+    {"populate_write", true,  shm::advice::populate_write},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+#if !defined(_WIN32)
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{256} << 20);
+    constexpr std::size_t kPage = 4096;
+    constexpr int kReps = 3;
+
+    shm::segment_options o;
+    o.pages = shm::page_policy::thp_never;
+    shm::segment s(shm::anonymous_segment, bytes, o);
+    auto* p = static_cast<unsigned char*>(s.data());
+    for (std::size_t i = 0; i < bytes; i += kPage) p[i] = static_cast<unsigned char>(i);
+
+    std::printf("%-16s %12s %12s %12s\n", "advice", "advise ms", "scan ms", "total ms");
+    for (const row& r : kRows) {
+        double best_advise = 1e300;
+        double best_scan = 1e300;
+        for (int rep = 0; rep < kReps; ++rep) {
+            (void)s.advise(shm::advice::dontneed);
+
+            auto t0 = std::chrono::steady_clock::now();
+            if (r.apply && s.advise(r.a)) {
+                best_advise = -1;
+                break;
+            }
+            best_advise = std::min(best_advise, ms_since(t0));
+
+            t0 = std::chrono::steady_clock::now();
+            unsigned sum = 0;
+            for (std::size_t i = 0; i < bytes; i += kPage) sum += p[i];
+            bench::do_not_optimize(sum);
+            best_scan = std::min(best_scan, ms_since(t0));
+        }
+        if (best_advise < 0) {
+            std::printf("%-16s %12s\n", r.label, "unsupported");
+            continue;
+        }
+        std::printf("%-16s %12.3f %12.3f %12.3f\n", r.label, best_advise, best_scan, best_advise + best_scan);
+        (void)s.advise(shm::advice::normal);
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    return 0;
+}
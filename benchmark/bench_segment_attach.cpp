@@ -0,0 +1,68 @@
+// Attach latency of shm::segment with and without the readiness header.
+//
+//   bench_segment_attach [bytes]
+//
+// "attach" opens an existing, ready segment. "wake" measures the time from
+// the creator's mark_ready() to a blocked opener's constructor returning.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+
+double wake_latency_us(const char* name, std::size_t bytes) {
+    (void)shm::segment::remove(name);
+    shm::segment_options opts;
+    opts.header = true;
+    opts.defer_ready = true;
+    shm::segment creator(name, bytes, shm::segment::open_mode::create_only, opts);
+
+    std::atomic<bool> started{false};
+    std::chrono::steady_clock::time_point returned;
+    std::thread opener([&] {
+        shm::segment_options o;
+        o.header = true;
+        started.store(true);
+        shm::segment seg(name, 0, shm::segment::open_mode::open_only, o);
+        returned = std::chrono::steady_clock::now();
+    });
+    while (!started.load()) std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));  // let it block
+
+    const auto t0 = std::chrono::steady_clock::now();
+    creator.mark_ready();
+    opener.join();
+    (void)shm::segment::remove(name);
+    return std::chrono::duration<double, std::micro>(returned - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+    const std::string name = "/shm_bench_attach";
+
+    for (bool header : {false, true}) {
+        (void)shm::segment::remove(name.c_str());
+        shm::segment_options opts;
+        opts.header = header;
+        shm::segment creator(name.c_str(), bytes, shm::segment::open_mode::create_only, opts);
+
+        const double ns = bench::best_ns_per_op(50, 1, [&] {
+            shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only, opts);
+            bench::do_not_optimize(seg.data());
+        });
+        bench::report(header ? "attach (header)" : "attach (no header)", ns);
+        (void)shm::segment::remove(name.c_str());
+    }
+
+    double best = 1e300;
+    for (int i = 0; i < 5; ++i) best = std::min(best, wake_latency_us(name.c_str(), bytes));
+    std::printf("%-48s %10.3f us\n", "mark_ready -> opener returns", best);
+    return 0;
+}
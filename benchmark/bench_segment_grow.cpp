@@ -0,0 +1,52 @@
+// Cost of the grow/refresh protocol.
+//
+//   bench_segment_grow [initial_bytes] [steps]
+//
+// "stale()" is the per-check cost an attached process pays to notice a
+// grow; "grow" is ftruncate + header publish + mremap in the grower;
+// "refresh" is the lazy remap in a second attachment. Steps double the size.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    const std::size_t initial = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+    const char* name = "/shm_bench_grow";
+
+    shm::segment_options o;
+    o.header = true;
+    (void)shm::segment::remove(name);
+    shm::segment grower(name, initial, shm::segment::open_mode::create_only, o);
+    shm::segment reader(name, 0, shm::segment::open_mode::open_only, o);
+
+    bench::report("stale()", bench::best_ns_per_op(5, 1 << 20, [&] {
+        bool any = false;
+        for (int i = 0; i < (1 << 20); ++i) any |= reader.stale();
+        bench::do_not_optimize(any);
+    }));
+
+#if !defined(_WIN32)
+    const std::size_t steps = bench::arg_or(argc, argv, 2, 8);
+    using clock = std::chrono::steady_clock;
+    std::printf("%-14s %12s %12s\n", "bytes", "grow us", "refresh us");
+    for (std::size_t i = 0, size = initial * 2; i < steps; ++i, size *= 2) {
+        // Touch the current mapping so the remap has populated pages to carry.
+        std::memset(grower.data(), 1, grower.data_size());
+
+        const auto t0 = clock::now();
+        grower.grow(size);
+        const auto t1 = clock::now();
+        (void)reader.refresh();
+        const auto t2 = clock::now();
+        std::printf("%-14zu %12.2f %12.2f\n", size,
+                    std::chrono::duration<double, std::micro>(t1 - t0).count(),
+                    std::chrono::duration<double, std::micro>(t2 - t1).count());
+    }
+#endif
+    (void)shm::segment::remove(name);
+    return 0;
+}
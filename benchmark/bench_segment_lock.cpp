@@ -0,0 +1,68 @@
+// Cost of pinning a segment and of checking its residency.
+//
+//   bench_segment_lock [bytes]
+//
+// "lock now" faults in and pins the whole range; "lock on_fault" only
+// marks it. "touch" writes one byte per page afterwards, so lock now +
+// touch vs on_fault + touch shows where each mode pays for the faults.
+// "residency" is one mincore scan of the range. Locking needs
+// RLIMIT_MEMLOCK headroom (or CAP_IPC_LOCK); refused locks are reported.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+#if !defined(_WIN32)
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{256} << 20);
+    constexpr std::size_t kPage = 4096;
+
+    shm::segment_options o;
+    o.pages = shm::page_policy::thp_never;
+
+    std::printf("%-14s %12s %12s %14s\n", "mode", "lock ms", "touch ms", "residency ms");
+    for (shm::lock_mode mode : {shm::lock_mode::none, shm::lock_mode::now, shm::lock_mode::on_fault}) {
+        shm::segment s(shm::anonymous_segment, bytes, o);
+
+        auto t0 = std::chrono::steady_clock::now();
+        const std::error_code ec = (mode == shm::lock_mode::none) ? std::error_code{} : s.lock(mode);
+        const double lock_ms = ms_since(t0);
+        const char* label = mode == shm::lock_mode::none ? "unlocked"
+                          : mode == shm::lock_mode::now  ? "lock now"
+                                                         : "lock on_fault";
+        if (ec) {
+            std::printf("%-14s refused: %s\n", label, ec.message().c_str());
+            continue;
+        }
+
+        t0 = std::chrono::steady_clock::now();
+        auto* p = static_cast<unsigned char*>(s.data());
+        for (std::size_t i = 0; i < bytes; i += kPage) p[i] = 1;
+        bench::clobber();
+        const double touch_ms = ms_since(t0);
+
+        shm::residency_report r;
+        t0 = std::chrono::steady_clock::now();
+        (void)s.residency(r);
+        const double res_ms = ms_since(t0);
+        bench::do_not_optimize(r.resident);
+
+        std::printf("%-14s %12.3f %12.3f %14.3f\n", label, lock_ms, touch_ms, res_ms);
+        (void)s.unlock();
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    return 0;
+}
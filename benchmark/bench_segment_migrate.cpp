@@ -0,0 +1,77 @@
+// Online migration of a live shm::segment by size, with and without a
+// concurrent writer.
+//
+//   bench_segment_migrate [max_bytes] [copy_threads]
+//
+// "total" is the whole migrate_segment() call; "pause" is the window in
+// which new write sections were held off. With a writer running, "recopied"
+// is the dirty volume copied again by the pre-copy rounds and the final
+// delta. The writer dirties uniformly random words, the worst case for
+// pre-copy convergence.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t max_bytes = bench::arg_or(argc, argv, 1, std::size_t{256} << 20);
+    const unsigned threads = static_cast<unsigned>(bench::arg_or(argc, argv, 2, std::size_t{0}));
+    const std::string src_name = "/shm_bench_migrate";
+    const std::string dst_name = "/shm_bench_migrate_dst";
+
+    shm::segment_options o;
+    o.header = true;
+    shm::migrate_options mo;
+    mo.threads = threads;
+
+    std::printf("%-12s %-8s %12s %12s %14s %7s\n", "bytes", "writer", "total ms", "pause us", "recopied", "rounds");
+    for (std::size_t bytes = std::size_t{16} << 20; bytes <= max_bytes; bytes *= 4) {
+        for (bool with_writer : {false, true}) {
+            (void)shm::segment::remove(src_name.c_str());
+            (void)shm::segment::remove(dst_name.c_str());
+            shm::segment s(src_name.c_str(), bytes, shm::segment::open_mode::create_only, o);
+            auto* words = static_cast<std::uint64_t*>(s.data());
+            const std::size_t n = bytes / sizeof(std::uint64_t);
+            for (std::size_t i = 0; i < n; i += 512) words[i] = i;
+
+            std::thread writer;
+            if (with_writer) {
+                writer = std::thread([&] {
+                    bench::rng r{42};
+                    for (;;) {
+                        shm::write_section ws(s);
+                        if (!ws) break;
+                        const std::size_t i = r.next() % n;
+                        words[i] = i;
+                        ws.note(i * sizeof(std::uint64_t), sizeof(std::uint64_t));
+                    }
+                });
+            }
+
+            shm::migrate_stats st;
+            const auto t0 = std::chrono::steady_clock::now();
+            auto dst = shm::migrate_segment(s, dst_name.c_str(), bytes, o, mo, &st);
+            const double total = ms_since(t0);
+            if (writer.joinable()) writer.join();
+            bench::do_not_optimize(dst->data());
+
+            std::printf("%-12zu %-8s %12.3f %12.1f %14zu %7u\n", bytes, with_writer ? "yes" : "no", total,
+                        static_cast<double>(st.pause_ns) / 1e3, st.recopied_bytes, st.rounds);
+        }
+    }
+    (void)shm::segment::remove(src_name.c_str());
+    (void)shm::segment::remove(dst_name.c_str());
+    return 0;
+}
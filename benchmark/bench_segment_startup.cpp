@@ -0,0 +1,72 @@
+// Time-to-ready of a freshly created shm::segment by size, for each zeroing
+// and prefault strategy.
+//
+//   bench_segment_startup [max_bytes] [prefault_threads]
+//
+// "create" is the constructor alone. "create+write" adds one write per page,
+// i.e. the point at which every page is usable without further faults; the
+// difference between the two shows where each strategy moves the cost.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+struct strategy {
+    const char* label;
+    shm::zero_mode zero;
+    shm::prefault_mode prefault;
+};
+
+constexpr strategy kStrategies[] = {
+    {"memset",          shm::zero_mode::memset, shm::prefault_mode::none},
+    {"none",            shm::zero_mode::none,   shm::prefault_mode::none},
+    {"lazy",            shm::zero_mode::lazy,   shm::prefault_mode::none},
+    {"none + populate", shm::zero_mode::none,   shm::prefault_mode::populate},
+    {"none + touch",    shm::zero_mode::none,   shm::prefault_mode::touch},
+};
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t max_bytes = bench::arg_or(argc, argv, 1, std::size_t{1} << 30);
+    const unsigned threads = static_cast<unsigned>(bench::arg_or(argc, argv, 2, std::size_t{0}));
+    const std::string name = "/shm_bench_startup";
+    constexpr std::size_t kPage = 4096;
+    constexpr int kReps = 3;
+
+    std::printf("%-12s %-18s %14s %16s\n", "bytes", "strategy", "create ms", "create+write ms");
+    for (std::size_t bytes = std::size_t{16} << 20; bytes <= max_bytes; bytes *= 4) {
+        for (const strategy& st : kStrategies) {
+            shm::segment_options o;
+            o.zero = st.zero;
+            o.prefault = st.prefault;
+            o.prefault_threads = threads;
+
+            double best_create = 1e300;
+            double best_ready = 1e300;
+            for (int r = 0; r < kReps; ++r) {
+                (void)shm::segment::remove(name.c_str());
+                const auto t0 = std::chrono::steady_clock::now();
+                shm::segment s(name.c_str(), bytes, shm::segment::open_mode::create_only, o);
+                best_create = std::min(best_create, ms_since(t0));
+
+                auto* p = static_cast<unsigned char*>(s.data());
+                for (std::size_t i = 0; i < bytes; i += kPage) p[i] = 1;
+                bench::clobber();
+                best_ready = std::min(best_ready, ms_since(t0));
+            }
+            std::printf("%-12zu %-18s %14.3f %16.3f\n", bytes, st.label, best_create, best_ready);
+        }
+    }
+    (void)shm::segment::remove(name.c_str());
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Cost of a tiering sample, and what tiering does to a history segment with
+// a hot tail.
+//
+//   bench_segment_tiering [bytes] [chunk_bytes]
+//
+// "sample" is one tier_step() over the whole segment (mincore only, the
+// default). "sample, soft-dirty" opts in to the pagemap reads and the
+// process-wide clear_refs reset, where the kernel supports them. The
+// second part appends to a log that fills the segment, rereads the most
+// recent 1/16 of it between samples, and reports how much history was
+// demoted and how much of that came back.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+  #include <unistd.h>
+#endif
+
+int main(int argc, char** argv) {
+#if !defined(_WIN32)
+    const std::size_t bytes = bench::arg_or(argc, argv, 1, std::size_t{256} << 20);
+    const std::size_t chunk = bench::arg_or(argc, argv, 2, std::size_t{2} << 20);
+    const std::size_t kPage = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    shm::segment_options o;
+    o.pages = shm::page_policy::thp_never;
+    shm::segment s(shm::anonymous_segment, bytes, o);
+    auto* p = static_cast<unsigned char*>(s.data());
+    for (std::size_t i = 0; i < bytes; i += kPage) p[i] = 1;
+
+    shm::tiering_options t;
+    t.interval_ms = 0;
+    t.chunk_bytes = chunk;
+    t.idle_samples = 1u << 30;   // measure sampling only
+    s.start_tiering(t);
+    bench::report("sample (per chunk)", bench::best_ns_per_op(20, bytes / chunk, [&] { (void)s.tier_step(); }));
+    s.stop_tiering();
+
+    t.soft_dirty = true;
+    s.start_tiering(t);
+    if (s.tier_stats().soft_dirty) {
+        bench::report("sample, soft-dirty (per chunk)",
+                      bench::best_ns_per_op(20, bytes / chunk, [&] { (void)s.tier_step(); }));
+    } else {
+        std::printf("soft-dirty tracking: not available\n");
+    }
+    s.stop_tiering();
+    t.soft_dirty = false;
+
+    shm::segment log(shm::anonymous_segment, bytes, o);
+    auto* q = static_cast<unsigned char*>(log.data());
+    t.idle_samples = 4;
+    t.demote = shm::advice::pageout;
+    log.start_tiering(t);
+    constexpr std::size_t kSteps = 64;
+    const std::size_t step = bytes / kSteps;
+    const std::size_t window = bytes / 16;
+    unsigned sum = 0;
+    for (std::size_t k = 1; k <= kSteps; ++k) {
+        std::memset(q + (k - 1) * step, static_cast<int>(k), step);
+        const std::size_t head = k * step;
+        const std::size_t from = head > window ? head - window : 0;
+        for (std::size_t i = from; i < head; i += kPage) sum += q[i];
+        (void)log.tier_step();
+    }
+    bench::do_not_optimize(sum);
+    const shm::tiering_stats st = log.tier_stats();
+    std::printf("log: samples %llu, demoted %llu MiB, refaulted %llu MiB, cold %llu MiB of %zu MiB\n",
+                static_cast<unsigned long long>(st.samples),
+                static_cast<unsigned long long>(st.demoted_bytes >> 20),
+                static_cast<unsigned long long>(st.refaulted_bytes >> 20),
+                static_cast<unsigned long long>(st.cold_bytes >> 20), bytes >> 20);
+#else
+    (void)argc;
+    (void)argv;
+#endif
+    return 0;
+}
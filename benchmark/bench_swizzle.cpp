@@ -0,0 +1,91 @@
+// Read passes over a swizzled copy against passes over the segment form.
+//
+//   bench_swizzle [nodes]
+//
+// A random binary tree is stored with segment_offset_ptr links. Each pass is
+// an iterative depth-first sum. The one-off swizzle() cost is reported next
+// to the per-pass times so the break-even number of passes can be read off.
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+struct SegTag {};
+
+struct TreeNode {
+    std::uint64_t value;
+    shm::segment_offset_ptr<TreeNode, SegTag> left;
+    shm::segment_offset_ptr<TreeNode, SegTag> right;
+};
+
+} // namespace
+
+template <>
+struct shm::link_fields<TreeNode> {
+    static constexpr auto value = std::make_tuple(&TreeNode::left, &TreeNode::right);
+};
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 20);
+
+    bench::aligned_buffer buf(n * sizeof(TreeNode));
+    std::memset(buf.p, 0, buf.n);
+    shm::segment_base<SegTag>::set(buf.p);
+    auto* nodes = reinterpret_cast<TreeNode*>(buf.p);
+
+    // Heap-shaped tree over a random placement: node i's children are 2i+1, 2i+2.
+    const auto place = bench::random_cycle(n, 3);
+    for (std::size_t i = 0; i < n; ++i) {
+        TreeNode* t = ::new (&nodes[place[i]]) TreeNode{};
+        t->value = i;
+        if (2 * i + 1 < n) t->left = &nodes[place[2 * i + 1]];
+        if (2 * i + 2 < n) t->right = &nodes[place[2 * i + 2]];
+    }
+    TreeNode* root = &nodes[place[0]];
+
+    std::vector<const void*> stack;
+    stack.reserve(64);
+
+    const double seg_pass = bench::best_ns_per_op(5, n, [&] {
+        std::uint64_t sum = 0;
+        stack.assign(1, root);
+        while (!stack.empty()) {
+            auto* t = static_cast<const TreeNode*>(stack.back());
+            stack.pop_back();
+            sum += t->value;
+            if (t->right) stack.push_back(t->right.get());
+            if (t->left) stack.push_back(t->left.get());
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    const auto t0 = std::chrono::steady_clock::now();
+    auto g = shm::swizzle(root);
+    const auto t1 = std::chrono::steady_clock::now();
+    const double swizzle_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(n);
+
+    using SN = shm::swizzled_node<TreeNode>;
+    const double raw_pass = bench::best_ns_per_op(5, n, [&] {
+        std::uint64_t sum = 0;
+        stack.assign(1, g.root());
+        while (!stack.empty()) {
+            auto* t = static_cast<const SN*>(stack.back());
+            stack.pop_back();
+            sum += t->value.value;
+            if (t->links[1]) stack.push_back(t->links[1]);
+            if (t->links[0]) stack.push_back(t->links[0]);
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    std::printf("nodes=%zu\n", n);
+    bench::report("segment form, per node per pass", seg_pass);
+    bench::report("swizzled form, per node per pass", raw_pass);
+    bench::report("swizzle(), per node (once)", swizzle_ns);
+    return 0;
+}
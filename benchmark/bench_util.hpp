@@ -0,0 +1,92 @@
+#pragma once
+
+// Minimal timing helpers shared by the benchmark programs. The programs are
+// self-contained executables; results are printed as ns per operation.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace bench {
+
+template <class T>
+inline void do_not_optimize(const T& v) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(v) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &v;
+#endif
+}
+
+inline void clobber() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// Runs fn() `reps` times and returns the best observed ns per op, where fn
+// performs `ops` operations per call.
+template <class Fn>
+double best_ns_per_op(std::size_t reps, std::size_t ops, Fn&& fn) {
+    double best = 1e300;
+    for (std::size_t r = 0; r < reps; ++r) {
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        const auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        best = std::min(best, ns / static_cast<double>(ops ? ops : 1));
+    }
+    return best;
+}
+
+inline void report(const char* name, double ns_per_op) {
+    std::printf("%-48s %10.3f ns/op\n", name, ns_per_op);
+}
+
+// xorshift64*: deterministic, good enough for shuffles.
+struct rng {
+    std::uint64_t s;
+    explicit rng(std::uint64_t seed) noexcept : s(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+    std::uint64_t next() noexcept {
+        s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+        return s * 0x2545F4914F6CDD1Dull;
+    }
+};
+
+inline std::vector<std::size_t> random_cycle(std::size_t n, std::uint64_t seed) {
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i) order[i] = i;
+    rng r(seed);
+    for (std::size_t i = n; i > 1; --i) {
+        const std::size_t j = static_cast<std::size_t>(r.next() % i);
+        std::swap(order[i - 1], order[j]);
+    }
+    return order;
+}
+
+struct aligned_buffer {
+    std::byte* p = nullptr;
+    std::size_t n = 0;
+
+    explicit aligned_buffer(std::size_t bytes, std::size_t align = 4096)
+        : p(static_cast<std::byte*>(::operator new(bytes, std::align_val_t(align)))), n(bytes), a(align) {}
+    ~aligned_buffer() { ::operator delete(p, std::align_val_t(a)); }
+    aligned_buffer(const aligned_buffer&) = delete;
+    aligned_buffer& operator=(const aligned_buffer&) = delete;
+
+private:
+    std::size_t a;
+};
+
+inline std::size_t arg_or(int argc, char** argv, int i, std::size_t dflt) {
+    if (argc > i) return static_cast<std::size_t>(std::strtoull(argv[i], nullptr, 10));
+    return dflt;
+}
+
+} // namespace bench
@@ -0,0 +1,85 @@
+// verify_graph throughput, reported per MiB of verified objects.
+//
+//   bench_verify_graph [nodes]
+//
+// A random binary tree of 64-byte nodes (segment_offset_ptr links) placed in
+// random order, verified with cycle detection on and off. For scale, the
+// same tree is also summed once with unchecked get().
+
+#include "shmTypes.hpp"
+#include "bench_util.hpp"
+
+#include <cstring>
+#include <tuple>
+
+namespace {
+
+struct SegTag {};
+
+struct Node {
+    std::uint64_t value;
+    shm::segment_offset_ptr<Node, SegTag> left;
+    shm::segment_offset_ptr<Node, SegTag> right;
+    std::uint32_t pad[12];
+};
+static_assert(sizeof(Node) == 64);
+
+} // namespace
+
+template <>
+struct shm::link_fields<Node> {
+    static constexpr auto value = std::make_tuple(&Node::left, &Node::right);
+};
+
+int main(int argc, char** argv) {
+    const std::size_t n = bench::arg_or(argc, argv, 1, std::size_t{1} << 18);
+
+    bench::aligned_buffer buf(n * sizeof(Node));
+    std::memset(buf.p, 0, buf.n);
+    shm::segment_base<SegTag>::set(buf.p);
+    auto* nodes = reinterpret_cast<Node*>(buf.p);
+    const auto place = bench::random_cycle(n, 9);
+    for (std::size_t i = 0; i < n; ++i) {
+        Node* t = ::new (&nodes[place[i]]) Node{};
+        t->value = i;
+        if (2 * i + 1 < n) t->left = &nodes[place[2 * i + 1]];
+        if (2 * i + 2 < n) t->right = &nodes[place[2 * i + 2]];
+    }
+    const Node* root = &nodes[place[0]];
+    const double mib = static_cast<double>(n * sizeof(Node)) / (1024.0 * 1024.0);
+
+    shm::verify_result last;
+    const double acyclic = bench::best_ns_per_op(3, 1, [&] {
+        last = shm::verify_graph(buf.p, buf.n, root);
+    });
+    if (!last || last.objects != n) {
+        std::printf("verify failed\n");
+        return 1;
+    }
+
+    shm::verify_options allow;
+    allow.allow_cycles = true;
+    const double cyclic = bench::best_ns_per_op(3, 1, [&] {
+        last = shm::verify_graph(buf.p, buf.n, root, allow);
+    });
+
+    std::vector<const Node*> stack;
+    const double walk = bench::best_ns_per_op(3, 1, [&] {
+        std::uint64_t sum = 0;
+        stack.assign(1, root);
+        while (!stack.empty()) {
+            const Node* t = stack.back();
+            stack.pop_back();
+            sum += t->value;
+            if (t->right) stack.push_back(t->right.get());
+            if (t->left) stack.push_back(t->left.get());
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    std::printf("nodes=%zu (%.1f MiB)\n", n, mib);
+    std::printf("%-40s %10.3f ms/MiB\n", "verify_graph (acyclic)", acyclic / 1e6 / mib);
+    std::printf("%-40s %10.3f ms/MiB\n", "verify_graph (allow_cycles)", cyclic / 1e6 / mib);
+    std::printf("%-40s %10.3f ms/MiB\n", "unchecked depth-first sum", walk / 1e6 / mib);
+    return 0;
+}
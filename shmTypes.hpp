@@ -15,29 +15,49 @@
   #endif
 #endif
 
+#include <algorithm>
 #include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <type_traits>
 #include <atomic>
+#include <memory>
 #include <new>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <iterator>
 #include <utility>
 #include <cstring>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <stdexcept>
 
 
 #if !SHM_PLATFORM_WIN32
   #include <cerrno>
+  #include <cstdio>
   #include <fcntl.h>
+  #include <signal.h>
   #include <sys/mman.h>
+  #include <sys/socket.h>
   #include <sys/stat.h>
   #include <sys/types.h>
+  #include <sys/uio.h>
   #include <time.h>
   #include <unistd.h>
+  #if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <sys/vfs.h>
+  #endif
 #else
   #ifndef NOMINMAX
     #define NOMINMAX
@@ -87,6 +107,46 @@
   #define SHM_ASSERT(x) ((void)0)
 #endif
 
+// Batch offset codecs (decode_n / encode_n) pick the widest instruction set
+// the translation unit is compiled for. Define SHM_DISABLE_SIMD to force the
+// scalar path.
+#if !defined(SHM_DISABLE_SIMD) && (UINTPTR_MAX == UINT64_MAX)
+  #if defined(__AVX512F__)
+    #define SHM_SIMD_AVX512 1
+  #endif
+  #if defined(__AVX2__)
+    #define SHM_SIMD_AVX2 1
+  #endif
+  #if defined(__ARM_NEON) || defined(_M_ARM64)
+    #define SHM_SIMD_NEON 1
+  #endif
+#endif
+
+#if defined(SHM_SIMD_AVX512) || defined(SHM_SIMD_AVX2)
+  #include <immintrin.h>
+#endif
+#if defined(SHM_SIMD_NEON)
+  #include <arm_neon.h>
+#endif
+
+// Read prefetch into all cache levels. Never faults, so it may be given a
+// null or stale address.
+#if defined(__GNUC__) || defined(__clang__)
+  #define SHM_PREFETCH(p) __builtin_prefetch(static_cast<const void*>(p), 0, 3)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <xmmintrin.h>
+  #define SHM_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+  #include <intrin.h>
+  #define SHM_PREFETCH(p) __prefetch(static_cast<const void*>(p))
+#else
+  #define SHM_PREFETCH(p) ((void)(p))
+#endif
+
+#ifndef SHM_SEGMENT_TABLE_CAPACITY
+  #define SHM_SEGMENT_TABLE_CAPACITY 256
+#endif
+
 #if SHM_PLATFORM_WIN32
 
   #ifndef SHM_WIN32_OBJECT_NAMESPACE
@@ -159,6 +219,86 @@ private:
     inline static std::byte* base_ = nullptr;
 };
 
+using segment_id = std::uint16_t;
+
+// Process-local id -> base table for pointers that span several mappings.
+// Each slot keeps (base - 1) so that fat_offset_ptr decodes with one load
+// and one add. Like segment_base<Tag>, this is per-process state and is not
+// synchronized; populate a slot before any thread decodes through it. Ids at
+// or above capacity are rejected at run time: set() fails, and lookups
+// behave as for an empty slot.
+struct segment_table {
+    static constexpr std::size_t capacity = SHM_SEGMENT_TABLE_CAPACITY;
+    static_assert(capacity > 0 && capacity <= (std::size_t{1} << 16),
+                  "SHM_SEGMENT_TABLE_CAPACITY must fit a 16-bit segment_id.");
+
+    [[nodiscard]] static SHM_FORCE_INLINE bool valid(segment_id id) noexcept {
+        if constexpr (capacity == (std::size_t{1} << 16)) {
+            (void)id;
+            return true;
+        } else {
+            return id < capacity;
+        }
+    }
+
+    // Returns false, leaving the table untouched, for an out-of-range id or
+    // a null base.
+    static bool set(segment_id id, void* base, std::size_t size) noexcept {
+        if (!valid(id) || !base) return false;
+        base_m1_[id] = detail::addr(base) - 1;
+        size_[id] = size;
+        return true;
+    }
+
+    static void clear(segment_id id) noexcept {
+        if (!valid(id)) return;
+        base_m1_[id] = 0;
+        size_[id] = 0;
+    }
+
+    // Clears the slot only while it still maps `base`, so an owner that has
+    // been displaced by a later set() does not unregister the new mapping.
+    static bool clear(segment_id id, const void* base) noexcept {
+        if (!valid(id) || size_[id] == 0 || base_m1_[id] + 1 != detail::addr(base)) return false;
+        clear(id);
+        return true;
+    }
+
+    [[nodiscard]] static SHM_FORCE_INLINE std::byte* base(segment_id id) noexcept {
+        if (!valid(id)) return nullptr;
+        return size_[id] ? reinterpret_cast<std::byte*>(base_m1_[id] + 1) : nullptr;
+    }
+
+    [[nodiscard]] static SHM_FORCE_INLINE std::size_t size(segment_id id) noexcept {
+        return valid(id) ? size_[id] : 0;
+    }
+
+    // (base - 1), or 0 for an empty slot (a mapped base is never 1).
+    // Unchecked; callers test valid(id) first.
+    [[nodiscard]] static SHM_FORCE_INLINE detail::uptr base_minus_one(segment_id id) noexcept {
+        SHM_ASSERT(valid(id));
+        return base_m1_[id];
+    }
+
+    // Linear scan; intended for encoding paths, not for decoding.
+    [[nodiscard]] static bool find(const void* p, segment_id& id) noexcept {
+        const detail::uptr a = detail::addr(p);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            if (size_[i] == 0) continue;
+            const detail::uptr b = base_m1_[i] + 1;
+            if (a >= b && a - b < size_[i]) {
+                id = static_cast<segment_id>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    inline static detail::uptr base_m1_[capacity] = {};
+    inline static std::size_t size_[capacity] = {};
+};
+
 struct self_anchor {
     static constexpr bool kSelfRelative = true;
     static SHM_FORCE_INLINE detail::uptr base(const void* self) noexcept {
@@ -184,6 +324,58 @@ struct segment_anchor {
     }
 };
 
+// Per-thread counterpart of segment_base<Tag>: each thread sees its own base,
+// so threads can work on different segments that share one layout (and one
+// Tag) while still decoding with a single load.
+template <class Tag>
+struct thread_segment_base {
+    static SHM_FORCE_INLINE void set(void* base) noexcept {
+        base_ = static_cast<std::byte*>(base);
+    }
+    static SHM_FORCE_INLINE std::byte* get() noexcept { return base_; }
+
+private:
+    inline static thread_local std::byte* base_ = nullptr;
+};
+
+template <class Tag>
+struct thread_anchor {
+    static constexpr bool kSelfRelative = false;
+    static SHM_FORCE_INLINE detail::uptr base(const void*) noexcept {
+        auto* b = thread_segment_base<Tag>::get();
+        SHM_ASSERT(b && "thread_segment_base<Tag>::set(mapped_base) must be called on this thread before use.");
+        return detail::addr(b);
+    }
+};
+
+// Base known at compile time. Use it when the segment is always mapped at
+// `Base` (see segment_options::fixed_address): decode folds into an
+// immediate or an addressing mode and needs no load.
+template <detail::uptr Base>
+struct fixed_anchor {
+    static constexpr bool kSelfRelative = false;
+    static constexpr detail::uptr kBase = Base;
+    static SHM_FORCE_INLINE constexpr detail::uptr base(const void*) noexcept { return Base; }
+};
+
+// Binds thread_segment_base<Tag> for the current thread and restores the
+// previous binding on destruction, so bindings nest.
+template <class Tag>
+class scoped_thread_base {
+public:
+    explicit scoped_thread_base(void* base) noexcept
+        : prev_(thread_segment_base<Tag>::get()) {
+        thread_segment_base<Tag>::set(base);
+    }
+    ~scoped_thread_base() { thread_segment_base<Tag>::set(prev_); }
+
+    scoped_thread_base(const scoped_thread_base&) = delete;
+    scoped_thread_base& operator=(const scoped_thread_base&) = delete;
+
+private:
+    std::byte* prev_;
+};
+
 template <class T, class Anchor = self_anchor, detail::offset_int OffsetT = std::int32_t>
 class offset_ptr {
 public:
@@ -232,6 +424,9 @@ public:
 
     [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage() const noexcept { return off_plus1_; }
 
+    // Starts loading the referent into cache; see SHM_PREFETCH.
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(get()); }
+
     [[nodiscard]] SHM_FORCE_INLINE explicit operator bool() const noexcept { return off_plus1_ != 0; }
 
     template <class U = T>
@@ -356,8 +551,12 @@ private:
     offset_type off_plus1_ = 0;
 };
 
-template <class T, class Tag, detail::offset_int OffsetT>
-class offset_ptr<T, segment_anchor<Tag>, OffsetT> {
+// Detached anchors (segment_anchor, thread_anchor, ...) keep the base outside
+// the pointer, so the stored offset does not depend on where the field lives
+// and copies are bitwise.
+template <class T, class Anchor, detail::offset_int OffsetT>
+requires (!Anchor::kSelfRelative)
+class offset_ptr<T, Anchor, OffsetT> {
 public:
     using element_type = T;
     using pointer      = T*;
@@ -365,7 +564,7 @@ public:
     using offset_type  = OffsetT;
 
     using difference_type = std::ptrdiff_t;
-    template <class U> using rebind = offset_ptr<U, segment_anchor<Tag>, OffsetT>;
+    template <class U> using rebind = offset_ptr<U, Anchor, OffsetT>;
 
     static_assert(detail::is_obj_or_void_v<T>,
                   "offset_ptr<T>: T must be an object type or void.");
@@ -382,7 +581,7 @@ public:
 
     template <class U>
     requires (std::is_convertible_v<U*, T*>)
-    SHM_FORCE_INLINE offset_ptr(const offset_ptr<U, segment_anchor<Tag>, OffsetT>& other) noexcept
+    SHM_FORCE_INLINE offset_ptr(const offset_ptr<U, Anchor, OffsetT>& other) noexcept
         : off_plus1_(other.raw_storage()) {}
 
     SHM_FORCE_INLINE offset_ptr& operator=(pointer p) noexcept { set(p); return *this; }
@@ -392,7 +591,7 @@ public:
         const offset_type s = off_plus1_;
         if (SHM_UNLIKELY(s == 0)) return nullptr;
 
-        const detail::uptr b = segment_anchor<Tag>::base(nullptr);
+        const detail::uptr b = Anchor::base(nullptr);
 
         if constexpr (std::is_signed_v<offset_type>) {
             const detail::iptr off = static_cast<detail::iptr>(s) - 1;
@@ -404,6 +603,8 @@ public:
     }
 
     [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage() const noexcept { return off_plus1_; }
+
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(get()); }
     [[nodiscard]] SHM_FORCE_INLINE explicit operator bool() const noexcept { return off_plus1_ != 0; }
 
     template <class U = T>
@@ -430,22 +631,24 @@ public:
     requires (!std::is_void_v<U>)
     SHM_FORCE_INLINE offset_ptr operator--(int) noexcept { offset_ptr tmp(*this); --(*this); return tmp; }
 
+    // The base is shared by every pointer with this anchor, so arithmetic and
+    // comparisons work on the stored offsets directly. As with raw pointers,
+    // arithmetic on null is undefined.
     template <class U = T>
     requires (!std::is_void_v<U>)
     SHM_FORCE_INLINE offset_ptr& operator+=(difference_type n) noexcept {
-        pointer p = get();
-        p += n;
-        *this = offset_ptr(p);
+        SHM_ASSERT(off_plus1_ != 0 && "arithmetic on a null offset_ptr.");
+        const detail::iptr next = static_cast<detail::iptr>(off_plus1_)
+                                + n * static_cast<difference_type>(sizeof(U));
+        SHM_ASSERT(next != 0 && "offset_ptr arithmetic produced the null encoding.");
+        off_plus1_ = detail::narrow_checked<offset_type>(next);
         return *this;
     }
 
     template <class U = T>
     requires (!std::is_void_v<U>)
     SHM_FORCE_INLINE offset_ptr& operator-=(difference_type n) noexcept {
-        pointer p = get();
-        p -= n;
-        *this = offset_ptr(p);
-        return *this;
+        return *this += -n;
     }
 
     template <class U = T>
@@ -467,7 +670,8 @@ public:
     template <class U = T>
     requires (!std::is_void_v<U>)
     [[nodiscard]] SHM_FORCE_INLINE difference_type operator-(const offset_ptr& other) const noexcept {
-        return get() - other.get();
+        const detail::iptr bytes = static_cast<detail::iptr>(off_plus1_) - static_cast<detail::iptr>(other.off_plus1_);
+        return bytes / static_cast<difference_type>(sizeof(U));
     }
 
     template <class U = T>
@@ -482,7 +686,12 @@ public:
         return offset_ptr(&r);
     }
 
-    [[nodiscard]] friend SHM_FORCE_INLINE bool operator<(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() < b.get(); }
+    // Unsigned offsets order exactly like addresses, null (0) first. Signed
+    // offsets put null in the middle of the range, so they compare decoded.
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator<(const offset_ptr& a, const offset_ptr& b) noexcept {
+        if constexpr (std::is_unsigned_v<offset_type>) return a.off_plus1_ < b.off_plus1_;
+        else return a.get() < b.get();
+    }
     [[nodiscard]] friend SHM_FORCE_INLINE bool operator>(const offset_ptr& a, const offset_ptr& b) noexcept { return b < a; }
     [[nodiscard]] friend SHM_FORCE_INLINE bool operator<=(const offset_ptr& a, const offset_ptr& b) noexcept { return !(b < a); }
     [[nodiscard]] friend SHM_FORCE_INLINE bool operator>=(const offset_ptr& a, const offset_ptr& b) noexcept { return !(a < b); }
@@ -498,7 +707,7 @@ private:
     SHM_FORCE_INLINE void set(pointer p) noexcept {
         if (!p) { off_plus1_ = 0; return; }
 
-        const detail::uptr b = segment_anchor<Tag>::base(nullptr);
+        const detail::uptr b = Anchor::base(nullptr);
         const detail::uptr t = detail::addr(p);
         const detail::iptr diff = static_cast<detail::iptr>(t) - static_cast<detail::iptr>(b);
 
@@ -564,6 +773,8 @@ public:
     }
 
     [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage() const noexcept { return off_plus1_; }
+
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(get()); }
     [[nodiscard]] SHM_FORCE_INLINE explicit operator bool() const noexcept { return off_plus1_ != 0; }
 
     template <class U = T>
@@ -702,6 +913,10 @@ private:
 
 template <class T, class Tag, detail::offset_int OffsetT = std::uint32_t>
 using segment_offset_ptr = offset_ptr<T, segment_anchor<Tag>, OffsetT>;
+template <class T, class Tag, detail::offset_int OffsetT = std::uint32_t>
+using thread_offset_ptr = offset_ptr<T, thread_anchor<Tag>, OffsetT>;
+template <class T, detail::uptr Base, detail::offset_int OffsetT = std::uint32_t>
+using fixed_offset_ptr = offset_ptr<T, fixed_anchor<Base>, OffsetT>;
 template <class T, detail::offset_int OffsetT = std::int32_t>
 using self_reloc_ptr = offset_ptr<T, self_reloc_anchor, OffsetT>;
 
@@ -712,7 +927,11 @@ template <class T1, class A1, detail::offset_int O1,
 requires (detail::is_obj_or_void_v<T1> && detail::is_obj_or_void_v<T2>)
 SHM_FORCE_INLINE bool operator==(const offset_ptr<T1, A1, O1>& a,
                                  const offset_ptr<T2, A2, O2>& b) noexcept {
-    return static_cast<const void*>(a.get()) == static_cast<const void*>(b.get());
+    if constexpr (std::is_same_v<A1, A2> && std::is_same_v<O1, O2> && !A1::kSelfRelative) {
+        return a.raw_storage() == b.raw_storage();
+    } else {
+        return static_cast<const void*>(a.get()) == static_cast<const void*>(b.get());
+    }
 }
 
 template <class T1, class A1, detail::offset_int O1,
@@ -726,13 +945,13 @@ SHM_FORCE_INLINE bool operator!=(const offset_ptr<T1, A1, O1>& a,
 template <class T, class A, detail::offset_int O>
 requires (detail::is_obj_or_void_v<T>)
 SHM_FORCE_INLINE bool operator==(const offset_ptr<T, A, O>& a, std::nullptr_t) noexcept {
-    return a.get() == nullptr;
+    return a.raw_storage() == 0;
 }
 
 template <class T, class A, detail::offset_int O>
 requires (detail::is_obj_or_void_v<T>)
 SHM_FORCE_INLINE bool operator==(std::nullptr_t, const offset_ptr<T, A, O>& a) noexcept {
-    return a.get() == nullptr;
+    return a.raw_storage() == 0;
 }
 
 template <class T, class A, detail::offset_int O>
@@ -747,531 +966,3758 @@ SHM_FORCE_INLINE bool operator!=(std::nullptr_t, const offset_ptr<T, A, O>& a) n
     return !(a == nullptr);
 }
 
-
-template <class Tag, detail::offset_int OffsetT = std::uint32_t>
-class linear_allocator {
+// Pointer-plus-length view of a T array that lives in a segment. The view
+// itself may live in the segment too; begin()/end() decode once and hand out
+// raw T*, which is a std::contiguous_iterator, so standard algorithms run
+// (and vectorize) over the array exactly as over a raw array.
+template <class T, class Anchor = self_anchor, detail::offset_int OffsetT = std::int32_t>
+class offset_span {
 public:
-    using tag_type    = Tag;
-    using offset_type = OffsetT;
+    using element_type = T;
+    using value_type   = std::remove_cv_t<T>;
+    using size_type    = std::size_t;
+    using pointer      = T*;
+    using reference    = T&;
+    using iterator     = T*;
+    using ptr_type     = offset_ptr<T, Anchor, OffsetT>;
 
-    template <class T>
-    using handle = shm::segment_offset_ptr<T, Tag, OffsetT>;
+    static_assert(std::is_object_v<T>, "offset_span<T>: T must be an object type.");
+    static_assert(std::contiguous_iterator<iterator>);
 
-    using void_handle = handle<void>;
+    constexpr offset_span() noexcept = default;
+    SHM_FORCE_INLINE offset_span(pointer data, size_type n) noexcept : data_(data), size_(n) {}
+    SHM_FORCE_INLINE explicit offset_span(std::span<T> s) noexcept : data_(s.data()), size_(s.size()) {}
 
-    linear_allocator(void* start, std::size_t size) noexcept
-        : linear_allocator(start, start, size)
-    {}
+    [[nodiscard]] SHM_FORCE_INLINE pointer data() const noexcept { return data_.get(); }
+    [[nodiscard]] SHM_FORCE_INLINE size_type size() const noexcept { return size_; }
+    [[nodiscard]] SHM_FORCE_INLINE bool empty() const noexcept { return size_ == 0; }
 
-    linear_allocator(void* segment_base, void* arena_start, std::size_t arena_size) noexcept
-        : arena_(reinterpret_cast<std::byte*>(arena_start))
-        , arena_addr_(reinterpret_cast<std::uintptr_t>(arena_start))
-        , capacity_(arena_size)
-        , cursor_(0)
-    {
+    [[nodiscard]] SHM_FORCE_INLINE iterator begin() const noexcept { return data(); }
+    [[nodiscard]] SHM_FORCE_INLINE iterator end() const noexcept { return data() + size_; }
 
-        shm::segment_base<Tag>::set(segment_base);
+    [[nodiscard]] SHM_FORCE_INLINE reference operator[](size_type i) const noexcept {
+        SHM_ASSERT(i < size_);
+        return data()[i];
     }
+    [[nodiscard]] SHM_FORCE_INLINE reference front() const noexcept { return (*this)[0]; }
+    [[nodiscard]] SHM_FORCE_INLINE reference back() const noexcept { return (*this)[size_ - 1]; }
 
-    linear_allocator(const linear_allocator&) = delete;
-    linear_allocator& operator=(const linear_allocator&) = delete;
-    linear_allocator(linear_allocator&&) = delete;
-    linear_allocator& operator=(linear_allocator&&) = delete;
-
-    [[nodiscard]] void* alloc(std::size_t n,
-                              std::size_t alignment = alignof(std::max_align_t)) noexcept
-    {
-        if (n == 0) return nullptr;
-        if (alignment == 0) alignment = 1;
+    [[nodiscard]] SHM_FORCE_INLINE std::span<T> as_span() const noexcept { return {data(), size_}; }
+    [[nodiscard]] SHM_FORCE_INLINE operator std::span<T>() const noexcept { return as_span(); }
 
-        const bool pow2 = (alignment & (alignment - 1)) == 0;
+    [[nodiscard]] SHM_FORCE_INLINE const ptr_type& data_ptr() const noexcept { return data_; }
 
-        std::size_t cur = cursor_.load(std::memory_order_relaxed);
-        for (;;) {
-            if (cur > capacity_) return nullptr;
+private:
+    ptr_type data_;
+    size_type size_ = 0;
+};
 
-            const std::uintptr_t addr = arena_addr_ + static_cast<std::uintptr_t>(cur);
-            std::uintptr_t aligned_addr;
+template <class T, class Tag, detail::offset_int OffsetT = std::uint32_t>
+using segment_offset_span = offset_span<T, segment_anchor<Tag>, OffsetT>;
 
-            if (pow2) {
-                const std::uintptr_t mask = static_cast<std::uintptr_t>(alignment - 1);
-                aligned_addr = (addr + mask) & ~mask;
-            } else {
-                const std::uintptr_t a = static_cast<std::uintptr_t>(alignment);
-                const std::uintptr_t rem = addr % a;
-                aligned_addr = (rem == 0) ? addr : (addr + (a - rem));
-            }
+namespace detail {
+    // Shared "+1" codec for the pointer species that do not carry their own
+    // copy of the encode/decode sequence.
+    template <class OffsetT>
+    SHM_FORCE_INLINE OffsetT encode_off_plus1(uptr b, const void* p) noexcept {
+        if (!p) return OffsetT(0);
 
-            const std::uintptr_t aligned_off_u = aligned_addr - arena_addr_;
-            if (aligned_off_u > static_cast<std::uintptr_t>(capacity_)) return nullptr;
+        const iptr diff = static_cast<iptr>(addr(p)) - static_cast<iptr>(b);
 
-            const std::size_t aligned_off = static_cast<std::size_t>(aligned_off_u);
-            if (n > capacity_ - aligned_off) return nullptr;
+        if constexpr (std::is_signed_v<OffsetT>) {
+            SHM_ASSERT(diff != -1 && "diff == -1 would encode to 0 (reserved for null).");
+        } else {
+            SHM_ASSERT(diff >= 0);
+        }
+        return narrow_checked<OffsetT>(diff + 1);
+    }
 
-            const std::size_t next = aligned_off + n;
+    template <class Pointer, class OffsetT>
+    SHM_FORCE_INLINE Pointer decode_off_plus1(uptr b, OffsetT s) noexcept {
+        if (SHM_UNLIKELY(s == 0)) return nullptr;
 
-            if (cursor_.compare_exchange_weak(
-                    cur, next,
-                    std::memory_order_acq_rel,
-                    std::memory_order_relaxed))
-            {
-                return arena_ + aligned_off;
-            }
+        if constexpr (std::is_signed_v<OffsetT>) {
+            const iptr off = static_cast<iptr>(s) - 1;
+            return reinterpret_cast<Pointer>(b + static_cast<uptr>(off));
+        } else {
+            const uptr off = static_cast<uptr>(s - 1);
+            return reinterpret_cast<Pointer>(b + off);
         }
     }
 
-    [[nodiscard]] void_handle alloc_handle(std::size_t n,
-                                           std::size_t alignment = alignof(std::max_align_t)) noexcept
-    {
-        void* p = alloc(n, alignment);
-        if (!p) return void_handle(nullptr);
-        return void_handle(static_cast<void*>(p));
+    SHM_FORCE_INLINE constexpr std::memory_order cas_failure_order(std::memory_order o) noexcept {
+        if (o == std::memory_order_acq_rel) return std::memory_order_acquire;
+        if (o == std::memory_order_release) return std::memory_order_relaxed;
+        return o;
     }
 
-    template <class T>
-    [[nodiscard]] T* allocate(std::size_t count = 1) noexcept {
-        static_assert(!std::is_void_v<T>, "allocate<void> is not meaningful.");
-        if (count == 0) return nullptr;
-        if (count > (std::numeric_limits<std::size_t>::max() / sizeof(T))) return nullptr;
-        return static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+    // self_anchor is the only anchor whose copies are re-encoded against the
+    // destination; self_reloc_anchor and detached anchors copy bitwise.
+    template <class Anchor>
+    inline constexpr bool rebases_on_copy_v = std::is_same_v<Anchor, self_anchor>;
+} // namespace detail
+
+// Atomic counterpart of offset_ptr. The stored word has the same "+1" encoding
+// as offset_ptr<T, Anchor, OffsetT>, so for self-relative anchors the
+// displacement is taken relative to this object (and expected values handed to
+// compare_exchange are encoded against the same address before the CAS).
+//
+// Only lock-free widths are accepted: a lock-based std::atomic keeps its lock
+// outside the shared bytes and is therefore not usable across processes.
+template <class T, class Anchor = self_anchor, detail::offset_int OffsetT = std::int32_t>
+class atomic_offset_ptr {
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using offset_type  = OffsetT;
+
+    static_assert(detail::is_obj_or_void_v<T>,
+                  "atomic_offset_ptr<T>: T must be an object type or void.");
+    static_assert(std::atomic<offset_type>::is_always_lock_free,
+                  "atomic_offset_ptr: OffsetT must be lock-free to be shared across processes.");
+    static_assert(sizeof(std::atomic<offset_type>) == sizeof(offset_type),
+                  "atomic_offset_ptr: std::atomic<OffsetT> must have the layout of OffsetT.");
+
+    static constexpr bool is_always_lock_free = true;
+
+    constexpr atomic_offset_ptr() noexcept = default;
+    constexpr atomic_offset_ptr(std::nullptr_t) noexcept {}
+    SHM_FORCE_INLINE explicit atomic_offset_ptr(pointer p) noexcept
+        : off_plus1_(encode(p)) {}
+
+    atomic_offset_ptr(const atomic_offset_ptr&) = delete;
+    atomic_offset_ptr& operator=(const atomic_offset_ptr&) = delete;
+
+    SHM_FORCE_INLINE pointer operator=(pointer p) noexcept { store(p); return p; }
+    SHM_FORCE_INLINE operator pointer() const noexcept { return load(); }
+
+    [[nodiscard]] SHM_FORCE_INLINE pointer load(std::memory_order o = std::memory_order_seq_cst) const noexcept {
+        return decode(off_plus1_.load(o));
     }
 
-    template <class T>
-    [[nodiscard]] handle<T> allocate_handle(std::size_t count = 1) noexcept {
-        T* p = allocate<T>(count);
-        if (!p) return handle<T>(nullptr);
-        return handle<T>(p);
+    SHM_FORCE_INLINE void store(pointer p, std::memory_order o = std::memory_order_seq_cst) noexcept {
+        off_plus1_.store(encode(p), o);
     }
 
-    template <class T, class... Args>
-    [[nodiscard]] handle<T> make_handle(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
-        void* mem = alloc(sizeof(T), alignof(T));
-        if (!mem) return handle<T>(nullptr);
-        T* obj = ::new (mem) T(std::forward<Args>(args)...);
-        return handle<T>(obj);
+    SHM_FORCE_INLINE pointer exchange(pointer p, std::memory_order o = std::memory_order_seq_cst) noexcept {
+        return decode(off_plus1_.exchange(encode(p), o));
     }
 
-    void reset() noexcept {
-        cursor_.store(0, std::memory_order_release);
+    SHM_FORCE_INLINE bool compare_exchange_weak(pointer& expected, pointer desired,
+                                                std::memory_order success,
+                                                std::memory_order failure) noexcept {
+        offset_type e = encode(expected);
+        if (off_plus1_.compare_exchange_weak(e, encode(desired), success, failure)) return true;
+        expected = decode(e);
+        return false;
     }
 
-    void secure_reset() noexcept {
-        const std::size_t u = used();
-        if (u) std::memset(arena_, 0, u);
-        cursor_.store(0, std::memory_order_release);
+    SHM_FORCE_INLINE bool compare_exchange_weak(pointer& expected, pointer desired,
+                                                std::memory_order o = std::memory_order_seq_cst) noexcept {
+        return compare_exchange_weak(expected, desired, o, detail::cas_failure_order(o));
     }
 
-    [[nodiscard]] std::size_t used() const noexcept {
-        return cursor_.load(std::memory_order_relaxed);
+    SHM_FORCE_INLINE bool compare_exchange_strong(pointer& expected, pointer desired,
+                                                  std::memory_order success,
+                                                  std::memory_order failure) noexcept {
+        offset_type e = encode(expected);
+        if (off_plus1_.compare_exchange_strong(e, encode(desired), success, failure)) return true;
+        expected = decode(e);
+        return false;
     }
 
-    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+    SHM_FORCE_INLINE bool compare_exchange_strong(pointer& expected, pointer desired,
+                                                  std::memory_order o = std::memory_order_seq_cst) noexcept {
+        return compare_exchange_strong(expected, desired, o, detail::cas_failure_order(o));
+    }
 
-    [[nodiscard]] bool owns(const void* p) const noexcept {
-        const auto x = reinterpret_cast<std::uintptr_t>(p);
-        return x >= arena_addr_ && x < (arena_addr_ + static_cast<std::uintptr_t>(capacity_));
+    [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage(std::memory_order o = std::memory_order_seq_cst) const noexcept {
+        return off_plus1_.load(o);
     }
 
-       template <class T>
-    struct stl_allocator {
-    using value_type      = T;
-    using size_type       = std::size_t;
-    using difference_type = std::ptrdiff_t;
+    [[nodiscard]] bool is_lock_free() const noexcept { return off_plus1_.is_lock_free(); }
 
-    using pointer            = handle<T>;
-    using const_pointer      = handle<const T>;
-    using void_pointer       = void_handle;
-    using const_void_pointer = handle<const void>;
+private:
+    SHM_FORCE_INLINE offset_type encode(pointer p) const noexcept {
+        if (!p) return offset_type(0);
+        return detail::encode_off_plus1<offset_type>(Anchor::base(this), p);
+    }
 
-    handle<linear_allocator> arena = handle<linear_allocator>(nullptr);
+    SHM_FORCE_INLINE pointer decode(offset_type s) const noexcept {
+        if (SHM_UNLIKELY(s == 0)) return nullptr;
+        return detail::decode_off_plus1<pointer>(Anchor::base(this), s);
+    }
 
-    stl_allocator() noexcept = default;
-    explicit stl_allocator(linear_allocator& a) noexcept : arena(&a) {}
+    std::atomic<offset_type> off_plus1_{0};
+};
 
-    template <class U>
-    stl_allocator(const stl_allocator<U>& other) noexcept : arena(other.arena) {}
+// Pointer plus a 32-bit tag (version counter, mark bits) CASed as one 64-bit
+// word. The offset lives in the low half with the usual "+1" encoding, so a
+// null pointer with tag 0 is the all-zero word. OffsetT is limited to 32 bits
+// so that the pair stays within a lock-free 64-bit CAS on every target.
+template <class T, class Anchor = self_anchor, detail::offset_int OffsetT = std::int32_t>
+class atomic_tagged_offset_ptr {
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using offset_type  = OffsetT;
+    using tag_type     = std::uint32_t;
 
-    [[nodiscard]] pointer allocate(size_type n) {
-        if (n == 0) return pointer(nullptr);
-        if (!arena) throw std::bad_alloc();
-        if (n > (std::numeric_limits<size_type>::max)() / sizeof(T)) throw std::bad_alloc();
+    struct value_type {
+        pointer  ptr = nullptr;
+        tag_type tag = 0;
 
-        linear_allocator* a = arena.get();
-        void* p = a->alloc(sizeof(T) * n, alignof(T));
-        if (!p) throw std::bad_alloc();
-        return pointer(static_cast<T*>(p));
-    }
+        [[nodiscard]] friend constexpr bool operator==(const value_type&, const value_type&) noexcept = default;
+    };
 
-    void deallocate(pointer, size_type) noexcept {}
+    static_assert(detail::is_obj_or_void_v<T>,
+                  "atomic_tagged_offset_ptr<T>: T must be an object type or void.");
+    static_assert(sizeof(offset_type) <= sizeof(tag_type),
+                  "atomic_tagged_offset_ptr: OffsetT must be at most 32 bits wide.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                  "atomic_tagged_offset_ptr: requires a lock-free 64-bit atomic.");
 
-    template <class U>
-    struct rebind { using other = stl_allocator<U>; };
+    static constexpr bool is_always_lock_free = true;
 
-    using propagate_on_container_copy_assignment = std::true_type;
-    using propagate_on_container_move_assignment = std::true_type;
-    using propagate_on_container_swap            = std::true_type;
-    using is_always_equal                        = std::false_type;
+    constexpr atomic_tagged_offset_ptr() noexcept = default;
+    SHM_FORCE_INLINE explicit atomic_tagged_offset_ptr(value_type v) noexcept
+        : word_(encode(v)) {}
 
-    template <class U>
-    friend struct stl_allocator;
+    atomic_tagged_offset_ptr(const atomic_tagged_offset_ptr&) = delete;
+    atomic_tagged_offset_ptr& operator=(const atomic_tagged_offset_ptr&) = delete;
 
-    template <class U>
-    friend bool operator==(const stl_allocator& a, const stl_allocator<U>& b) noexcept {
-        return a.arena == b.arena;
+    [[nodiscard]] SHM_FORCE_INLINE value_type load(std::memory_order o = std::memory_order_seq_cst) const noexcept {
+        return decode(word_.load(o));
     }
-    template <class U>
-    friend bool operator!=(const stl_allocator& a, const stl_allocator<U>& b) noexcept {
-        return !(a == b);
+
+    SHM_FORCE_INLINE void store(value_type v, std::memory_order o = std::memory_order_seq_cst) noexcept {
+        word_.store(encode(v), o);
     }
-};
 
-private:
-    std::byte* arena_ = nullptr;
-    std::uintptr_t arena_addr_ = 0;
-    std::size_t capacity_ = 0;
-    std::atomic<std::size_t> cursor_{0};
+    SHM_FORCE_INLINE value_type exchange(value_type v, std::memory_order o = std::memory_order_seq_cst) noexcept {
+        return decode(word_.exchange(encode(v), o));
+    }
 
-};
+    SHM_FORCE_INLINE bool compare_exchange_weak(value_type& expected, value_type desired,
+                                                std::memory_order success,
+                                                std::memory_order failure) noexcept {
+        std::uint64_t e = encode(expected);
+        if (word_.compare_exchange_weak(e, encode(desired), success, failure)) return true;
+        expected = decode(e);
+        return false;
+    }
 
-namespace detail::seg {
+    SHM_FORCE_INLINE bool compare_exchange_weak(value_type& expected, value_type desired,
+                                                std::memory_order o = std::memory_order_seq_cst) noexcept {
+        return compare_exchange_weak(expected, desired, o, detail::cas_failure_order(o));
+    }
 
+    SHM_FORCE_INLINE bool compare_exchange_strong(value_type& expected, value_type desired,
+                                                  std::memory_order success,
+                                                  std::memory_order failure) noexcept {
+        std::uint64_t e = encode(expected);
+        if (word_.compare_exchange_strong(e, encode(desired), success, failure)) return true;
+        expected = decode(e);
+        return false;
+    }
 
-static inline std::string normalize_name_(const char* name) {
-    if (!name || !*name) return {};
-    std::string s(name);
-    if (s[0] != '/') s.insert(s.begin(), '/');
-    while (s.size() > 1 && s.back() == '/') s.pop_back();
-    return s;
-}
+    SHM_FORCE_INLINE bool compare_exchange_strong(value_type& expected, value_type desired,
+                                                  std::memory_order o = std::memory_order_seq_cst) noexcept {
+        return compare_exchange_strong(expected, desired, o, detail::cas_failure_order(o));
+    }
 
-#if !SHM_PLATFORM_WIN32
+    [[nodiscard]] SHM_FORCE_INLINE std::uint64_t raw_storage(std::memory_order o = std::memory_order_seq_cst) const noexcept {
+        return word_.load(o);
+    }
 
-template <class Fn, class... Args>
-static inline auto retry_eintr_call_(Fn fn, Args... args) noexcept -> decltype(fn(args...)) {
-    for (;;) {
-        auto rc = fn(args...);
-        if (rc == decltype(rc)(-1) && errno == EINTR) continue;
-        return rc;
+    [[nodiscard]] bool is_lock_free() const noexcept { return word_.is_lock_free(); }
+
+private:
+    using uoffset_type = std::make_unsigned_t<offset_type>;
+
+    SHM_FORCE_INLINE std::uint64_t encode(value_type v) const noexcept {
+        offset_type s = 0;
+        if (v.ptr) s = detail::encode_off_plus1<offset_type>(Anchor::base(this), v.ptr);
+        return (static_cast<std::uint64_t>(v.tag) << 32)
+             | static_cast<std::uint64_t>(static_cast<uoffset_type>(s));
     }
-}
 
-static inline std::size_t page_size_() noexcept {
-#if SHM_PLATFORM_WIN32
-    SYSTEM_INFO si{};
-    ::GetSystemInfo(&si);
-    std::size_t ps = static_cast<std::size_t>(si.dwPageSize);
-    return ps ? ps : 4096u;
-#else
-    long ps = ::sysconf(_SC_PAGESIZE);
-    if (ps <= 0) ps = 4096;
-    return static_cast<std::size_t>(ps);
-#endif
-}
+    SHM_FORCE_INLINE value_type decode(std::uint64_t w) const noexcept {
+        const auto s = static_cast<offset_type>(static_cast<uoffset_type>(w));
+        value_type v;
+        v.tag = static_cast<tag_type>(w >> 32);
+        if (s != 0) v.ptr = detail::decode_off_plus1<pointer>(Anchor::base(this), s);
+        return v;
+    }
 
+    std::atomic<std::uint64_t> word_{0};
+};
 
-static inline std::size_t round_up_(std::size_t x, std::size_t a) noexcept {
-    if (a == 0) return x;
-    const std::size_t r = x % a;
-    return r == 0 ? x : (x + (a - r));
-}
 
-// POSIX shm name rules in practice must start with '/', must not contain any other '/'.
-// SInce platforms are more permissive, we enforce the strict portable subset.
-static inline bool name_is_portable_(std::string_view s) noexcept {
-    if (s.empty()) return false;
-    if (s[0] != '/') return false;
-    if (s.size() == 1) return false;
-    for (std::size_t i = 1; i < s.size(); ++i) {
-        const char c = s[i];
-        if (c == '/') return false;
-        if (c == '\0') return false;
+// offset_ptr with a small user tag folded into the stored integer.
+//
+// The displacement is stored in units of the pointee alignment (as far as the
+// anchor can guarantee it) and shifted left by TagBits; the tag occupies the
+// low TagBits bits. When TagBits does not exceed the alignment shift this is
+// exactly offset_ptr's "+1" encoding with the always-zero low bits reused, and
+// range is unchanged. Larger TagBits borrow high bits and shrink the range.
+// A null pointer is a zero pointer part; null with tag 0 is raw value 0.
+template <class T, unsigned TagBits, class Anchor = self_anchor, detail::offset_int OffsetT = std::int32_t>
+class tagged_offset_ptr {
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using reference    = std::add_lvalue_reference_t<T>;
+    using offset_type  = OffsetT;
+    using tag_type     = std::make_unsigned_t<OffsetT>;
+
+    static_assert(detail::is_obj_or_void_v<T>,
+                  "tagged_offset_ptr<T>: T must be an object type or void.");
+    static_assert(TagBits > 0 && TagBits < sizeof(OffsetT) * 8,
+                  "tagged_offset_ptr: TagBits must leave room for the displacement.");
+
+    static constexpr unsigned tag_bits = TagBits;
+    static constexpr tag_type tag_mask = static_cast<tag_type>((tag_type(1) << TagBits) - 1);
+
+    constexpr tagged_offset_ptr() noexcept = default;
+    constexpr tagged_offset_ptr(std::nullptr_t) noexcept : bits_(0) {}
+    SHM_FORCE_INLINE explicit tagged_offset_ptr(pointer p, tag_type tag = 0) noexcept { set(p, tag); }
+
+    tagged_offset_ptr(const tagged_offset_ptr&) noexcept
+        requires (!detail::rebases_on_copy_v<Anchor>) = default;
+    tagged_offset_ptr& operator=(const tagged_offset_ptr&) noexcept
+        requires (!detail::rebases_on_copy_v<Anchor>) = default;
+
+    SHM_FORCE_INLINE tagged_offset_ptr(const tagged_offset_ptr& other) noexcept
+        requires (detail::rebases_on_copy_v<Anchor>) { set(other.get(), other.tag()); }
+    SHM_FORCE_INLINE tagged_offset_ptr& operator=(const tagged_offset_ptr& other) noexcept
+        requires (detail::rebases_on_copy_v<Anchor>) {
+        if (this != &other) set(other.get(), other.tag());
+        return *this;
     }
-    return true;
-}
 
+    SHM_FORCE_INLINE tagged_offset_ptr& operator=(std::nullptr_t) noexcept { set_ptr(nullptr); return *this; }
 
-static inline void nanosleep_backoff_(std::size_t attempt) noexcept {
-    // attempt=0.. => 100us, 200us, 400us ... capped at 10ms
-    const std::size_t max_ns = 10ull * 1000ull * 1000ull;
-    std::size_t ns = 100ull * 1000ull;
-    if (attempt < 10) ns <<= attempt;
-    if (ns > max_ns) ns = max_ns;
-    timespec ts{};
-    ts.tv_sec = 0;
-    ts.tv_nsec = static_cast<long>(ns);
-    ::nanosleep(&ts, nullptr);
-}
+    [[nodiscard]] SHM_FORCE_INLINE pointer get() const noexcept {
+        constexpr unsigned A = align_shift();
+        const offset_type s = bits_;
+
+        if constexpr (TagBits == A) {
+            // pointer part == diff + 2^A, so a mask and a subtract decode it.
+            const offset_type part = static_cast<offset_type>(s & static_cast<offset_type>(~tag_mask));
+            if (SHM_UNLIKELY(part == 0)) return nullptr;
+            const detail::uptr b = Anchor::base(this);
+            if constexpr (std::is_signed_v<offset_type>) {
+                const detail::iptr off = static_cast<detail::iptr>(part) - (detail::iptr(1) << A);
+                return reinterpret_cast<pointer>(b + static_cast<detail::uptr>(off));
+            } else {
+                const detail::uptr off = static_cast<detail::uptr>(part) - (detail::uptr(1) << A);
+                return reinterpret_cast<pointer>(b + off);
+            }
+        } else {
+            const offset_type units_plus1 = static_cast<offset_type>(s >> TagBits);
+            if (SHM_UNLIKELY(units_plus1 == 0)) return nullptr;
+            const detail::uptr b = Anchor::base(this);
+            if constexpr (std::is_signed_v<offset_type>) {
+                const detail::iptr off = (static_cast<detail::iptr>(units_plus1) - 1) * (detail::iptr(1) << A);
+                return reinterpret_cast<pointer>(b + static_cast<detail::uptr>(off));
+            } else {
+                const detail::uptr off = (static_cast<detail::uptr>(units_plus1) - 1) << A;
+                return reinterpret_cast<pointer>(b + off);
+            }
+        }
+    }
 
-#endif
+    [[nodiscard]] SHM_FORCE_INLINE tag_type tag() const noexcept {
+        return static_cast<tag_type>(static_cast<tag_type>(bits_) & tag_mask);
+    }
 
-#if SHM_PLATFORM_WIN32
-    [[nodiscard]] SHM_FORCE_INLINE DWORD last_error() noexcept {
-        return ::GetLastError();
+    SHM_FORCE_INLINE void set_tag(tag_type tag) noexcept {
+        SHM_ASSERT(tag <= tag_mask && "tag does not fit in TagBits.");
+        bits_ = static_cast<offset_type>((static_cast<tag_type>(bits_) & static_cast<tag_type>(~tag_mask))
+                                         | (tag & tag_mask));
     }
 
-    [[nodiscard]] inline std::system_error win32_error(const char* op,
-                                                       std::string_view portable_name,
-                                                       DWORD err) {
-        if (err == 0) err = ERROR_GEN_FAILURE;
-        std::error_code ec(static_cast<int>(err), std::system_category());
+    SHM_FORCE_INLINE void set_ptr(pointer p) noexcept { set(p, tag()); }
 
-        std::string msg;
-        msg.reserve(320);
-        msg.append("shm::segment: ");
-        msg.append(op);
-        msg.append(" failed (name=");
-        msg.append(portable_name.data(), portable_name.size());
-        msg.append(", GetLastError=");
-        msg.append(std::to_string(static_cast<unsigned long>(err)));
-        msg.append(", ");
-        msg.append(ec.message());
-        msg.append(")");
+    SHM_FORCE_INLINE void set(pointer p, tag_type tag) noexcept {
+        SHM_ASSERT(tag <= tag_mask && "tag does not fit in TagBits.");
+        bits_ = static_cast<offset_type>(static_cast<tag_type>(encode_ptr(p)) | (tag & tag_mask));
+    }
 
-        return std::system_error(ec, msg);
+    [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage() const noexcept { return bits_; }
+
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(get()); }
+    [[nodiscard]] SHM_FORCE_INLINE explicit operator bool() const noexcept {
+        return (static_cast<tag_type>(bits_) & static_cast<tag_type>(~tag_mask)) != 0;
     }
-    [[nodiscard]] inline std::wstring utf8_to_wstring_strict(std::string_view s) {
-        if (s.empty()) return std::wstring();
 
-        if (s.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
-            throw win32_error("utf8_to_wstring(length overflow)", s, ERROR_INVALID_PARAMETER);
-        }
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U& operator*() const noexcept { return *get(); }
 
-        const int src_len = static_cast<int>(s.size());
-        constexpr DWORD flags = MB_ERR_INVALID_CHARS;
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U* operator->() const noexcept { return get(); }
 
-        int needed = ::MultiByteToWideChar(CP_UTF8, flags, s.data(), src_len, nullptr, 0);
-        if (needed <= 0) {
-            throw win32_error("MultiByteToWideChar(size)", s, last_error());
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator==(const tagged_offset_ptr& a, const tagged_offset_ptr& b) noexcept {
+        return a.get() == b.get() && a.tag() == b.tag();
+    }
+
+    // Alignment the encoder may rely on. Self-relative anchors measure from a
+    // field that is only aligned to OffsetT.
+    static constexpr unsigned align_shift() noexcept {
+        if constexpr (std::is_void_v<T>) {
+            return 0;
+        } else {
+            std::size_t a = alignof(T);
+            if constexpr (Anchor::kSelfRelative) {
+                if (alignof(offset_type) < a) a = alignof(offset_type);
+            }
+            return static_cast<unsigned>(std::countr_zero(a));
         }
+    }
 
-        std::wstring out(static_cast<std::size_t>(needed), L'\0');
+private:
+    SHM_FORCE_INLINE offset_type encode_ptr(pointer p) const noexcept {
+        if (!p) return offset_type(0);
 
-        int written = ::MultiByteToWideChar(CP_UTF8, flags, s.data(), src_len, out.data(), needed);
-        if (written != needed) {
-            throw win32_error("MultiByteToWideChar(convert)", s, last_error());
-        }
+        constexpr unsigned A = align_shift();
+        const detail::uptr b = Anchor::base(this);
+        const detail::iptr diff = static_cast<detail::iptr>(detail::addr(p)) - static_cast<detail::iptr>(b);
 
-        return out;
-    }
+        SHM_ASSERT((static_cast<detail::uptr>(diff) & ((detail::uptr(1) << A) - 1)) == 0
+                   && "target is not aligned relative to the anchor base.");
 
-    [[nodiscard]] inline std::wstring win32_object_name_from_portable(std::string_view portable_name) {
-        if (portable_name.size() < 2 || portable_name[0] != '/') {
-            throw win32_error("win32_object_name_from_portable(invalid portable name)",
-                              portable_name,
-                              ERROR_INVALID_NAME);
+        if constexpr (std::is_signed_v<offset_type>) {
+            const detail::iptr units_plus1 = (diff >> A) + 1;
+            SHM_ASSERT(units_plus1 != 0 && "diff == -alignment would encode to null.");
+            SHM_ASSERT(units_plus1 >= (static_cast<detail::iptr>(std::numeric_limits<offset_type>::min()) >> TagBits));
+            SHM_ASSERT(units_plus1 <= (static_cast<detail::iptr>(std::numeric_limits<offset_type>::max()) >> TagBits));
+            return static_cast<offset_type>(static_cast<tag_type>(static_cast<detail::uptr>(units_plus1) << TagBits));
+        } else {
+            SHM_ASSERT(diff >= 0);
+            const detail::uptr units_plus1 = (static_cast<detail::uptr>(diff) >> A) + 1;
+            SHM_ASSERT(units_plus1 <= (static_cast<detail::uptr>(std::numeric_limits<offset_type>::max()) >> TagBits));
+            return static_cast<offset_type>(units_plus1 << TagBits);
         }
+    }
 
-        std::wstring wbody = utf8_to_wstring_strict(
-            std::string_view(portable_name.data() + 1, portable_name.size() - 1)
-        );
+    offset_type bits_ = 0;
+};
 
-        constexpr std::wstring_view prefix = SHM_WIN32_OBJECT_NAMESPACE;
+template <class T, class Tag, unsigned TagBits, detail::offset_int OffsetT = std::uint32_t>
+using segment_tagged_ptr = tagged_offset_ptr<T, TagBits, segment_anchor<Tag>, OffsetT>;
 
-        std::wstring wname;
-        wname.reserve(prefix.size() + wbody.size());
-        wname.append(prefix.data(), prefix.size());
-        wname.append(wbody);
-        return wname;
+
+// Non-nullable counterpart of offset_ptr for links that always refer to an
+// object (a node's parent, a slot's owner). The raw displacement is stored
+// without the "+1" null encoding, so decoding is a single add with no branch.
+// There is no default constructor; a zero-filled offset_ref refers to its
+// anchor base, never to "nothing".
+template <class T, class Anchor = self_anchor, detail::offset_int OffsetT = std::int32_t>
+class offset_ref {
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using reference    = T&;
+    using offset_type  = OffsetT;
+    using ptr_type     = offset_ptr<T, Anchor, OffsetT>;
+
+    static_assert(std::is_object_v<T>, "offset_ref<T>: T must be an object type.");
+
+    SHM_FORCE_INLINE offset_ref(reference r) noexcept { set(std::addressof(r)); }
+    offset_ref(T&&) = delete;
+
+    SHM_FORCE_INLINE explicit offset_ref(const ptr_type& p) noexcept {
+        SHM_ASSERT(p && "offset_ref cannot be formed from a null offset_ptr.");
+        set(p.get());
     }
 
-    struct win32_sysinfo_cache final {
-        DWORD page_size = 4096;
-        DWORD alloc_granularity = 64 * 1024;
+    offset_ref(const offset_ref&) noexcept
+        requires (!detail::rebases_on_copy_v<Anchor>) = default;
+    offset_ref& operator=(const offset_ref&) noexcept
+        requires (!detail::rebases_on_copy_v<Anchor>) = default;
 
-        win32_sysinfo_cache() noexcept {
-            SYSTEM_INFO si{};
-            ::GetSystemInfo(&si);
-            if (si.dwPageSize) page_size = si.dwPageSize;
-            if (si.dwAllocationGranularity) alloc_granularity = si.dwAllocationGranularity;
+    SHM_FORCE_INLINE offset_ref(const offset_ref& other) noexcept
+        requires (detail::rebases_on_copy_v<Anchor>) { set(other.address()); }
+    SHM_FORCE_INLINE offset_ref& operator=(const offset_ref& other) noexcept
+        requires (detail::rebases_on_copy_v<Anchor>) {
+        if (this != &other) set(other.address());
+        return *this;
+    }
+
+    // Rebinds, like std::reference_wrapper.
+    SHM_FORCE_INLINE offset_ref& operator=(reference r) noexcept { set(std::addressof(r)); return *this; }
+
+    [[nodiscard]] SHM_FORCE_INLINE pointer address() const noexcept {
+        const detail::uptr b = Anchor::base(this);
+        if constexpr (std::is_signed_v<offset_type>) {
+            return reinterpret_cast<pointer>(b + static_cast<detail::uptr>(static_cast<detail::iptr>(off_)));
+        } else {
+            return reinterpret_cast<pointer>(b + static_cast<detail::uptr>(off_));
         }
-    };
+    }
 
-    [[nodiscard]] inline const win32_sysinfo_cache& sysinfo() noexcept {
-        static const win32_sysinfo_cache s;
-        return s;
+    [[nodiscard]] SHM_FORCE_INLINE reference get() const noexcept { return *address(); }
+    [[nodiscard]] SHM_FORCE_INLINE operator reference() const noexcept { return get(); }
+    [[nodiscard]] SHM_FORCE_INLINE reference operator*() const noexcept { return get(); }
+    [[nodiscard]] SHM_FORCE_INLINE pointer operator->() const noexcept { return address(); }
+
+    [[nodiscard]] SHM_FORCE_INLINE ptr_type to_ptr() const noexcept { return ptr_type(address()); }
+    [[nodiscard]] SHM_FORCE_INLINE operator ptr_type() const noexcept { return to_ptr(); }
+
+    [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage() const noexcept { return off_; }
+
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(address()); }
+
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator==(const offset_ref& a, const offset_ref& b) noexcept {
+        if constexpr (Anchor::kSelfRelative) return a.address() == b.address();
+        else return a.off_ == b.off_;
     }
 
-    [[nodiscard]] SHM_FORCE_INLINE std::size_t round_up(std::size_t x, std::size_t a) noexcept {
-        if (a == 0) return x;
-        const std::size_t r = x % a;
-        return r == 0 ? x : (x + (a - r));
+private:
+    SHM_FORCE_INLINE void set(pointer p) noexcept {
+        SHM_ASSERT(p && "offset_ref must refer to an object.");
+        const detail::uptr b = Anchor::base(this);
+        const detail::iptr diff = static_cast<detail::iptr>(detail::addr(p)) - static_cast<detail::iptr>(b);
+        off_ = detail::narrow_checked<offset_type>(diff);
     }
 
-    struct unique_handle final {
-        HANDLE h = NULL;
+    offset_type off_;
+};
 
-        unique_handle() noexcept = default;
-        explicit unique_handle(HANDLE v) noexcept : h(v) {}
-        unique_handle(const unique_handle&) = delete;
-        unique_handle& operator=(const unique_handle&) = delete;
+template <class T, class Tag, detail::offset_int OffsetT = std::uint32_t>
+using segment_offset_ref = offset_ref<T, segment_anchor<Tag>, OffsetT>;
+
+// Requests alignof(T) as the unit of a scaled_offset_ptr.
+inline constexpr std::size_t scale_by_alignment = 0;
+
+// Segment-relative pointer whose displacement is stored in units of Scale
+// bytes instead of bytes. A 32-bit offset in units of 8 or 16 bytes covers a
+// 32 or 64 GiB segment; decoding stays a shift and an add, with the "+1"
+// folded into the base. Scale == scale_by_alignment means alignof(T), which
+// is resolved lazily so T may be incomplete at the point of declaration.
+template <class T, class Anchor, detail::offset_int OffsetT = std::uint32_t,
+          std::size_t Scale = scale_by_alignment>
+class scaled_offset_ptr {
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using reference    = std::add_lvalue_reference_t<T>;
+    using offset_type  = OffsetT;
 
-        unique_handle(unique_handle&& o) noexcept : h(o.h) { o.h = NULL; }
-        unique_handle& operator=(unique_handle&& o) noexcept {
-            if (this != &o) {
-                reset();
-                h = o.h;
-                o.h = NULL;
-            }
-            return *this;
-        }
+    static_assert(detail::is_obj_or_void_v<T>,
+                  "scaled_offset_ptr<T>: T must be an object type or void.");
+    static_assert(!Anchor::kSelfRelative,
+                  "scaled_offset_ptr: self-relative fields are not aligned to the scale; use a segment anchor.");
+    static_assert(Scale == scale_by_alignment || std::has_single_bit(Scale),
+                  "scaled_offset_ptr: Scale must be a power of two.");
 
-        ~unique_handle() noexcept { reset(); }
+    constexpr scaled_offset_ptr() noexcept = default;
+    constexpr scaled_offset_ptr(std::nullptr_t) noexcept : units_plus1_(0) {}
+    SHM_FORCE_INLINE explicit scaled_offset_ptr(pointer p) noexcept { set(p); }
 
-        void reset(HANDLE nh = NULL) noexcept {
-            if (h != NULL) {
-                ::CloseHandle(h);
-            }
-            h = nh;
-        }
+    template <class U>
+    requires (std::is_convertible_v<U*, T*>)
+    SHM_FORCE_INLINE scaled_offset_ptr(const scaled_offset_ptr<U, Anchor, OffsetT, Scale>& other) noexcept {
+        set(other.get());
+    }
 
-        [[nodiscard]] HANDLE get() const noexcept { return h; }
-        [[nodiscard]] explicit operator bool() const noexcept { return h != NULL; }
+    SHM_FORCE_INLINE scaled_offset_ptr& operator=(pointer p) noexcept { set(p); return *this; }
+    SHM_FORCE_INLINE scaled_offset_ptr& operator=(std::nullptr_t) noexcept { units_plus1_ = 0; return *this; }
 
-        [[nodiscard]] HANDLE release() noexcept {
-            HANDLE out = h;
-            h = NULL;
-            return out;
+    static constexpr std::size_t scale() noexcept {
+        if constexpr (Scale != scale_by_alignment) {
+            return Scale;
+        } else if constexpr (std::is_void_v<T>) {
+            return 1;
+        } else {
+            return alignof(T);
         }
-    };
+    }
 
-    struct unique_view final {
-        void* p = nullptr;
+    static constexpr unsigned scale_shift() noexcept {
+        return static_cast<unsigned>(std::countr_zero(scale()));
+    }
 
-        unique_view() noexcept = default;
-        explicit unique_view(void* v) noexcept : p(v) {}
-        unique_view(const unique_view&) = delete;
-        unique_view& operator=(const unique_view&) = delete;
+    // Largest segment (in bytes) this pointer can address from the anchor base.
+    static constexpr std::uint64_t max_reach() noexcept {
+        constexpr int value_bits = std::numeric_limits<offset_type>::digits;
+        if (value_bits + static_cast<int>(scale_shift()) >= 64) return std::numeric_limits<std::uint64_t>::max();
+        return static_cast<std::uint64_t>(std::numeric_limits<offset_type>::max()) << scale_shift();
+    }
 
-        unique_view(unique_view&& o) noexcept : p(o.p) { o.p = nullptr; }
-        unique_view& operator=(unique_view&& o) noexcept {
+    [[nodiscard]] SHM_FORCE_INLINE pointer get() const noexcept {
+        const offset_type s = units_plus1_;
+        if (SHM_UNLIKELY(s == 0)) return nullptr;
+
+        // (s - 1) * scale + b == (b - scale) + (s << shift)
+        const detail::uptr b = Anchor::base(nullptr) - static_cast<detail::uptr>(scale());
+
+        if constexpr (std::is_signed_v<offset_type>) {
+            const detail::iptr u = static_cast<detail::iptr>(s);
+            return reinterpret_cast<pointer>(b + (static_cast<detail::uptr>(u) << scale_shift()));
+        } else {
+            return reinterpret_cast<pointer>(b + (static_cast<detail::uptr>(s) << scale_shift()));
+        }
+    }
+
+    [[nodiscard]] SHM_FORCE_INLINE offset_type raw_storage() const noexcept { return units_plus1_; }
+
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(get()); }
+    [[nodiscard]] SHM_FORCE_INLINE explicit operator bool() const noexcept { return units_plus1_ != 0; }
+
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U& operator*() const noexcept { return *get(); }
+
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U* operator->() const noexcept { return get(); }
+
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U& operator[](std::ptrdiff_t i) const noexcept {
+        return *(get() + i);
+    }
+
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    static SHM_FORCE_INLINE scaled_offset_ptr pointer_to(U& r) noexcept {
+        return scaled_offset_ptr(&r);
+    }
+
+    // Same anchor and scale: units order like addresses.
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator==(const scaled_offset_ptr& a, const scaled_offset_ptr& b) noexcept {
+        return a.units_plus1_ == b.units_plus1_;
+    }
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator==(const scaled_offset_ptr& a, std::nullptr_t) noexcept {
+        return a.units_plus1_ == 0;
+    }
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator<(const scaled_offset_ptr& a, const scaled_offset_ptr& b) noexcept {
+        if constexpr (std::is_unsigned_v<offset_type>) {
+            return a.units_plus1_ < b.units_plus1_;
+        } else {
+            return a.get() < b.get();
+        }
+    }
+
+private:
+    SHM_FORCE_INLINE void set(pointer p) noexcept {
+        if (!p) { units_plus1_ = 0; return; }
+
+        const detail::uptr b = Anchor::base(nullptr);
+        const detail::iptr diff = static_cast<detail::iptr>(detail::addr(p)) - static_cast<detail::iptr>(b);
+
+        SHM_ASSERT((static_cast<detail::uptr>(diff) & (scale() - 1)) == 0
+                   && "scaled_offset_ptr: target is not a multiple of Scale from the segment base.");
+
+        if constexpr (std::is_signed_v<offset_type>) {
+            const detail::iptr units_plus1 = (diff >> scale_shift()) + 1;
+            SHM_ASSERT(units_plus1 != 0 && "diff == -Scale would encode to 0 (reserved for null).");
+            units_plus1_ = detail::narrow_checked<offset_type>(units_plus1);
+        } else {
+            SHM_ASSERT(diff >= 0);
+            const detail::iptr units_plus1 = static_cast<detail::iptr>(static_cast<detail::uptr>(diff) >> scale_shift()) + 1;
+            units_plus1_ = detail::narrow_checked<offset_type>(units_plus1);
+        }
+    }
+
+    offset_type units_plus1_ = 0;
+};
+
+template <class T, class Tag, detail::offset_int OffsetT = std::uint32_t,
+          std::size_t Scale = scale_by_alignment>
+using scaled_segment_offset_ptr = scaled_offset_ptr<T, segment_anchor<Tag>, OffsetT, Scale>;
+
+
+// 64-bit pointer that names its segment: a 16-bit segment_id in the top bits
+// and a 48-bit "+1" byte offset below it, decoded through segment_table.
+// Raw value 0 is null. Links may cross segments as long as every process
+// registers the same id for the same segment (segment_options::table_id or
+// segment::bind_id). An id that is out of range or not registered in this
+// process decodes to null.
+template <class T>
+class fat_offset_ptr {
+public:
+    using element_type = T;
+    using pointer      = T*;
+    using reference    = std::add_lvalue_reference_t<T>;
+    using offset_type  = std::uint64_t;
+
+    static_assert(detail::is_obj_or_void_v<T>,
+                  "fat_offset_ptr<T>: T must be an object type or void.");
+
+    static constexpr unsigned      id_shift    = 48;
+    static constexpr std::uint64_t offset_mask = (std::uint64_t{1} << id_shift) - 1;
+
+    constexpr fat_offset_ptr() noexcept = default;
+    constexpr fat_offset_ptr(std::nullptr_t) noexcept : bits_(0) {}
+
+    SHM_FORCE_INLINE fat_offset_ptr(segment_id id, pointer p) noexcept { set(id, p); }
+
+    // Looks the owning segment up in segment_table (linear scan).
+    SHM_FORCE_INLINE explicit fat_offset_ptr(pointer p) noexcept {
+        if (!p) return;
+        segment_id id = 0;
+        const bool found = segment_table::find(p, id);
+        SHM_ASSERT(found && "fat_offset_ptr: pointer is not inside any registered segment.");
+        (void)found;
+        set(id, p);
+    }
+
+    template <class U>
+    requires (std::is_convertible_v<U*, T*>)
+    SHM_FORCE_INLINE fat_offset_ptr(const fat_offset_ptr<U>& other) noexcept {
+        if (other) set(other.id(), static_cast<pointer>(other.get()));
+    }
+
+    SHM_FORCE_INLINE fat_offset_ptr& operator=(std::nullptr_t) noexcept { bits_ = 0; return *this; }
+
+    [[nodiscard]] SHM_FORCE_INLINE pointer get() const noexcept {
+        const std::uint64_t s = bits_;
+        const auto id = static_cast<segment_id>(s >> id_shift);
+        if (SHM_UNLIKELY(s == 0 || !segment_table::valid(id))) return nullptr;
+        const detail::uptr bm1 = segment_table::base_minus_one(id);
+        if (SHM_UNLIKELY(bm1 == 0)) return nullptr;   // id not registered in this process
+        return reinterpret_cast<pointer>(bm1 + static_cast<detail::uptr>(s & offset_mask));
+    }
+
+    [[nodiscard]] SHM_FORCE_INLINE segment_id id() const noexcept {
+        return static_cast<segment_id>(bits_ >> id_shift);
+    }
+
+    // Byte offset within the segment; meaningless for null.
+    [[nodiscard]] SHM_FORCE_INLINE std::uint64_t offset() const noexcept {
+        return (bits_ & offset_mask) - 1;
+    }
+
+    [[nodiscard]] SHM_FORCE_INLINE std::uint64_t raw_storage() const noexcept { return bits_; }
+
+    SHM_FORCE_INLINE void prefetch() const noexcept { SHM_PREFETCH(get()); }
+    [[nodiscard]] SHM_FORCE_INLINE explicit operator bool() const noexcept { return bits_ != 0; }
+
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U& operator*() const noexcept { return *get(); }
+
+    template <class U = T>
+    requires (!std::is_void_v<U>)
+    [[nodiscard]] SHM_FORCE_INLINE U* operator->() const noexcept { return get(); }
+
+    // (id, offset) identifies the referent independently of the mapping.
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator==(const fat_offset_ptr& a, const fat_offset_ptr& b) noexcept {
+        return a.bits_ == b.bits_;
+    }
+    [[nodiscard]] friend SHM_FORCE_INLINE bool operator==(const fat_offset_ptr& a, std::nullptr_t) noexcept {
+        return a.bits_ == 0;
+    }
+
+private:
+    SHM_FORCE_INLINE void set(segment_id id, pointer p) noexcept {
+        if (!p) { bits_ = 0; return; }
+
+        const std::byte* b = segment_table::base(id);
+        SHM_ASSERT(b && "fat_offset_ptr: segment_id is not registered in segment_table.");
+        if (SHM_UNLIKELY(!b)) { bits_ = 0; return; }
+        const detail::uptr t = detail::addr(p);
+        SHM_ASSERT(t >= detail::addr(b) && t - detail::addr(b) < segment_table::size(id)
+                   && "fat_offset_ptr: pointer is outside the named segment.");
+
+        const std::uint64_t off_plus1 = static_cast<std::uint64_t>(t - detail::addr(b)) + 1;
+        SHM_ASSERT(off_plus1 <= offset_mask);
+        bits_ = (static_cast<std::uint64_t>(id) << id_shift) | off_plus1;
+    }
+
+    std::uint64_t bits_ = 0;
+};
+
+namespace detail::batch {
+    // Kernels operate on the object representation of a detached-anchor
+    // offset_ptr array (OffsetT-sized slots) and of a T* array (uptr-sized
+    // slots). Neither array holds OffsetT or uptr objects, so the scalar loops
+    // go through memcpy rather than typed loads and stores, and the vector
+    // loads use the unaligned intrinsics, which may alias anything. bm1 is
+    // (base - 1), so a non-null stored value s decodes to bm1 + s, and null is
+    // selected to zero without a branch (cmov/csel in the scalar loops, lane
+    // masks in the vector ones). The AVX-512 conversions use the explicitly
+    // masked forms because GCC 12 reports the unmasked ones' undefined
+    // pass-through operand under -Wmaybe-uninitialized.
+
+    template <class OffsetT>
+    SHM_FORCE_INLINE uptr widen(OffsetT s) noexcept {
+        if constexpr (std::is_signed_v<OffsetT>) {
+            return static_cast<uptr>(static_cast<iptr>(s));
+        } else {
+            return static_cast<uptr>(s);
+        }
+    }
+
+    template <class OffsetT>
+    SHM_FORCE_INLINE void decode_scalar(const unsigned char* src, std::size_t n, uptr bm1, unsigned char* out) noexcept {
+        for (std::size_t i = 0; i < n; ++i) {
+            OffsetT raw;
+            std::memcpy(&raw, src + i * sizeof(OffsetT), sizeof(OffsetT));
+            const uptr s = widen(raw);
+            const uptr p = s ? bm1 + s : 0;
+            std::memcpy(out + i * sizeof(uptr), &p, sizeof(uptr));
+        }
+    }
+
+    template <class OffsetT>
+    SHM_FORCE_INLINE void encode_scalar(const unsigned char* src, std::size_t n, uptr bm1, unsigned char* out) noexcept {
+        for (std::size_t i = 0; i < n; ++i) {
+            uptr p;
+            std::memcpy(&p, src + i * sizeof(uptr), sizeof(uptr));
+            const OffsetT raw = static_cast<OffsetT>(p ? p - bm1 : 0);
+            std::memcpy(out + i * sizeof(OffsetT), &raw, sizeof(OffsetT));
+        }
+    }
+
+    template <class OffsetT>
+    inline constexpr bool has_simd_kernel_v =
+        (sizeof(OffsetT) == 4 || sizeof(OffsetT) == 8);
+
+    template <class OffsetT>
+    inline void decode(const unsigned char* src, std::size_t n, uptr bm1, unsigned char* out) noexcept {
+        constexpr std::size_t in = sizeof(OffsetT), on = sizeof(uptr);
+        std::size_t i = 0;
+#if defined(SHM_SIMD_AVX512)
+        if constexpr (has_simd_kernel_v<OffsetT>) {
+            const __m512i vb = _mm512_set1_epi64(static_cast<long long>(bm1));
+            for (; i + 8 <= n; i += 8) {
+                __m512i v;
+                if constexpr (sizeof(OffsetT) == 8) {
+                    v = _mm512_loadu_si512(static_cast<const void*>(src + i * in));
+                } else if constexpr (std::is_signed_v<OffsetT>) {
+                    v = _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * in)));
+                } else {
+                    v = _mm512_maskz_cvtepu32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * in)));
+                }
+                const __mmask8 nonnull = _mm512_test_epi64_mask(v, v);
+                _mm512_storeu_si512(static_cast<void*>(out + i * on), _mm512_maskz_add_epi64(nonnull, v, vb));
+            }
+        }
+#elif defined(SHM_SIMD_AVX2)
+        if constexpr (has_simd_kernel_v<OffsetT>) {
+            const __m256i vb = _mm256_set1_epi64x(static_cast<long long>(bm1));
+            const __m256i zero = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) {
+                __m256i v;
+                if constexpr (sizeof(OffsetT) == 8) {
+                    v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * in));
+                } else if constexpr (std::is_signed_v<OffsetT>) {
+                    v = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * in)));
+                } else {
+                    v = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * in)));
+                }
+                const __m256i isnull = _mm256_cmpeq_epi64(v, zero);
+                const __m256i r = _mm256_andnot_si256(isnull, _mm256_add_epi64(v, vb));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * on), r);
+            }
+        }
+#elif defined(SHM_SIMD_NEON)
+        if constexpr (has_simd_kernel_v<OffsetT>) {
+            const uint64x2_t vb = vdupq_n_u64(static_cast<std::uint64_t>(bm1));
+            const uint64x2_t zero = vdupq_n_u64(0);
+            for (; i + 2 <= n; i += 2) {
+                uint64x2_t v;
+                if constexpr (sizeof(OffsetT) == 8) {
+                    v = vld1q_u64(reinterpret_cast<const std::uint64_t*>(src + i * in));
+                } else if constexpr (std::is_signed_v<OffsetT>) {
+                    v = vreinterpretq_u64_s64(vmovl_s32(vld1_s32(reinterpret_cast<const std::int32_t*>(src + i * in))));
+                } else {
+                    v = vmovl_u32(vld1_u32(reinterpret_cast<const std::uint32_t*>(src + i * in)));
+                }
+                const uint64x2_t isnull = vceqq_u64(v, zero);
+                vst1q_u64(reinterpret_cast<std::uint64_t*>(out + i * on), vbicq_u64(vaddq_u64(v, vb), isnull));
+            }
+        }
+#endif
+        decode_scalar<OffsetT>(src + i * in, n - i, bm1, out + i * on);
+    }
+
+    template <class OffsetT>
+    inline void encode(const unsigned char* src, std::size_t n, uptr bm1, unsigned char* out) noexcept {
+        constexpr std::size_t in = sizeof(uptr), on = sizeof(OffsetT);
+        std::size_t i = 0;
+#if defined(SHM_SIMD_AVX512)
+        if constexpr (has_simd_kernel_v<OffsetT>) {
+            const __m512i vb = _mm512_set1_epi64(static_cast<long long>(bm1));
+            for (; i + 8 <= n; i += 8) {
+                const __m512i p = _mm512_loadu_si512(static_cast<const void*>(src + i * in));
+                const __mmask8 nonnull = _mm512_test_epi64_mask(p, p);
+                const __m512i r = _mm512_maskz_sub_epi64(nonnull, p, vb);
+                if constexpr (sizeof(OffsetT) == 8) {
+                    _mm512_storeu_si512(static_cast<void*>(out + i * on), r);
+                } else {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * on),
+                                        _mm512_mask_cvtepi64_epi32(_mm256_setzero_si256(), 0xFF, r));
+                }
+            }
+        }
+#elif defined(SHM_SIMD_AVX2)
+        if constexpr (has_simd_kernel_v<OffsetT>) {
+            const __m256i vb = _mm256_set1_epi64x(static_cast<long long>(bm1));
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i lanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+            for (; i + 4 <= n; i += 4) {
+                const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * in));
+                const __m256i isnull = _mm256_cmpeq_epi64(p, zero);
+                const __m256i r = _mm256_andnot_si256(isnull, _mm256_sub_epi64(p, vb));
+                if constexpr (sizeof(OffsetT) == 8) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * on), r);
+                } else {
+                    const __m256i packed = _mm256_permutevar8x32_epi32(r, lanes);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * on), _mm256_castsi256_si128(packed));
+                }
+            }
+        }
+#elif defined(SHM_SIMD_NEON)
+        if constexpr (has_simd_kernel_v<OffsetT>) {
+            const uint64x2_t vb = vdupq_n_u64(static_cast<std::uint64_t>(bm1));
+            const uint64x2_t zero = vdupq_n_u64(0);
+            for (; i + 2 <= n; i += 2) {
+                const uint64x2_t p = vld1q_u64(reinterpret_cast<const std::uint64_t*>(src + i * in));
+                const uint64x2_t r = vbicq_u64(vsubq_u64(p, vb), vceqq_u64(p, zero));
+                if constexpr (sizeof(OffsetT) == 8) {
+                    vst1q_u64(reinterpret_cast<std::uint64_t*>(out + i * on), r);
+                } else {
+                    vst1_u32(reinterpret_cast<std::uint32_t*>(out + i * on), vmovn_u64(r));
+                }
+            }
+        }
+#endif
+        encode_scalar<OffsetT>(src + i * in, n - i, bm1, out + i * on);
+    }
+} // namespace detail::batch
+
+// Decodes n offset_ptr values into raw pointers. For detached anchors the base
+// is read once and the "+1"/null handling is branch-free (SIMD when the
+// translation unit targets AVX-512, AVX2 or NEON). Self-relative anchors fall
+// back to per-element get(), since every element has its own base.
+template <class T, class Anchor, detail::offset_int OffsetT>
+inline void decode_n(const offset_ptr<T, Anchor, OffsetT>* src, std::size_t n, T** out) noexcept {
+    if constexpr (Anchor::kSelfRelative) {
+        for (std::size_t i = 0; i < n; ++i) out[i] = src[i].get();
+    } else {
+        static_assert(sizeof(offset_ptr<T, Anchor, OffsetT>) == sizeof(OffsetT));
+        static_assert(sizeof(T*) == sizeof(detail::uptr));
+        if (n == 0) return;
+        const detail::uptr bm1 = Anchor::base(nullptr) - 1;
+        detail::batch::decode<OffsetT>(reinterpret_cast<const unsigned char*>(src), n, bm1,
+                                       reinterpret_cast<unsigned char*>(out));
+    }
+}
+
+// Encodes n raw pointers (nullptr allowed) into offset_ptr values. Range checks
+// on the narrowing only exist in the scalar path, so SHM_OFFSET_PTR_DEBUG
+// builds route through per-element assignment.
+template <class T, class Anchor, detail::offset_int OffsetT>
+inline void encode_n(T* const* src, std::size_t n, offset_ptr<T, Anchor, OffsetT>* out) noexcept {
+    if constexpr (Anchor::kSelfRelative || SHM_OFFSET_PTR_DEBUG) {
+        for (std::size_t i = 0; i < n; ++i) out[i] = src[i];
+    } else {
+        static_assert(sizeof(offset_ptr<T, Anchor, OffsetT>) == sizeof(OffsetT));
+        static_assert(std::is_trivially_copyable_v<offset_ptr<T, Anchor, OffsetT>>);
+        if (n == 0) return;
+        const detail::uptr bm1 = Anchor::base(nullptr) - 1;
+        detail::batch::encode<OffsetT>(reinterpret_cast<const unsigned char*>(src), n, bm1,
+                                       reinterpret_cast<unsigned char*>(out));
+    }
+}
+
+
+// Walks n independent chains with up to Width of them in flight at once
+// (group prefetching / AMAC). `step(chain, node)` processes one node of chain
+// `chain` (an index into heads) and returns the next node, or nullptr when the
+// chain ends. The returned node is prefetched and the walk moves on to the
+// next chain in the ring, so each load has Width - 1 other steps to complete
+// behind. Null heads are skipped. Nodes of one chain are visited in order;
+// steps of different chains interleave in no particular order.
+template <std::size_t Width = 16, class T, class Step>
+inline void interleaved_walk(T* const* heads, std::size_t n, Step&& step) {
+    static_assert(Width > 0);
+    T* cur[Width];
+    std::size_t chain[Width];
+    std::size_t next_head = 0;
+    std::size_t active = 0;
+
+    auto refill = [&](std::size_t slot) noexcept {
+        while (next_head < n) {
+            T* h = heads[next_head];
+            if (h) {
+                SHM_PREFETCH(h);
+                cur[slot] = h;
+                chain[slot] = next_head++;
+                return true;
+            }
+            ++next_head;
+        }
+        return false;
+    };
+
+    while (active < Width && refill(active)) ++active;
+
+    while (active != 0) {
+        for (std::size_t slot = 0; slot < active;) {
+            T* nx = step(chain[slot], cur[slot]);
+            if (nx) {
+                SHM_PREFETCH(nx);
+                cur[slot] = nx;
+                ++slot;
+            } else if (refill(slot)) {
+                ++slot;
+            } else {
+                // Close the gap with the last live slot; it is stepped next.
+                --active;
+                cur[slot] = cur[active];
+                chain[slot] = chain[active];
+            }
+        }
+    }
+}
+
+// Describes the link fields of a segment-resident type. Specialize with a
+// tuple of pointers to the members that are pointer species (offset_ptr,
+// tagged_offset_ptr, ...):
+//
+//   template <> struct shm::link_fields<Node> {
+//       static constexpr auto value = std::make_tuple(&Node::left, &Node::right);
+//   };
+//
+// Graph utilities (swizzle, unswizzle) use it to enumerate outgoing links.
+template <class T>
+struct link_fields;
+
+template <class T>
+concept has_link_fields = requires { std::tuple_size<std::remove_cvref_t<decltype(link_fields<T>::value)>>::value; };
+
+template <class T>
+requires has_link_fields<T>
+inline constexpr std::size_t link_count_v =
+    std::tuple_size_v<std::remove_cvref_t<decltype(link_fields<T>::value)>>;
+
+namespace detail {
+    template <class T, class Fn>
+    SHM_FORCE_INLINE void for_each_link_field(Fn&& fn) {
+        std::apply([&](auto... field) {
+            std::size_t i = 0;
+            (fn(i++, field), ...);
+        }, link_fields<T>::value);
+    }
+
+    template <class Field>
+    using link_target_t = std::remove_cv_t<typename Field::element_type>;
+
+    // Stores p into any pointer species; tagged pointers keep their tag.
+    template <class Field, class P>
+    SHM_FORCE_INLINE void assign_link(Field& f, P* p) noexcept {
+        if constexpr (requires { f.set_ptr(p); }) {
+            f.set_ptr(p);
+        } else if (p) {
+            f = Field(p);
+        } else {
+            f = nullptr;
+        }
+    }
+} // namespace detail
+
+// Private, raw-pointer copy of one node of a swizzled graph. `value` is a
+// bytewise copy of the segment object; its link fields are not meaningful
+// here and `links` (in link_fields order) must be used instead.
+template <class T>
+struct swizzled_node {
+    T value;
+    swizzled_node* links[link_count_v<T>];
+    T* origin;
+};
+
+// Nodes reachable from a root, copied out of the segment. Node storage is
+// contiguous and stable for the lifetime of the graph; root() is nodes()[0].
+template <class T>
+class swizzled_graph {
+public:
+    using node = swizzled_node<T>;
+
+    [[nodiscard]] node* root() noexcept { return nodes_.empty() ? nullptr : nodes_.data(); }
+    [[nodiscard]] const node* root() const noexcept { return nodes_.empty() ? nullptr : nodes_.data(); }
+    [[nodiscard]] std::size_t size() const noexcept { return nodes_.size(); }
+    [[nodiscard]] node* begin() noexcept { return nodes_.data(); }
+    [[nodiscard]] node* end() noexcept { return nodes_.data() + nodes_.size(); }
+    [[nodiscard]] const node* begin() const noexcept { return nodes_.data(); }
+    [[nodiscard]] const node* end() const noexcept { return nodes_.data() + nodes_.size(); }
+
+private:
+    template <class U> friend swizzled_graph<U> swizzle(U* root);
+    std::vector<node> nodes_;
+};
+
+// Copies the subgraph reachable from `root` into private memory, decoding
+// every link once. The graph must be homogeneous: each link field points to
+// T. Shared nodes and cycles are preserved. Requires the segment's anchors to
+// be usable (bases bound) for the duration of the call.
+template <class T>
+swizzled_graph<T> swizzle(T* root) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "swizzle<T>: T must be trivially copyable (use detached or self_reloc anchors).");
+    swizzled_graph<T> g;
+    if (!root) return g;
+
+    std::unordered_map<const T*, std::size_t> index;
+    std::vector<T*> order;
+    index.emplace(root, 0);
+    order.push_back(root);
+
+    // Pass 1: discover nodes breadth-first.
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        T* src = order[i];
+        detail::for_each_link_field<T>([&](std::size_t, auto field) {
+            using F = std::remove_cvref_t<decltype(src->*field)>;
+            static_assert(std::is_same_v<detail::link_target_t<F>, T>,
+                          "swizzle<T>: every link field must point to T.");
+            T* dst = (src->*field).get();
+            if (dst && index.emplace(dst, order.size()).second) order.push_back(dst);
+        });
+    }
+
+    // Pass 2: copy and resolve links to private addresses.
+    g.nodes_.resize(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        T* src = order[i];
+        auto& n = g.nodes_[i];
+        std::memcpy(static_cast<void*>(&n.value), src, sizeof(T));
+        n.origin = src;
+        detail::for_each_link_field<T>([&](std::size_t k, auto field) {
+            T* dst = (src->*field).get();
+            n.links[k] = dst ? &g.nodes_[index.find(dst)->second] : nullptr;
+        });
+    }
+    return g;
+}
+
+// Publishes a swizzled graph back to its segment objects: each node's value
+// is copied back to its origin and its link fields are re-encoded from
+// `links`. Links may be rewired to any node of the same graph (or null);
+// nodes cannot be added. Callers must exclude concurrent readers of the
+// affected objects.
+template <class T>
+void unswizzle(const swizzled_graph<T>& g) {
+    for (const auto& n : g) {
+        std::memcpy(static_cast<void*>(n.origin), &n.value, sizeof(T));
+        detail::for_each_link_field<T>([&](std::size_t k, auto field) {
+            detail::assign_link(n.origin->*field, n.links[k] ? n.links[k]->origin : nullptr);
+        });
+    }
+}
+
+namespace detail::reloc {
+    // How relocate_range() fixes a link field. Detached species need nothing;
+    // self-relative offset_ptr / offset_ref and their atomic counterparts store
+    // field-relative offsets that must be shifted when their target stays
+    // behind. Every field species is listed; anything else is a compile error.
+    template <class F>
+    inline constexpr bool unknown_field_v = false;
+
+    template <class F>
+    struct field_codec {
+        static_assert(unknown_field_v<F>,
+                      "relocate_range: link_fields names a field type with no field_codec "
+                      "(the type is the F of this field_codec<F> instantiation).");
+        static constexpr bool fix = false;
+        static constexpr bool supported = false;
+    };
+
+    template <class U, class A, offset_int O>
+    struct field_codec<offset_ptr<U, A, O>> {
+        static constexpr bool fix = A::kSelfRelative;
+        static constexpr bool supported = true;
+        static constexpr bool nullable = true;
+        static constexpr bool atomic = false;
+        using offset_type = O;
+    };
+
+    template <class U, class A, offset_int O>
+    struct field_codec<offset_ref<U, A, O>> {
+        static constexpr bool fix = A::kSelfRelative;
+        static constexpr bool supported = true;
+        static constexpr bool nullable = false;
+        static constexpr bool atomic = false;
+        using offset_type = O;
+    };
+
+    // The atomic species hold a single std::atomic word as their only member,
+    // so the field address is the word's address. The offset sits in the low
+    // bits; atomic_tagged_offset_ptr keeps its tag above it.
+    template <class U, class A, offset_int O>
+    struct field_codec<atomic_offset_ptr<U, A, O>> {
+        static constexpr bool fix = A::kSelfRelative;
+        static constexpr bool supported = true;
+        static constexpr bool nullable = true;
+        static constexpr bool atomic = true;
+        using offset_type = O;
+        using word_type = O;
+        static constexpr O offset(O w) noexcept { return w; }
+        static constexpr O with_offset(O, O s) noexcept { return s; }
+    };
+
+    template <class U, class A, offset_int O>
+    struct field_codec<atomic_tagged_offset_ptr<U, A, O>> {
+        static constexpr bool fix = A::kSelfRelative;
+        static constexpr bool supported = true;
+        static constexpr bool nullable = true;
+        static constexpr bool atomic = true;
+        using offset_type = O;
+        using word_type = std::uint64_t;
+        using uoffset_type = std::make_unsigned_t<O>;
+        static constexpr std::uint64_t offset_mask = static_cast<uoffset_type>(-1);
+        static constexpr O offset(std::uint64_t w) noexcept {
+            return static_cast<O>(static_cast<uoffset_type>(w));
+        }
+        static constexpr std::uint64_t with_offset(std::uint64_t w, O s) noexcept {
+            return (w & ~offset_mask) | static_cast<uoffset_type>(s);
+        }
+    };
+
+    template <class U, unsigned B, class A, offset_int O>
+    struct field_codec<tagged_offset_ptr<U, B, A, O>> {
+        static constexpr bool fix = false;
+        static constexpr bool supported = !A::kSelfRelative;
+    };
+
+    // Detached species: the stored value does not depend on the field address.
+    template <class U, class A, offset_int O, std::size_t S>
+    struct field_codec<scaled_offset_ptr<U, A, O, S>> {
+        static constexpr bool fix = false;
+        static constexpr bool supported = true;
+    };
+
+    template <class U>
+    struct field_codec<fat_offset_ptr<U>> {
+        static constexpr bool fix = false;
+        static constexpr bool supported = true;
+    };
+
+    // Branch-free fix-up of one stored offset `s` of a field at byte `pos` of
+    // the moved range. The target sat at (range start) + pos + s - bias (bias 1
+    // for the "+1" encoding). Targets outside the range did not move, so their
+    // offset shrinks by `delta`. Null (s == 0) is kept.
+    template <class O, bool Nullable>
+    SHM_FORCE_INLINE O fixed_offset(O s, uptr pos, uptr len, iptr delta) noexcept {
+        constexpr iptr bias = Nullable ? 1 : 0;
+        const uptr rel = pos + static_cast<uptr>(static_cast<iptr>(s) - bias);
+        iptr adj = (rel >= len) ? -delta : 0;
+        if constexpr (Nullable) adj = (s == 0) ? 0 : adj;
+        return narrow_checked<O>(static_cast<iptr>(s) + adj);
+    }
+
+    template <class O, bool Nullable>
+    SHM_FORCE_INLINE void fix_field(std::byte* f, uptr pos, uptr len, iptr delta) noexcept {
+        O s;
+        std::memcpy(&s, f, sizeof(O));
+        const O fixed = fixed_offset<O, Nullable>(s, pos, len, delta);
+        std::memcpy(f, &fixed, sizeof(O));
+    }
+
+    // The moved range is not shared while it is being relocated, so relaxed
+    // ordering is enough; the word is still accessed only atomically.
+    template <class Codec>
+    SHM_FORCE_INLINE void fix_atomic_field(std::byte* f, uptr pos, uptr len, iptr delta) noexcept {
+        using W = typename Codec::word_type;
+        auto* word = reinterpret_cast<std::atomic<W>*>(f);
+        const W w = word->load(std::memory_order_relaxed);
+        const auto s = fixed_offset<typename Codec::offset_type, Codec::nullable>(
+            Codec::offset(w), pos, len, delta);
+        word->store(Codec::with_offset(w, s), std::memory_order_relaxed);
+    }
+
+    template <class T>
+    SHM_FORCE_INLINE void fix_element(std::byte* first, std::size_t i, uptr len, iptr delta) noexcept {
+        T* e = reinterpret_cast<T*>(first) + i;
+        for_each_link_field<T>([&](std::size_t, auto field) {
+            using F = std::remove_cvref_t<decltype(e->*field)>;
+            using codec = field_codec<F>;
+            static_assert(codec::supported,
+                          "relocate_range: unsupported link field (self-relative tagged pointers cannot be fixed).");
+            if constexpr (codec::fix) {
+                auto* f = reinterpret_cast<std::byte*>(&(e->*field));
+                if constexpr (codec::atomic) {
+                    fix_atomic_field<codec>(f, static_cast<uptr>(f - first), len, delta);
+                } else {
+                    fix_field<typename codec::offset_type, codec::nullable>(
+                        f, static_cast<uptr>(f - first), len, delta);
+                }
+            }
+        });
+    }
+} // namespace detail::reloc
+
+// Moves n objects from src to dst (ranges may overlap) bytewise and repairs
+// the self-relative link fields listed in link_fields<T>: links into the
+// moved range move with it, links out of it are re-aimed at their unchanged
+// targets. Disjoint ranges are copied and fixed element by element in one
+// pass; overlapping ranges take a memmove and then a fix-up pass. After the
+// call the objects live at dst and src is raw storage; no constructors or
+// destructors run, so T's other members must be trivially relocatable.
+// Supports offset_ptr, offset_ref, atomic_offset_ptr and
+// atomic_tagged_offset_ptr fields with any anchor, plus scaled and fat
+// pointers; tagged pointers must use a detached anchor.
+template <class T>
+requires has_link_fields<T>
+inline void relocate_range(T* dst, T* src, std::size_t n) noexcept {
+    if (n == 0 || dst == src) return;
+    const detail::uptr lo = detail::addr(src);
+    const detail::uptr len = n * sizeof(T);
+    const detail::iptr delta = static_cast<detail::iptr>(detail::addr(dst)) - static_cast<detail::iptr>(lo);
+
+    auto* d = reinterpret_cast<std::byte*>(dst);
+    const auto* sb = reinterpret_cast<const std::byte*>(src);
+    const bool overlap = (detail::addr(dst) - lo) < len || (lo - detail::addr(dst)) < len;
+
+    if (!overlap) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::memcpy(d + i * sizeof(T), sb + i * sizeof(T), sizeof(T));
+            detail::reloc::fix_element<T>(d, i, len, delta);
+        }
+    } else {
+        std::memmove(d, sb, len);
+        for (std::size_t i = 0; i < n; ++i) detail::reloc::fix_element<T>(d, i, len, delta);
+    }
+}
+
+// Outcome of verify_graph(). Converts to true when the graph is valid.
+struct verify_result {
+    enum class error : std::uint8_t {
+        none,
+        out_of_range,   // object not entirely inside [base, base + size)
+        misaligned,     // object address not aligned for its type
+        cycle,          // back edge found while cycles are disallowed
+        too_many,       // more than verify_options::max_objects objects
+    };
+
+    error code = error::none;
+    const void* where = nullptr;  // offending object address, if any
+    std::size_t objects = 0;      // distinct objects checked
+    std::size_t links = 0;        // non-null links followed
+    std::size_t bytes = 0;        // sum of sizeof over checked objects
+
+    [[nodiscard]] explicit operator bool() const noexcept { return code == error::none; }
+};
+
+struct verify_options {
+    bool allow_cycles = false;
+    std::size_t max_objects = static_cast<std::size_t>(-1);
+};
+
+namespace detail::verify {
+    struct node_desc;
+    using link_fn = void (*)(const void* obj, std::size_t k, const void*& target, const node_desc*& desc) noexcept;
+
+    struct node_desc {
+        std::size_t size;
+        std::size_t align;
+        std::size_t links;
+        link_fn link;
+    };
+
+    template <class F>
+    SHM_FORCE_INLINE const void* decode_link(const F& f) noexcept {
+        if constexpr (requires { f.address(); }) return f.address();
+        else return f.get();
+    }
+
+    template <class U>
+    struct desc_of;
+
+    template <class U>
+    inline constexpr node_desc desc_v = desc_of<std::remove_cv_t<U>>::make();
+
+    template <class U>
+    struct desc_of {
+        static void link(const void* obj, std::size_t k, const void*& target, const node_desc*& desc) noexcept {
+            if constexpr (has_link_fields<U>) {
+                const U* o = static_cast<const U*>(obj);
+                for_each_link_field<U>([&](std::size_t i, auto field) {
+                    if (i != k) return;
+                    using F = std::remove_cvref_t<decltype(o->*field)>;
+                    target = decode_link(o->*field);
+                    desc = &desc_v<typename F::element_type>;
+                });
+            } else {
+                (void)obj; (void)k; target = nullptr; desc = nullptr;
+            }
+        }
+
+        static constexpr node_desc make() noexcept {
+            if constexpr (std::is_void_v<U>) {
+                return {1, 1, 0, &link};
+            } else if constexpr (has_link_fields<U>) {
+                return {sizeof(U), alignof(U), link_count_v<U>, &link};
+            } else {
+                return {sizeof(U), alignof(U), 0, &link};
+            }
+        }
+    };
+
+    struct frame {
+        const void* obj;
+        const node_desc* desc;
+        std::size_t next;
+        std::size_t slot;        // colour slot, valid while gen matches
+        std::size_t gen;
+    };
+
+    // Open-addressing address -> colour map. One probe per discovered link;
+    // a node-based map costs several cache misses per object instead.
+    class colour_map {
+    public:
+        explicit colour_map(std::size_t expected) {
+            std::size_t cap = 64;
+            while (cap < expected * 2) cap <<= 1;
+            keys_.assign(cap, 0);
+            vals_.assign(cap, 0);
+        }
+
+        // Slot of `a`, inserting it with colour 0 if absent.
+        std::size_t lookup(uptr a) {
+            if ((used_ + 1) * 2 > keys_.size()) grow();
+            std::size_t i = hash(a);
+            while (keys_[i] != 0 && keys_[i] != a) i = (i + 1) & (keys_.size() - 1);
+            if (keys_[i] == 0) { keys_[i] = a; ++used_; }
+            return i;
+        }
+
+        std::uint8_t& at(std::size_t slot) noexcept { return vals_[slot]; }
+        std::size_t generation() const noexcept { return gen_; }
+
+    private:
+        std::size_t hash(uptr a) const noexcept {
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(a) * 0x9E3779B97F4A7C15ull) >> 32)
+                   & (keys_.size() - 1);
+        }
+
+        void grow() {
+            std::vector<uptr> k(keys_.size() * 2, 0);
+            std::vector<std::uint8_t> v(keys_.size() * 2, 0);
+            k.swap(keys_);
+            v.swap(vals_);
+            used_ = 0;
+            ++gen_;
+            for (std::size_t i = 0; i < k.size(); ++i) {
+                if (k[i] != 0) vals_[lookup(k[i])] = v[i];
+            }
+        }
+
+        std::vector<uptr> keys_;
+        std::vector<std::uint8_t> vals_;
+        std::size_t used_ = 0;
+        std::size_t gen_ = 0;
+    };
+
+    inline verify_result run(const void* base, std::size_t size, const void* root, const node_desc* root_desc,
+                             const verify_options& opt) {
+        verify_result r;
+        if (!root) return r;
+
+        const uptr lo = addr(base);
+        enum : std::uint8_t { white = 0, grey = 1, black = 2 };
+        colour_map colour(size / 64);
+        std::vector<frame> stack;
+
+        // Range and alignment are checked before any byte of the object is read.
+        auto admit = [&](const void* p, const node_desc* d, std::size_t slot) -> bool {
+            const uptr a = addr(p);
+            if (a - lo >= size || d->size > size - (a - lo)) {
+                r.code = verify_result::error::out_of_range; r.where = p; return false;
+            }
+            if ((a & (d->align - 1)) != 0) {
+                r.code = verify_result::error::misaligned; r.where = p; return false;
+            }
+            if (r.objects == opt.max_objects) {
+                r.code = verify_result::error::too_many; r.where = p; return false;
+            }
+            ++r.objects;
+            r.bytes += d->size;
+            colour.at(slot) = grey;
+            stack.push_back({p, d, 0, slot, colour.generation()});
+            return true;
+        };
+
+        if (!admit(root, root_desc, colour.lookup(addr(root)))) return r;
+
+        while (!stack.empty()) {
+            frame& f = stack.back();
+            if (f.next == f.desc->links) {
+                const std::size_t slot = (f.gen == colour.generation()) ? f.slot : colour.lookup(addr(f.obj));
+                colour.at(slot) = black;
+                stack.pop_back();
+                continue;
+            }
+            const void* target = nullptr;
+            const node_desc* td = nullptr;
+            f.desc->link(f.obj, f.next++, target, td);
+            if (!target) continue;
+            ++r.links;
+
+            const std::size_t slot = colour.lookup(addr(target));
+            const std::uint8_t c = colour.at(slot);
+            if (c == white) {
+                if (!admit(target, td, slot)) return r;
+            } else if (c == grey && !opt.allow_cycles) {
+                r.code = verify_result::error::cycle;
+                r.where = target;
+                return r;
+            }
+        }
+        return r;
+    }
+} // namespace detail::verify
+
+// Checks, in one pass over the graph reachable from `root`, that every object
+// lies entirely inside [base, base + size) and is aligned for its type, and
+// (unless allowed) that there are no cycles. Link fields come from
+// link_fields<T> of each visited type; types without the trait are leaves.
+// Each object is checked before any of its fields is read, so a corrupt
+// offset is reported instead of followed. Anchors (segment bases) must be
+// bound to the mapping being checked. Shared sub-objects are visited once.
+template <class T>
+[[nodiscard]] verify_result verify_graph(const void* base, std::size_t size, const T* root,
+                                         const verify_options& opt = {}) {
+    return detail::verify::run(base, size, root, &detail::verify::desc_v<T>, opt);
+}
+
+// Kernel advice for a range of mapped memory (madvise). Everything except
+// dontneed widens the range outward to whole pages; dontneed shrinks it to
+// the pages fully inside, so bytes outside the range are never dropped.
+enum class advice : std::uint8_t {
+    normal,           // undo sequential/random
+    willneed,         // start reading the range in
+    sequential,       // aggressive read-ahead, drop pages behind
+    random,           // no read-ahead
+    cold,             // reclaim first under pressure (Linux 5.4+)
+    pageout,          // reclaim now; contents stay (Linux 5.4+)
+    // Drop this process's page mappings. Shared mappings refault from the
+    // object. On Linux private mappings lose their changes (anonymous ones
+    // read back as zero); other systems may keep the data.
+    dontneed,
+    populate_read,    // fault in readable now (Linux 5.14+)
+    populate_write,   // fault in writable now (Linux 5.14+)
+    mergeable,        // KSM; only private anonymous memory is merged
+};
+
+// Applies `a` to [addr, addr + len). Returns the madvise errno, or
+// errc::not_supported where the platform or headers lack the advice
+// (always on Windows, apart from advice::normal).
+inline std::error_code advise(void* addr, std::size_t len, advice a) noexcept;
+
+template <class Tag, detail::offset_int OffsetT = std::uint32_t>
+class linear_allocator {
+public:
+    using tag_type    = Tag;
+    using offset_type = OffsetT;
+
+    template <class T>
+    using handle = shm::segment_offset_ptr<T, Tag, OffsetT>;
+
+    using void_handle = handle<void>;
+
+    linear_allocator(void* start, std::size_t size) noexcept
+        : linear_allocator(start, start, size)
+    {}
+
+    linear_allocator(void* segment_base, void* arena_start, std::size_t arena_size) noexcept
+        : arena_(reinterpret_cast<std::byte*>(arena_start))
+        , arena_addr_(reinterpret_cast<std::uintptr_t>(arena_start))
+        , capacity_(arena_size)
+        , cursor_(0)
+    {
+
+        shm::segment_base<Tag>::set(segment_base);
+    }
+
+    linear_allocator(const linear_allocator&) = delete;
+    linear_allocator& operator=(const linear_allocator&) = delete;
+    linear_allocator(linear_allocator&&) = delete;
+    linear_allocator& operator=(linear_allocator&&) = delete;
+
+    [[nodiscard]] void* alloc(std::size_t n,
+                              std::size_t alignment = alignof(std::max_align_t)) noexcept
+    {
+        if (n == 0) return nullptr;
+        if (alignment == 0) alignment = 1;
+
+        const bool pow2 = (alignment & (alignment - 1)) == 0;
+
+        std::size_t cur = cursor_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (cur > capacity_) return nullptr;
+
+            const std::uintptr_t addr = arena_addr_ + static_cast<std::uintptr_t>(cur);
+            std::uintptr_t aligned_addr;
+
+            if (pow2) {
+                const std::uintptr_t mask = static_cast<std::uintptr_t>(alignment - 1);
+                aligned_addr = (addr + mask) & ~mask;
+            } else {
+                const std::uintptr_t a = static_cast<std::uintptr_t>(alignment);
+                const std::uintptr_t rem = addr % a;
+                aligned_addr = (rem == 0) ? addr : (addr + (a - rem));
+            }
+
+            const std::uintptr_t aligned_off_u = aligned_addr - arena_addr_;
+            if (aligned_off_u > static_cast<std::uintptr_t>(capacity_)) return nullptr;
+
+            const std::size_t aligned_off = static_cast<std::size_t>(aligned_off_u);
+            if (n > capacity_ - aligned_off) return nullptr;
+
+            const std::size_t next = aligned_off + n;
+
+            if (cursor_.compare_exchange_weak(
+                    cur, next,
+                    std::memory_order_acq_rel,
+                    std::memory_order_relaxed))
+            {
+                return arena_ + aligned_off;
+            }
+        }
+    }
+
+    [[nodiscard]] void_handle alloc_handle(std::size_t n,
+                                           std::size_t alignment = alignof(std::max_align_t)) noexcept
+    {
+        void* p = alloc(n, alignment);
+        if (!p) return void_handle(nullptr);
+        return void_handle(static_cast<void*>(p));
+    }
+
+    template <class T>
+    [[nodiscard]] T* allocate(std::size_t count = 1) noexcept {
+        static_assert(!std::is_void_v<T>, "allocate<void> is not meaningful.");
+        if (count == 0) return nullptr;
+        if (count > (std::numeric_limits<std::size_t>::max() / sizeof(T))) return nullptr;
+        return static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+    }
+
+    template <class T>
+    [[nodiscard]] handle<T> allocate_handle(std::size_t count = 1) noexcept {
+        T* p = allocate<T>(count);
+        if (!p) return handle<T>(nullptr);
+        return handle<T>(p);
+    }
+
+    template <class T, class... Args>
+    [[nodiscard]] handle<T> make_handle(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        void* mem = alloc(sizeof(T), alignof(T));
+        if (!mem) return handle<T>(nullptr);
+        T* obj = ::new (mem) T(std::forward<Args>(args)...);
+        return handle<T>(obj);
+    }
+
+    void reset() noexcept {
+        cursor_.store(0, std::memory_order_release);
+    }
+
+    void secure_reset() noexcept {
+        const std::size_t u = used();
+        if (u) std::memset(arena_, 0, u);
+        cursor_.store(0, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::size_t used() const noexcept {
+        return cursor_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+
+    [[nodiscard]] bool owns(const void* p) const noexcept {
+        const auto x = reinterpret_cast<std::uintptr_t>(p);
+        return x >= arena_addr_ && x < (arena_addr_ + static_cast<std::uintptr_t>(capacity_));
+    }
+
+    // Advice for [offset, offset + len) of the arena, clamped to capacity().
+    std::error_code advise(std::size_t offset, std::size_t len, shm::advice a) const noexcept {
+        if (offset >= capacity_) return {};
+        return shm::advise(arena_ + offset, (std::min)(len, capacity_ - offset), a);
+    }
+
+    // Advice for everything allocated so far, e.g. advice::pageout for a
+    // log's history or advice::willneed before a scan.
+    std::error_code advise(shm::advice a) const noexcept { return advise(0, used(), a); }
+
+       template <class T>
+    struct stl_allocator {
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using pointer            = handle<T>;
+    using const_pointer      = handle<const T>;
+    using void_pointer       = void_handle;
+    using const_void_pointer = handle<const void>;
+
+    handle<linear_allocator> arena = handle<linear_allocator>(nullptr);
+
+    stl_allocator() noexcept = default;
+    explicit stl_allocator(linear_allocator& a) noexcept : arena(&a) {}
+
+    template <class U>
+    stl_allocator(const stl_allocator<U>& other) noexcept : arena(other.arena) {}
+
+    [[nodiscard]] pointer allocate(size_type n) {
+        if (n == 0) return pointer(nullptr);
+        if (!arena) throw std::bad_alloc();
+        if (n > (std::numeric_limits<size_type>::max)() / sizeof(T)) throw std::bad_alloc();
+
+        linear_allocator* a = arena.get();
+        void* p = a->alloc(sizeof(T) * n, alignof(T));
+        if (!p) throw std::bad_alloc();
+        return pointer(static_cast<T*>(p));
+    }
+
+    void deallocate(pointer, size_type) noexcept {}
+
+    template <class U>
+    struct rebind { using other = stl_allocator<U>; };
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+    using is_always_equal                        = std::false_type;
+
+    template <class U>
+    friend struct stl_allocator;
+
+    template <class U>
+    friend bool operator==(const stl_allocator& a, const stl_allocator<U>& b) noexcept {
+        return a.arena == b.arena;
+    }
+    template <class U>
+    friend bool operator!=(const stl_allocator& a, const stl_allocator<U>& b) noexcept {
+        return !(a == b);
+    }
+};
+
+private:
+    std::byte* arena_ = nullptr;
+    std::uintptr_t arena_addr_ = 0;
+    std::size_t capacity_ = 0;
+    std::atomic<std::size_t> cursor_{0};
+
+};
+
+namespace detail::seg {
+
+
+static inline std::string normalize_name_(const char* name) {
+    if (!name || !*name) return {};
+    std::string s(name);
+    if (s[0] != '/') s.insert(s.begin(), '/');
+    while (s.size() > 1 && s.back() == '/') s.pop_back();
+    return s;
+}
+
+static inline std::size_t page_size_() noexcept {
+#if SHM_PLATFORM_WIN32
+    SYSTEM_INFO si{};
+    ::GetSystemInfo(&si);
+    std::size_t ps = static_cast<std::size_t>(si.dwPageSize);
+    return ps ? ps : 4096u;
+#else
+    long ps = ::sysconf(_SC_PAGESIZE);
+    if (ps <= 0) ps = 4096;
+    return static_cast<std::size_t>(ps);
+#endif
+}
+
+
+static inline std::size_t round_up_(std::size_t x, std::size_t a) noexcept {
+    if (a == 0) return x;
+    const std::size_t r = x % a;
+    return r == 0 ? x : (x + (a - r));
+}
+
+#if !SHM_PLATFORM_WIN32
+
+template <class Fn, class... Args>
+static inline auto retry_eintr_call_(Fn fn, Args... args) noexcept -> decltype(fn(args...)) {
+    for (;;) {
+        auto rc = fn(args...);
+        if (rc == decltype(rc)(-1) && errno == EINTR) continue;
+        return rc;
+    }
+}
+
+// POSIX shm name rules in practice must start with '/', must not contain any other '/'.
+// SInce platforms are more permissive, we enforce the strict portable subset.
+static inline bool name_is_portable_(std::string_view s) noexcept {
+    if (s.empty()) return false;
+    if (s[0] != '/') return false;
+    if (s.size() == 1) return false;
+    for (std::size_t i = 1; i < s.size(); ++i) {
+        const char c = s[i];
+        if (c == '/') return false;
+        if (c == '\0') return false;
+    }
+    return true;
+}
+
+
+static inline void nanosleep_backoff_(std::size_t attempt) noexcept {
+    // attempt=0.. => 100us, 200us, 400us ... capped at 10ms
+    const std::size_t max_ns = 10ull * 1000ull * 1000ull;
+    std::size_t ns = 100ull * 1000ull;
+    if (attempt < 10) ns <<= attempt;
+    if (ns > max_ns) ns = max_ns;
+    timespec ts{};
+    ts.tv_sec = 0;
+    ts.tv_nsec = static_cast<long>(ns);
+    ::nanosleep(&ts, nullptr);
+}
+
+[[nodiscard]] static inline std::uint64_t monotonic_ms_() noexcept {
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000u + static_cast<std::uint64_t>(ts.tv_nsec) / 1000000u;
+}
+
+// Blocks while the shared word equals `value`, up to timeout_ms; returns the
+// last value seen. On Linux this is a process-shared FUTEX_WAIT on the word,
+// elsewhere a sleep backoff.
+static inline std::uint32_t wait_while_(std::uint32_t* word, std::uint32_t value, std::uint32_t timeout_ms) noexcept {
+    std::atomic_ref<std::uint32_t> w(*word);
+    const std::uint64_t deadline = monotonic_ms_() + timeout_ms;
+    for (std::size_t attempt = 0;; ++attempt) {
+        const std::uint32_t v = w.load(std::memory_order_acquire);
+        if (v != value) return v;
+        const std::uint64_t now = monotonic_ms_();
+        if (now >= deadline) return v;
+#if defined(__linux__)
+        const std::uint64_t left = deadline - now;
+        timespec rel{};
+        rel.tv_sec = static_cast<time_t>(left / 1000u);
+        rel.tv_nsec = static_cast<long>((left % 1000u) * 1000000u);
+        (void)::syscall(SYS_futex, word, FUTEX_WAIT, value, &rel, nullptr, 0);
+#else
+        nanosleep_backoff_(attempt);
+#endif
+    }
+}
+
+static inline std::uint32_t wait_nonzero_(std::uint32_t* word, std::uint32_t timeout_ms) noexcept {
+    return wait_while_(word, 0, timeout_ms);
+}
+
+static inline void wake_all_(std::uint32_t* word) noexcept {
+#if defined(__linux__)
+    (void)::syscall(SYS_futex, word, FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+#if defined(__linux__)
+// Page size of the hugetlbfs mount fd lives on (including the internal mount
+// behind memfd_create(MFD_HUGETLB)), or 0 if it is not on hugetlbfs.
+static inline std::size_t hugetlbfs_page_(int fd) noexcept {
+    struct statfs sfs{};
+    if (::fstatfs(fd, &sfs) != 0) return 0;
+    constexpr unsigned long kHugetlbfsMagic = 0x958458f6ul;
+    if (static_cast<unsigned long>(sfs.f_type) != kHugetlbfsMagic) return 0;
+    return static_cast<std::size_t>(sfs.f_bsize);
+}
+
+// Bytes of [base, base + len) backed by huge pages, THP or hugetlb, summed
+// over the overlapping VMAs in /proc/self/smaps. 0 if smaps is unreadable.
+static inline std::size_t smaps_huge_bytes_(const void* base, std::size_t len) noexcept {
+    std::FILE* f = std::fopen("/proc/self/smaps", "re");
+    if (!f) return 0;
+
+    const unsigned long long lo = detail::addr(base);
+    const unsigned long long hi = lo + len;
+    bool inside = false;
+    unsigned long long kb = 0;
+    char line[512];
+    while (std::fgets(line, sizeof(line), f)) {
+        unsigned long long a = 0, b = 0;
+        if (std::sscanf(line, "%llx-%llx ", &a, &b) == 2) {
+            inside = (a < hi && b > lo);
+            continue;
+        }
+        if (!inside) continue;
+
+        char key[64];
+        unsigned long long v = 0;
+        if (std::sscanf(line, "%63[^:]: %llu kB", key, &v) != 2) continue;
+        const std::string_view k(key);
+        if (k == "AnonHugePages" || k == "ShmemPmdMapped" || k == "FilePmdMapped" ||
+            k == "Shared_Hugetlb" || k == "Private_Hugetlb") {
+            kb += v;
+        }
+    }
+    std::fclose(f);
+    return static_cast<std::size_t>(kb * 1024u);
+}
+#endif
+
+#endif
+
+#if SHM_PLATFORM_WIN32
+    [[nodiscard]] SHM_FORCE_INLINE DWORD last_error() noexcept {
+        return ::GetLastError();
+    }
+
+    // Cross-process waits on a shared word have no futex equivalent here
+    // (WaitOnAddress is process-local), so readiness is polled.
+    inline std::uint32_t wait_while_(std::uint32_t* word, std::uint32_t value, std::uint32_t timeout_ms) noexcept {
+        std::atomic_ref<std::uint32_t> w(*word);
+        const ULONGLONG deadline = ::GetTickCount64() + timeout_ms;
+        for (std::size_t attempt = 0;; ++attempt) {
+            const std::uint32_t v = w.load(std::memory_order_acquire);
+            if (v != value) return v;
+            if (::GetTickCount64() >= deadline) return v;
+            ::Sleep(attempt < 16 ? 0 : 1);
+        }
+    }
+
+    inline std::uint32_t wait_nonzero_(std::uint32_t* word, std::uint32_t timeout_ms) noexcept {
+        return wait_while_(word, 0, timeout_ms);
+    }
+
+    inline void wake_all_(std::uint32_t*) noexcept {}
+
+    [[nodiscard]] inline std::system_error win32_error(const char* op,
+                                                       std::string_view portable_name,
+                                                       DWORD err) {
+        if (err == 0) err = ERROR_GEN_FAILURE;
+        std::error_code ec(static_cast<int>(err), std::system_category());
+
+        std::string msg;
+        msg.reserve(320);
+        msg.append("shm::segment: ");
+        msg.append(op);
+        msg.append(" failed (name=");
+        msg.append(portable_name.data(), portable_name.size());
+        msg.append(", GetLastError=");
+        msg.append(std::to_string(static_cast<unsigned long>(err)));
+        msg.append(", ");
+        msg.append(ec.message());
+        msg.append(")");
+
+        return std::system_error(ec, msg);
+    }
+    [[nodiscard]] inline std::wstring utf8_to_wstring_strict(std::string_view s) {
+        if (s.empty()) return std::wstring();
+
+        if (s.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+            throw win32_error("utf8_to_wstring(length overflow)", s, ERROR_INVALID_PARAMETER);
+        }
+
+        const int src_len = static_cast<int>(s.size());
+        constexpr DWORD flags = MB_ERR_INVALID_CHARS;
+
+        int needed = ::MultiByteToWideChar(CP_UTF8, flags, s.data(), src_len, nullptr, 0);
+        if (needed <= 0) {
+            throw win32_error("MultiByteToWideChar(size)", s, last_error());
+        }
+
+        std::wstring out(static_cast<std::size_t>(needed), L'\0');
+
+        int written = ::MultiByteToWideChar(CP_UTF8, flags, s.data(), src_len, out.data(), needed);
+        if (written != needed) {
+            throw win32_error("MultiByteToWideChar(convert)", s, last_error());
+        }
+
+        return out;
+    }
+
+    [[nodiscard]] inline std::wstring win32_object_name_from_portable(std::string_view portable_name) {
+        if (portable_name.size() < 2 || portable_name[0] != '/') {
+            throw win32_error("win32_object_name_from_portable(invalid portable name)",
+                              portable_name,
+                              ERROR_INVALID_NAME);
+        }
+
+        std::wstring wbody = utf8_to_wstring_strict(
+            std::string_view(portable_name.data() + 1, portable_name.size() - 1)
+        );
+
+        constexpr std::wstring_view prefix = SHM_WIN32_OBJECT_NAMESPACE;
+
+        std::wstring wname;
+        wname.reserve(prefix.size() + wbody.size());
+        wname.append(prefix.data(), prefix.size());
+        wname.append(wbody);
+        return wname;
+    }
+
+    struct win32_sysinfo_cache final {
+        DWORD page_size = 4096;
+        DWORD alloc_granularity = 64 * 1024;
+
+        win32_sysinfo_cache() noexcept {
+            SYSTEM_INFO si{};
+            ::GetSystemInfo(&si);
+            if (si.dwPageSize) page_size = si.dwPageSize;
+            if (si.dwAllocationGranularity) alloc_granularity = si.dwAllocationGranularity;
+        }
+    };
+
+    [[nodiscard]] inline const win32_sysinfo_cache& sysinfo() noexcept {
+        static const win32_sysinfo_cache s;
+        return s;
+    }
+
+    [[nodiscard]] SHM_FORCE_INLINE std::size_t round_up(std::size_t x, std::size_t a) noexcept {
+        if (a == 0) return x;
+        const std::size_t r = x % a;
+        return r == 0 ? x : (x + (a - r));
+    }
+
+    struct unique_handle final {
+        HANDLE h = NULL;
+
+        unique_handle() noexcept = default;
+        explicit unique_handle(HANDLE v) noexcept : h(v) {}
+        unique_handle(const unique_handle&) = delete;
+        unique_handle& operator=(const unique_handle&) = delete;
+
+        unique_handle(unique_handle&& o) noexcept : h(o.h) { o.h = NULL; }
+        unique_handle& operator=(unique_handle&& o) noexcept {
+            if (this != &o) {
+                reset();
+                h = o.h;
+                o.h = NULL;
+            }
+            return *this;
+        }
+
+        ~unique_handle() noexcept { reset(); }
+
+        void reset(HANDLE nh = NULL) noexcept {
+            if (h != NULL) {
+                ::CloseHandle(h);
+            }
+            h = nh;
+        }
+
+        [[nodiscard]] HANDLE get() const noexcept { return h; }
+        [[nodiscard]] explicit operator bool() const noexcept { return h != NULL; }
+
+        [[nodiscard]] HANDLE release() noexcept {
+            HANDLE out = h;
+            h = NULL;
+            return out;
+        }
+    };
+
+    struct unique_view final {
+        void* p = nullptr;
+
+        unique_view() noexcept = default;
+        explicit unique_view(void* v) noexcept : p(v) {}
+        unique_view(const unique_view&) = delete;
+        unique_view& operator=(const unique_view&) = delete;
+
+        unique_view(unique_view&& o) noexcept : p(o.p) { o.p = nullptr; }
+        unique_view& operator=(unique_view&& o) noexcept {
             if (this != &o) {
                 reset();
                 p = o.p;
                 o.p = nullptr;
             }
-            return *this;
+            return *this;
+        }
+
+        ~unique_view() noexcept { reset(); }
+
+        void reset(void* np = nullptr) noexcept {
+            if (p) {
+                ::UnmapViewOfFile(p);
+            }
+            p = np;
+        }
+
+        [[nodiscard]] void* get() const noexcept { return p; }
+        [[nodiscard]] explicit operator bool() const noexcept { return p != nullptr; }
+
+        [[nodiscard]] void* release() noexcept {
+            void* out = p;
+            p = nullptr;
+            return out;
+        }
+    };
+
+    
+    [[nodiscard]] inline std::uint64_t query_section_max_size_bytes(HANDLE hMap) noexcept {
+        if (hMap == NULL) return 0;
+
+        // NtQuerySection signature.
+        using NTSTATUS = long;
+        using SECTION_INFORMATION_CLASS = int;
+
+        struct LARGE_INTEGER_ {
+            std::int64_t QuadPart;
+        };
+        struct SECTION_BASIC_INFORMATION_ {
+            void* BaseAddress;
+            unsigned long AllocationAttributes;
+            LARGE_INTEGER_ MaximumSize;
+        };
+
+        constexpr SECTION_INFORMATION_CLASS SectionBasicInformation = 0;
+
+        using NtQuerySectionFn = NTSTATUS (NTAPI*)(HANDLE, SECTION_INFORMATION_CLASS, void*, unsigned long, unsigned long*);
+
+        HMODULE ntdll = ::GetModuleHandleW(L"ntdll.dll");
+        if (!ntdll) return 0;
+
+        auto* fn = reinterpret_cast<NtQuerySectionFn>(::GetProcAddress(ntdll, "NtQuerySection"));
+        if (!fn) return 0;
+
+        SECTION_BASIC_INFORMATION_ info{};
+        unsigned long ret_len = 0;
+        NTSTATUS st = fn(hMap, SectionBasicInformation, &info, sizeof(info), &ret_len);
+        if (st < 0) return 0;
+        if (info.MaximumSize.QuadPart <= 0) return 0;
+
+        return static_cast<std::uint64_t>(info.MaximumSize.QuadPart);
+    }
+
+    inline void prefetch_best_effort(void* base, std::size_t bytes) noexcept {
+    #if SHM_WIN32_PREFETCH_BYTES_ON_OPEN
+        if (!base || bytes == 0) return;
+
+        using PrefetchVirtualMemoryFn = BOOL (WINAPI*)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+
+        HMODULE k32 = ::GetModuleHandleW(L"kernel32.dll");
+        if (!k32) return;
+
+        auto* fn = reinterpret_cast<PrefetchVirtualMemoryFn>(::GetProcAddress(k32, "PrefetchVirtualMemory"));
+        if (!fn) return;
+
+        WIN32_MEMORY_RANGE_ENTRY range{};
+        range.VirtualAddress = base;
+        range.NumberOfBytes = bytes;
+
+        (void)fn(::GetCurrentProcess(), 1, &range, 0);
+    #else
+        (void)base;
+        (void)bytes;
+    #endif
+    }
+
+    #if defined(SHM_WIN32_USE_SDDL_DACL)
+
+    struct sddl_security final {
+        SECURITY_ATTRIBUTES sa{};
+        PSECURITY_DESCRIPTOR sd = nullptr;
+
+        sddl_security() noexcept = default;
+        sddl_security(const sddl_security&) = delete;
+        sddl_security& operator=(const sddl_security&) = delete;
+
+        ~sddl_security() noexcept {
+            if (sd) {
+                ::LocalFree(sd);
+                sd = nullptr;
+            }
+        }
+
+        [[nodiscard]] SECURITY_ATTRIBUTES* build_or_throw(std::wstring_view sddl, std::string_view name_for_errors) {
+            if (sddl.empty()) return nullptr;
+
+            if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(
+                    sddl.data(), SDDL_REVISION_1, &sd, nullptr)) {
+                throw win32_error("ConvertStringSecurityDescriptorToSecurityDescriptorW", name_for_errors, last_error());
+            }
+
+            sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+            sa.lpSecurityDescriptor = sd;
+            sa.bInheritHandle = FALSE;
+            return &sa;
+        }
+    };  
+    #endif
+
+#endif
+
+// Runs fn(first, last) over contiguous slices of [0, count) on `threads`
+// threads (0: one per hardware thread), the calling thread included. Falls
+// back to the calling thread for any slice whose thread cannot start.
+template <class Fn>
+inline void parallel_slices_(std::size_t count, unsigned threads, Fn&& fn) noexcept {
+    if (count == 0) return;
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > count) threads = static_cast<unsigned>(count);
+
+    std::vector<std::thread> pool;
+    std::size_t next = 0;
+    const std::size_t per = count / threads;
+    const std::size_t extra = count % threads;
+    try {
+        pool.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t) {
+            const std::size_t len = per + (t <= extra ? 1 : 0);
+            pool.emplace_back([&fn, first = next, last = next + len] { fn(first, last); });
+            next += len;
+        }
+    } catch (...) {
+        // Whatever did not get a thread is run below.
+    }
+    fn(next, count);
+    for (auto& th : pool) th.join();
+}
+
+// Write-faults every page of [p, p + n) without changing its contents, split
+// across `threads` threads. The atomic fetch_or keeps this safe against
+// concurrent writers in other processes.
+inline void touch_pages_(void* p, std::size_t n, std::size_t page, unsigned threads) noexcept {
+    if (!p || n == 0) return;
+    auto* bytes = static_cast<unsigned char*>(p);
+    parallel_slices_((n + page - 1) / page, threads, [bytes, page](std::size_t first, std::size_t last) noexcept {
+        for (std::size_t i = first; i < last; ++i) {
+            std::atomic_ref<unsigned char>(bytes[i * page]).fetch_or(0, std::memory_order_relaxed);
+        }
+    });
+}
+
+#if !SHM_PLATFORM_WIN32
+// madvise flag for `a`, or -1 if this build has none.
+static inline int advice_flag_(advice a) noexcept {
+    switch (a) {
+        case advice::normal: return MADV_NORMAL;
+        case advice::willneed: return MADV_WILLNEED;
+        case advice::sequential: return MADV_SEQUENTIAL;
+        case advice::random: return MADV_RANDOM;
+        case advice::dontneed: return MADV_DONTNEED;
+#if defined(MADV_COLD)
+        case advice::cold: return MADV_COLD;
+#endif
+#if defined(MADV_PAGEOUT)
+        case advice::pageout: return MADV_PAGEOUT;
+#endif
+#if defined(MADV_POPULATE_READ)
+        case advice::populate_read: return MADV_POPULATE_READ;
+#endif
+#if defined(MADV_POPULATE_WRITE)
+        case advice::populate_write: return MADV_POPULATE_WRITE;
+#endif
+#if defined(MADV_MERGEABLE)
+        case advice::mergeable: return MADV_MERGEABLE;
+#endif
+        default: return -1;
+    }
+}
+#endif
+
+// advise() with rounding to `granule` (the mapping's page size; hugetlb
+// mappings reject advice that is not huge-page aligned).
+static inline std::error_code advise_(void* p, std::size_t len, advice a, std::size_t granule) noexcept {
+    if (!p || len == 0) return {};
+#if SHM_PLATFORM_WIN32
+    (void)granule;
+    if (a == advice::normal) return {};
+    return std::make_error_code(std::errc::not_supported);
+#else
+    const int flag = advice_flag_(a);
+    if (flag < 0) return std::make_error_code(std::errc::not_supported);
+    const uptr first = addr(p);
+    uptr lo = first / granule * granule;
+    uptr hi = round_up_(first + len, granule);
+    if (a == advice::dontneed) {
+        lo = round_up_(first, granule);
+        hi = (first + len) / granule * granule;
+        if (hi <= lo) return {};
+    }
+    if (::madvise(reinterpret_cast<void*>(lo), hi - lo, flag) != 0) {
+        return std::error_code(errno, std::generic_category());
+    }
+    return {};
+#endif
+}
+
+#if !SHM_PLATFORM_WIN32
+// Pages of [p, p + len) (page aligned) in RAM, or -1 with errno set.
+static inline std::ptrdiff_t count_resident_(void* p, std::size_t len, std::size_t page) noexcept {
+#if defined(__linux__)
+    unsigned char vec[1024];
+#else
+    char vec[1024];
+#endif
+    std::ptrdiff_t resident = 0;
+    auto* at = static_cast<std::byte*>(p);
+    for (std::size_t pages = (len + page - 1) / page; pages != 0;) {
+        const std::size_t n = (std::min)(pages, sizeof(vec));
+        if (::mincore(at, n * page, vec) != 0) return -1;
+        for (std::size_t i = 0; i < n; ++i) resident += vec[i] & 1;
+        at += n * page;
+        pages -= n;
+    }
+    return resident;
+}
+
+#if defined(__linux__)
+// True if any page of [p, p + len) is soft-dirty in /proc/self/pagemap.
+static inline bool any_soft_dirty_(int pagemap, const void* p, std::size_t len, std::size_t page) noexcept {
+    constexpr std::uint64_t kSoftDirty = std::uint64_t{1} << 55;
+    std::uint64_t entries[512];
+    std::size_t first = addr(p) / page;
+    for (std::size_t pages = (len + page - 1) / page; pages != 0;) {
+        const std::size_t n = (std::min)(pages, std::size(entries));
+        const ssize_t got = ::pread(pagemap, entries, n * sizeof(std::uint64_t),
+                                    static_cast<off_t>(first * sizeof(std::uint64_t)));
+        if (got <= 0) return false;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(got) / sizeof(std::uint64_t); ++i) {
+            if (entries[i] & kSoftDirty) return true;
+        }
+        first += n;
+        pages -= n;
+    }
+    return false;
+}
+
+// Resets the soft-dirty bits of every mapping in the process.
+static inline bool clear_soft_dirty_(int clear_refs) noexcept {
+    return ::pwrite(clear_refs, "4", 1, 0) == 1;
+}
+
+// Whether the kernel maintains soft-dirty bits (CONFIG_MEM_SOFT_DIRTY),
+// checked on a scratch page.
+static inline bool soft_dirty_works_(int pagemap, int clear_refs) noexcept {
+    const std::size_t page = page_size_();
+    void* m = ::mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) return false;
+    *static_cast<volatile char*>(m) = 1;
+    bool ok = clear_soft_dirty_(clear_refs) && !any_soft_dirty_(pagemap, m, page, page);
+    *static_cast<volatile char*>(m) = 2;
+    ok = ok && any_soft_dirty_(pagemap, m, page, page);
+    ::munmap(m, page);
+    return ok;
+}
+#endif
+#endif
+} // namespace detail::seg
+
+inline std::error_code advise(void* addr, std::size_t len, advice a) noexcept {
+    return detail::seg::advise_(addr, len, a, detail::seg::page_size_());
+}
+
+
+// Hash of the size, alignment and trivial-copyability of each of Ts (in
+// order), mixed into `seed`. Store it in segment_options::layout_hash so that
+// processes built with a different layout refuse to attach.
+template <class... Ts>
+[[nodiscard]] constexpr std::uint64_t layout_fingerprint(std::uint64_t seed = 0) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ull ^ seed;   // FNV-1a
+    auto mix = [&h](std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 0x100000001b3ull;
+        }
+    };
+    mix(sizeof...(Ts));
+    (mix(sizeof(Ts)), ...);
+    (mix(alignof(Ts)), ...);
+    (mix(std::is_trivially_copyable_v<Ts> ? 1u : 0u), ...);
+    return h;
+}
+
+// First page of a segment opened with segment_options::header. `state` is
+// only accessed atomically (std::atomic_ref) and is the futex word openers
+// wait on; the fixed fields are written before it is published. data_size,
+// grow_lock and generation change after publication (segment::grow) and are
+// likewise only accessed atomically.
+struct segment_header {
+    static constexpr std::uint64_t kMagic   = 0x53455059544D4853ull;  // "SHMTYPES"
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kNotReady = 0;
+    static constexpr std::uint32_t kReady    = 1;
+
+    // `migration` states (migrate_segment).
+    static constexpr std::uint32_t kMigrationIdle = 0;
+    static constexpr std::uint32_t kCopying       = 1;   // writers log to `dirty`
+    static constexpr std::uint32_t kQuiescing     = 2;   // new write sections wait
+    static constexpr std::uint32_t kMoved         = 3;   // see forward_name
+    static constexpr std::size_t kDirtyWords = 256;      // 16384 dirty bits
+
+    std::uint64_t magic;
+    std::uint32_t header_version;
+    std::uint32_t layout_version;
+    std::uint64_t layout_hash;
+    std::uint64_t data_offset;
+    std::uint64_t data_size;
+    std::uint32_t state;
+    std::uint32_t grow_lock;    // pid of the process inside grow(), or 0
+    std::uint64_t generation;   // bumped after each grow publishes data_size
+
+    // Online migration. `migration` is the futex word writers blocked by a
+    // quiesce wait on and `writers` counts open write sections. While a copy
+    // runs, note_write() sets one bit of `dirty` per 2^dirty_shift bytes.
+    std::uint32_t migration;
+    std::uint32_t writers;
+    std::uint32_t dirty_shift;
+    std::uint32_t reserved;
+    char forward_name[64];
+    std::uint64_t dirty[kDirtyWords];
+};
+
+static_assert(std::is_trivially_copyable_v<segment_header>);
+static_assert(sizeof(segment_header) <= 4096, "segment_header must fit the header page");
+
+// How the creator makes a new segment's contents zero.
+enum class zero_mode : std::uint8_t {
+    // Rely on the OS: new POSIX shm objects and pagefile-backed sections are
+    // zero-filled on first touch, so construction touches no pages.
+    none,
+    // Write zeros over the whole mapping on the constructing thread. Faults
+    // in every page up front; seconds for tens of GiB.
+    memset,
+    // Release any backing pages (MADV_REMOVE) so the kernel zero-fills them
+    // on first touch. Falls back to memset where pages cannot be released.
+    lazy,
+};
+
+// Optional step that faults in the mapping's page tables during construction
+// so the first pass over the data does not pay one fault per page.
+enum class prefault_mode : std::uint8_t {
+    none,
+    // MADV_POPULATE_WRITE (Linux 5.14+), else MAP_POPULATE; the touch loop
+    // where neither is available or the kernel rejects the advice.
+    populate,
+    // Write-touch one byte per page from prefault_threads threads.
+    touch,
+};
+
+// How segment::lock pins pages in RAM.
+enum class lock_mode : std::uint8_t {
+    none,
+    // mlock (VirtualLock on Windows): fault the range in now and keep it.
+    now,
+    // mlock2(MLOCK_ONFAULT), Linux 4.4+: keep pages once first touched, so
+    // a sparse segment does not commit memory it never uses. Falls back to
+    // `now` where the kernel or platform has no on-fault locking.
+    on_fault,
+};
+
+// segment::residency(): how much of a range is in RAM (mincore).
+struct residency_report {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t page_bytes = 0;        // unit of pages/resident
+    std::size_t pages = 0;
+    std::size_t resident = 0;
+    // Data offset of the first page that is not resident, or npos.
+    std::size_t first_absent = npos;
+
+    bool fully_resident() const noexcept { return resident == pages; }
+};
+
+// Page size policy for a segment's mapping.
+enum class page_policy : std::uint8_t {
+    // MADV_HUGEPAGE: let THP back the range where the system allows it.
+    thp_advise,
+    // No advice; the system-wide THP setting decides.
+    system_default,
+    // MADV_NOHUGEPAGE: base pages only.
+    thp_never,
+    // Explicit huge pages from a hugetlbfs mount (Linux) or SEC_LARGE_PAGES
+    // (Windows, 2 MiB only, needs SeLockMemoryPrivilege). Sizes are rounded up
+    // to the huge page size and construction fails rather than silently
+    // falling back to base pages.
+    hugetlb_2m,
+    hugetlb_1g,
+};
+
+// Optional mapping parameters for shm::segment.
+struct segment_options {
+    // Map the view at exactly this address (page aligned, allocation-granularity
+    // aligned on Windows). Construction throws if the range is unavailable;
+    // nothing already mapped there is replaced.
+    void* fixed_address = nullptr;
+
+    // Reserve the first page for a segment_header. The creator stamps it and
+    // publishes readiness after zeroing; openers block (futex on Linux) until
+    // it is ready, up to ready_timeout_ms, and reject a header whose magic,
+    // layout_version or layout_hash differ. size arguments and data() then
+    // refer to the bytes after the header.
+    bool header = false;
+    std::uint32_t layout_version = 0;
+    std::uint64_t layout_hash = 0;
+    std::uint32_t ready_timeout_ms = 5000;
+    // Creator only: keep the segment not-ready until mark_ready() is called,
+    // so openers also wait for the creator's own initialization.
+    bool defer_ready = false;
+
+    // Creator only. The default skips the redundant memset on POSIX; on
+    // Windows it follows SHM_WIN32_ZERO_ON_CREATE.
+#if SHM_PLATFORM_WIN32 && SHM_WIN32_ZERO_ON_CREATE
+    zero_mode zero = zero_mode::memset;
+#else
+    zero_mode zero = zero_mode::none;
+#endif
+    prefault_mode prefault = prefault_mode::none;
+    unsigned prefault_threads = 0;   // touch: 0 = one per hardware thread
+
+    // Pin the whole mapping after zeroing and prefault. Construction throws
+    // std::system_error if the lock is refused (RLIMIT_MEMLOCK, privileges).
+    lock_mode lock = lock_mode::none;
+
+    // File-backed segments: granularity of mark_dirty()/flush_dirty()
+    // tracking, rounded up to the page size.
+    std::size_t dirty_chunk = std::size_t{64} << 10;
+
+    page_policy pages = page_policy::thp_advise;
+    // hugetlb policies: mount holding the segment file. nullptr selects
+    // /dev/hugepages (2 MiB) or /dev/hugepages1G (1 GiB). The segment name is
+    // the file name; remove it with remove(name, opts).
+    const char* hugetlbfs_dir = nullptr;
+
+    // Map the data region twice, back to back, so data()[i] and
+    // data()[i + data_size()] are the same byte and any run of up to
+    // data_size() bytes starting inside the region is contiguous (see
+    // ring_view). The data size must be a multiple of the page size (huge
+    // page size for hugetlb policies; those cannot be combined with header).
+    // Mirrored segments cannot grow. POSIX only.
+    bool mirror = false;
+
+    // Register the data region in segment_table under this id once mapped,
+    // as bind_id() would, so fat_offset_ptr values naming it decode right
+    // after attach. -1 registers nothing. Construction throws
+    // std::invalid_argument for an id outside the table.
+    int table_id = -1;
+};
+
+// How segment::flush writes dirty pages back to a file-backed segment.
+enum class flush_mode : std::uint8_t {
+    // msync(MS_SYNC): returns once the range is on stable storage.
+    sync,
+    // Start writeback without waiting: sync_file_range(SYNC_FILE_RANGE_WRITE)
+    // on Linux, where MS_ASYNC does nothing, msync(MS_ASYNC) elsewhere.
+    async,
+};
+
+// Background flusher for file-backed segments (segment::start_flusher).
+struct flusher_options {
+    // Flush at least this often; bounds the updates a crash can lose.
+    // 0: only when dirty_threshold is reached.
+    std::uint32_t interval_ms = 1000;
+    // Flush early once this many bytes are marked dirty (0: interval only).
+    // Checked every poll_ms.
+    std::size_t dirty_threshold = 0;
+    std::uint32_t poll_ms = 10;
+    flush_mode mode = flush_mode::sync;
+};
+
+// Background hot/cold tiering (segment::start_tiering).
+struct tiering_options {
+    // Sampling period. 0 starts no thread; call segment::tier_step().
+    std::uint32_t interval_ms = 1000;
+    // Demote a chunk after this many samples in a row without an access.
+    // Each refault of a demoted chunk doubles its wait, up to 16x.
+    std::uint32_t idle_samples = 60;
+    std::size_t chunk_bytes = std::size_t{2} << 20;   // rounded to the page size
+    advice demote = advice::cold;                     // cold or pageout
+    // Linux: also count writes seen through the soft-dirty bits in
+    // /proc/self/pagemap. Off by default: each sample resets the bits with
+    // clear_refs, which write-protects every page of the process, so the
+    // next write to any page takes a minor fault. It also disturbs other
+    // soft-dirty users such as checkpointing tools.
+    bool soft_dirty = false;
+};
+
+struct tiering_stats {
+    std::uint64_t samples = 0;
+    std::uint64_t demoted_bytes = 0;     // all demotions so far
+    std::uint64_t refaulted_bytes = 0;   // demoted, then accessed again
+    std::uint64_t cold_bytes = 0;        // demoted and not accessed since
+    bool soft_dirty = false;             // writes are being tracked
+};
+
+// Constructor tag: segment(file_backed, path, size, mode) maps a regular
+// file, so the segment's bytes are the file's bytes.
+struct file_backed_t { explicit file_backed_t() = default; };
+inline constexpr file_backed_t file_backed{};
+
+#if !SHM_PLATFORM_WIN32
+// Constructor tags: segment(anonymous_segment, size) creates an unnamed
+// segment (memfd_create on Linux) whose lifetime is that of its open fds;
+// segment(adopt_fd, fd) maps a descriptor received from another process.
+struct anonymous_segment_t { explicit anonymous_segment_t() = default; };
+inline constexpr anonymous_segment_t anonymous_segment{};
+
+struct adopt_fd_t { explicit adopt_fd_t() = default; };
+inline constexpr adopt_fd_t adopt_fd{};
+#endif
+
+class segment {
+public:
+    enum class open_mode { create_only, open_only, open_or_create };
+
+    segment(const char* name, std::size_t size, open_mode mode)
+        : segment(name, size, mode, segment_options{}) {}
+
+    segment(const char* name, std::size_t size, open_mode mode, const segment_options& opts)
+#if SHM_PLATFORM_WIN32
+        : hMapFile_(NULL)
+        , base_(nullptr)
+        , size_(0)
+        , map_size_(0)
+        , valid_(false)
+        , created_(false)
+        , name_(detail::seg::normalize_name_(name))
+#else
+        : fd_(-1)
+        , base_(nullptr)
+        , size_(0)
+        , map_size_(0)
+        , created_(false)
+        , name_(detail::seg::normalize_name_(name))
+#endif
+    {
+        if (name_.empty()) {
+            throw std::invalid_argument("shm::segment: name must not be null/empty");
+        }
+        check_table_id_(opts);
+
+#if SHM_PLATFORM_WIN32
+        const bool may_create = (mode == open_mode::create_only || mode == open_mode::open_or_create);
+        if (may_create && size == 0) {
+            throw std::invalid_argument("shm::segment: size must be > 0 for create modes");
+        }
+
+        if (opts.mirror) {
+            throw std::system_error(std::make_error_code(std::errc::not_supported),
+                                    "shm::segment: mirrored segments are not supported on Windows");
+        }
+
+        const std::wstring wname = detail::seg::win32_object_name_from_portable(name_);
+
+        constexpr DWORD kMapAccess   = SHM_WIN32_MAP_ACCESS;
+        constexpr DWORD kPageProtect = PAGE_READWRITE;
+
+        auto harden_handle_noninherit = [](HANDLE h) noexcept {
+            if (h != NULL) (void)::SetHandleInformation(h, HANDLE_FLAG_INHERIT, 0);
+        };
+
+        detail::seg::unique_handle h;
+        detail::seg::unique_view   v;
+
+        bool created_local = false;
+        std::size_t exposed_size = 0;
+
+        const auto& si = detail::seg::sysinfo();
+        const std::size_t header_bytes = opts.header ? static_cast<std::size_t>(si.page_size) : 0;
+
+        // Large-page sections must be committed up front and sized in large
+        // pages; 1 GiB pages cannot be requested through a section.
+        std::size_t huge = 0;
+        if (opts.pages == page_policy::hugetlb_1g) {
+            throw std::invalid_argument("shm::segment: hugetlb_1g is not supported on Windows");
+        }
+        if (opts.pages == page_policy::hugetlb_2m) {
+            huge = static_cast<std::size_t>(::GetLargePageMinimum());
+            if (huge == 0) throw std::invalid_argument("shm::segment: large pages are not supported");
+        }
+        const std::size_t unit = huge ? huge : static_cast<std::size_t>(si.page_size);
+
+        const std::size_t total = (size != 0) ? size + header_bytes : 0;
+        const std::size_t create_max = may_create ? detail::seg::round_up(total, unit) : 0;
+
+        SECURITY_ATTRIBUTES* psa = nullptr;
+#if defined(SHM_WIN32_USE_SDDL_DACL)
+        detail::seg::sddl_security sec;
+#ifndef SHM_WIN32_SDDL_STRING
+# error SHM_WIN32_USE_SDDL_DACL requires SHM_WIN32_SDDL_STRING, e.g. L"D:(A;;GA;;;WD)"
+#endif
+        psa = sec.build_or_throw(SHM_WIN32_SDDL_STRING, name_);
+#endif
+
+        if (mode == open_mode::open_only) {
+            HANDLE hm = ::OpenFileMappingW(kMapAccess, FALSE, wname.c_str());
+            if (hm == NULL) {
+                throw detail::seg::win32_error("OpenFileMappingW(open_only)", name_, detail::seg::last_error());
+            }
+            harden_handle_noninherit(hm);
+            h.reset(hm);
+            created_local = false;
+        } else {
+            ULARGE_INTEGER win_size{};
+            win_size.QuadPart = static_cast<unsigned long long>(create_max);
+
+            const DWORD protect = huge ? (kPageProtect | SEC_COMMIT | SEC_LARGE_PAGES) : kPageProtect;
+
+            ::SetLastError(0);
+            HANDLE hm = ::CreateFileMappingW(INVALID_HANDLE_VALUE,
+                                             psa,
+                                             protect,
+                                             win_size.HighPart,
+                                             win_size.LowPart,
+                                             wname.c_str());
+            if (hm == NULL) {
+                throw detail::seg::win32_error("CreateFileMappingW", name_, detail::seg::last_error());
+            }
+            harden_handle_noninherit(hm);
+            h.reset(hm);
+
+            const DWORD last = ::GetLastError();
+            if (last == ERROR_ALREADY_EXISTS) {
+                created_local = false;
+                if (mode == open_mode::create_only) {
+                    throw detail::seg::win32_error("CreateFileMappingW(create_only exists)", name_, last);
+                }
+            } else {
+                created_local = true;
+            }
+        }
+
+        if (opts.fixed_address &&
+            detail::addr(opts.fixed_address) % (huge ? huge : si.alloc_granularity) != 0) {
+            throw std::invalid_argument("shm::segment: fixed_address must be allocation-granularity aligned");
+        }
+
+        DWORD map_access = kMapAccess;
+#if defined(FILE_MAP_LARGE_PAGES)
+        if (huge) map_access |= FILE_MAP_LARGE_PAGES;
+#endif
+
+        void* view = ::MapViewOfFileEx(h.get(), map_access, 0, 0, 0, opts.fixed_address);
+        if (!view) {
+            throw detail::seg::win32_error(opts.fixed_address ? "MapViewOfFileEx(fixed_address)" : "MapViewOfFile",
+                                           name_, detail::seg::last_error());
+        }
+        v.reset(view);
+
+        std::uint64_t max_bytes = detail::seg::query_section_max_size_bytes(h.get());
+        if (max_bytes == 0) {
+            MEMORY_BASIC_INFORMATION mbi{};
+            if (::VirtualQuery(v.get(), &mbi, sizeof(mbi)) == 0) {
+                throw detail::seg::win32_error("VirtualQuery", name_, detail::seg::last_error());
+            }
+            max_bytes = static_cast<std::uint64_t>(mbi.RegionSize);
+        }
+        if (max_bytes == 0) {
+            throw detail::seg::win32_error("query mapping size (0)", name_, ERROR_INVALID_PARAMETER);
+        }
+
+        if (!created_local) {
+            if (total != 0 && max_bytes < static_cast<std::uint64_t>(total)) {
+                throw detail::seg::win32_error("segment(open existing smaller than requested)",
+                                               name_, ERROR_INSUFFICIENT_BUFFER);
+            }
+            exposed_size = (total == 0) ? static_cast<std::size_t>(max_bytes) : total;
+        } else {
+            if (static_cast<std::uint64_t>(total) > max_bytes) {
+                throw detail::seg::win32_error("segment(created smaller than requested)",
+                                               name_, ERROR_INSUFFICIENT_BUFFER);
+            }
+            exposed_size = huge ? create_max : total;
+        }
+
+        if (!created_local) {
+            constexpr std::size_t want = static_cast<std::size_t>(SHM_WIN32_PREFETCH_BYTES_ON_OPEN);
+            if constexpr (want != 0) {
+                const std::size_t n = (want < exposed_size) ? want : exposed_size;
+                detail::seg::prefetch_best_effort(v.get(), n);
+            }
+        }
+
+#if SHM_WIN32_TRY_VIRTUAL_LOCK
+        (void)::VirtualLock(v.get(), exposed_size);
+#endif
+        if (opts.lock != lock_mode::none && exposed_size != 0 && !::VirtualLock(v.get(), exposed_size)) {
+            throw detail::seg::win32_error("VirtualLock", name_, detail::seg::last_error());
+        }
+
+        // Pagefile-backed sections start zero-filled and there are no pages
+        // to release, so lazy needs no work here.
+        if (created_local && exposed_size != 0 && opts.zero == zero_mode::memset) {
+            std::memset(v.get(), 0, exposed_size);
+        }
+
+        if (opts.prefault != prefault_mode::none) {
+            detail::seg::touch_pages_(v.get(), exposed_size, unit, opts.prefault_threads);
+        }
+
+        hMapFile_ = h.release();
+        base_     = v.release();
+        size_     = exposed_size;
+        map_size_ = static_cast<std::size_t>(max_bytes);
+        created_  = created_local;
+        valid_    = (base_ != nullptr && hMapFile_ != NULL && size_ != 0);
+        huge_page_ = huge;
+
+        if (opts.header) {
+            header_bytes_ = header_bytes;
+            if (const char* err = attach_header_(opts)) {
+                ::UnmapViewOfFile(base_);
+                ::CloseHandle(hMapFile_);
+                base_ = nullptr;
+                hMapFile_ = NULL;
+                size_ = 0;
+                map_size_ = 0;
+                valid_ = false;
+                header_bytes_ = 0;
+                throw std::runtime_error(err);
+            }
+        }
+        if (opts.table_id >= 0) (void)bind_id(static_cast<segment_id>(opts.table_id));
+
+#else
+        if (!detail::seg::name_is_portable_(name_)) {
+            throw std::invalid_argument("shm::segment: name must be portable POSIX shm form '/X' with no additional '/'");
+        }
+
+        const bool may_create = (mode == open_mode::create_only || mode == open_mode::open_or_create);
+        if (may_create && size == 0) {
+            throw std::invalid_argument("shm::segment: size must be > 0 for create modes");
+        }
+
+        const std::size_t ps = detail::seg::page_size_();
+        const int perms = 0600;
+        const std::size_t header_bytes = opts.header ? ps : 0;
+
+        // hugetlb policies place the object on a hugetlbfs mount instead of
+        // in POSIX shm; everything is then sized in huge pages.
+        const std::size_t huge = hugetlb_page_(opts.pages);
+        std::string huge_path;
+        if (huge) {
+#if defined(__linux__)
+            huge_path = hugetlbfs_path_(opts, name_);
+#else
+            throw std::invalid_argument("shm::segment: hugetlb page policies require Linux");
+#endif
+        }
+        const std::size_t unit = huge ? huge : ps;
+
+        auto open_object = [&](int oflags) -> int {
+            return huge ? ::open(huge_path.c_str(), oflags, perms) : ::shm_open(name_.c_str(), oflags, perms);
+        };
+
+        int flags = O_RDWR;
+#if defined(O_CLOEXEC)
+        flags |= O_CLOEXEC;
+#endif
+
+        auto unlink_noexcept = [&]() noexcept {
+            if (huge) (void)::unlink(huge_path.c_str());
+            else if (!name_.empty()) (void)::shm_unlink(name_.c_str());
+        };
+
+        auto fail_ctor = [&](bool unlink_if_created) -> void {
+            release_fd_();
+            if (unlink_if_created) unlink_noexcept();
+        };
+
+        int fd = -1;
+        if (mode == open_mode::create_only) {
+            fd = open_object(flags | O_CREAT | O_EXCL);
+            if (fd == -1) throw_errno_(huge ? "open(hugetlbfs, create_only)" : "shm_open(create_only)");
+            created_ = true;
+        } else if (mode == open_mode::open_only) {
+            fd = open_object(flags);
+            if (fd == -1) throw_errno_(huge ? "open(hugetlbfs, open_only)" : "shm_open(open_only)");
+            created_ = false;
+        } else {
+            fd = open_object(flags | O_CREAT | O_EXCL);
+            if (fd == -1) {
+                if (errno != EEXIST) throw_errno_(huge ? "open(hugetlbfs, open_or_create/create)" : "shm_open(open_or_create/create)");
+                fd = open_object(flags);
+                if (fd == -1) throw_errno_(huge ? "open(hugetlbfs, open_or_create/open)" : "shm_open(open_or_create/open)");
+                created_ = false;
+            } else {
+                created_ = true;
+            }
+        }
+
+        fd_ = fd;
+
+#if defined(__linux__)
+        if (huge && detail::seg::hugetlbfs_page_(fd_) != huge) {
+            fail_ctor(created_);
+            throw std::runtime_error("shm::segment: hugetlbfs_dir is not a hugetlbfs mount with the requested page size");
+        }
+#endif
+
+        std::size_t seg_size = 0;
+        if (created_) {
+            const std::size_t create_bytes =
+                huge ? detail::seg::round_up_(size + header_bytes, huge) : size + header_bytes;
+            if (::ftruncate(fd_, static_cast<off_t>(create_bytes)) != 0) {
+                const int saved = errno;
+                fail_ctor(true);
+                throw_errno_("ftruncate(create)", saved);
+            }
+            seg_size = create_bytes;
+        } else {
+            struct stat st{};
+            bool ok = false;
+
+            // An opener can land between the creator's shm_open(O_EXCL) and
+            // its ftruncate. The header (and the futex readiness word in it)
+            // cannot be mapped until the object has a size, so this window is
+            // bridged by polling. POSIX shm has no rename, so the object
+            // cannot be sized under a temporary name and linked into place.
+            for (std::size_t attempt = 0; attempt < 200; ++attempt) {
+                if (::fstat(fd_, &st) != 0) {
+                    const int saved = errno;
+                    fail_ctor(false);
+                    throw_errno_("fstat(open)", saved);
+                }
+                if (st.st_size > 0) { ok = true; break; }
+                detail::seg::nanosleep_backoff_(attempt);
+            }
+
+            if (!ok) {
+                fail_ctor(false);
+                throw std::runtime_error("shm::segment: existing segment reports size 0 after retries");
+            }
+
+            const std::size_t existing = static_cast<std::size_t>(st.st_size);
+            if (existing < header_bytes || (size != 0 && existing < size + header_bytes)) {
+                fail_ctor(false);
+                throw std::runtime_error("shm::segment: existing segment smaller than requested size");
+            }
+            seg_size = existing;
         }
 
-        ~unique_view() noexcept { reset(); }
+        size_ = seg_size;
+        huge_page_ = huge;
+        try {
+            map_fd_(opts, unit, header_bytes);
+        } catch (...) {
+            if (created_) unlink_noexcept();
+            throw;
+        }
+#endif
+    }
 
-        void reset(void* np = nullptr) noexcept {
-            if (p) {
-                ::UnmapViewOfFile(p);
+    // Maps the regular file at `path`; create modes size it to `size` data
+    // bytes (plus the header page), open modes map what is there. Updates
+    // reach the file through the page cache; use flush(), flush_dirty() or
+    // start_flusher() to bound what a crash can lose. Not supported on
+    // Windows.
+    segment(file_backed_t, const char* path, std::size_t size, open_mode mode, const segment_options& opts = {})
+#if SHM_PLATFORM_WIN32
+    {
+        (void)path;
+        (void)size;
+        (void)mode;
+        (void)opts;
+        throw std::system_error(std::make_error_code(std::errc::not_supported),
+                                "shm::segment: file-backed segments are not supported on Windows");
+    }
+#else
+        : fd_(-1)
+        , base_(nullptr)
+        , size_(0)
+        , map_size_(0)
+        , created_(false)
+        , name_(path ? path : "")
+    {
+        if (name_.empty()) {
+            throw std::invalid_argument("shm::segment: path must not be null/empty");
+        }
+        if (mode != open_mode::open_only && size == 0) {
+            throw std::invalid_argument("shm::segment: size must be > 0 for create modes");
+        }
+        if (hugetlb_page_(opts.pages) != 0) {
+            throw std::invalid_argument("shm::segment: hugetlb page policies need a hugetlbfs segment, not a file");
+        }
+
+        const std::size_t ps = detail::seg::page_size_();
+        const std::size_t header_bytes = opts.header ? ps : 0;
+        int flags = O_RDWR;
+#if defined(O_CLOEXEC)
+        flags |= O_CLOEXEC;
+#endif
+
+        if (mode != open_mode::open_only) {
+            fd_ = ::open(name_.c_str(), flags | O_CREAT | O_EXCL, 0600);
+            created_ = (fd_ != -1);
+            if (fd_ == -1 && (mode == open_mode::create_only || errno != EEXIST)) throw_errno_("open(create)");
+        }
+        if (fd_ == -1) {
+            fd_ = ::open(name_.c_str(), flags);
+            if (fd_ == -1) throw_errno_("open");
+        }
+
+        auto fail = [&](const char* op, int e) {
+            release_fd_();
+            if (created_) (void)::unlink(name_.c_str());
+            throw_errno_(op, e);
+        };
+
+        if (created_) {
+            if (::ftruncate(fd_, static_cast<off_t>(size + header_bytes)) != 0) fail("ftruncate(create)", errno);
+            size_ = size + header_bytes;
+        } else {
+            // open_or_create can race a creator that has not sized the file yet.
+            struct stat st{};
+            for (std::size_t attempt = 0;; ++attempt) {
+                if (::fstat(fd_, &st) != 0) fail("fstat(open)", errno);
+                if (!S_ISREG(st.st_mode)) fail("open(not a regular file)", EINVAL);
+                if (st.st_size > 0 || attempt >= 200) break;
+                detail::seg::nanosleep_backoff_(attempt);
             }
-            p = np;
+            const std::size_t existing = static_cast<std::size_t>(st.st_size);
+            if (existing == 0 || existing < header_bytes || (size != 0 && existing < size + header_bytes)) {
+                release_fd_();
+                throw std::runtime_error("shm::segment: existing file smaller than requested size");
+            }
+            size_ = existing;
         }
 
-        [[nodiscard]] void* get() const noexcept { return p; }
-        [[nodiscard]] explicit operator bool() const noexcept { return p != nullptr; }
+        try {
+            map_fd_(opts, ps, header_bytes);
+        } catch (...) {
+            if (created_) (void)::unlink(name_.c_str());
+            throw;
+        }
+
+        file_backed_ = true;
+        dirty_chunk_ = detail::seg::round_up_(opts.dirty_chunk ? opts.dirty_chunk : ps, ps);
+        dirty_words_ = ((data_size() + dirty_chunk_ - 1) / dirty_chunk_ + 63) / 64;
+        dirty_ = std::make_unique<std::atomic<std::uint64_t>[]>(dirty_words_);
+    }
+#endif
+
+#if !SHM_PLATFORM_WIN32
+    // Unnamed segment of `size` data bytes. Nothing appears in /dev/shm and
+    // the memory is freed when the last mapping and fd are gone; share it by
+    // passing fd() to another process with send_fd(). hugetlb page policies
+    // map to MFD_HUGETLB. Without memfd_create (non-Linux) the object is an
+    // O_EXCL shm object that is unlinked immediately.
+    segment(anonymous_segment_t, std::size_t size, const segment_options& opts = {})
+        : fd_(-1)
+        , base_(nullptr)
+        , size_(0)
+        , map_size_(0)
+        , created_(true)
+    {
+        if (size == 0) {
+            throw std::invalid_argument("shm::segment: size must be > 0 for create modes");
+        }
+
+        const std::size_t ps = detail::seg::page_size_();
+        const std::size_t header_bytes = opts.header ? ps : 0;
+        const std::size_t huge = hugetlb_page_(opts.pages);
+        const std::size_t unit = huge ? huge : ps;
+        const std::size_t bytes = huge ? detail::seg::round_up_(size + header_bytes, huge) : size + header_bytes;
+
+#if defined(__linux__)
+        unsigned mfd_flags = MFD_CLOEXEC | MFD_ALLOW_SEALING;
+        if (huge) {
+#if defined(MFD_HUGE_SHIFT)
+            constexpr unsigned kHugeShift = MFD_HUGE_SHIFT;
+#else
+            constexpr unsigned kHugeShift = 26;
+#endif
+            mfd_flags |= MFD_HUGETLB | (static_cast<unsigned>(std::countr_zero(huge)) << kHugeShift);
+        }
+        fd_ = ::memfd_create("shm::segment", mfd_flags);
+        if (fd_ == -1) throw_errno_("memfd_create");
+#else
+        if (huge) throw std::invalid_argument("shm::segment: hugetlb page policies require Linux");
+
+        static std::atomic<std::uint32_t> counter{0};
+        for (std::size_t attempt = 0; fd_ == -1; ++attempt) {
+            const std::string n = "/shm_anon_" + std::to_string(::getpid()) + "_" +
+                                  std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+            fd_ = ::shm_open(n.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+            if (fd_ != -1) {
+                (void)::shm_unlink(n.c_str());
+            } else if (errno != EEXIST || attempt >= 100) {
+                throw_errno_("shm_open(anonymous)");
+            }
+        }
+#endif
+
+        if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            const int saved = errno;
+            release_fd_();
+            throw_errno_("ftruncate(create)", saved);
+        }
+#if defined(F_ADD_SEALS) && defined(F_SEAL_SHRINK)
+        // Receivers map the full size; forbid shrinking it under them.
+        (void)::fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK);
+#endif
+
+        size_ = bytes;
+        huge_page_ = huge;
+        map_fd_(opts, unit, header_bytes);
+    }
+
+    // Takes ownership of `fd` (typically from recv_fd()) and maps the whole
+    // object as an opener. The fd is closed if construction fails.
+    segment(adopt_fd_t, int fd, const segment_options& opts = {})
+        : fd_(fd)
+        , base_(nullptr)
+        , size_(0)
+        , map_size_(0)
+        , created_(false)
+    {
+        if (fd_ < 0) {
+            throw std::invalid_argument("shm::segment: adopt_fd requires a valid descriptor");
+        }
+
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) {
+            const int saved = errno;
+            release_fd_();
+            throw_errno_("fstat(adopt_fd)", saved);
+        }
+
+        const std::size_t ps = detail::seg::page_size_();
+        const std::size_t header_bytes = opts.header ? ps : 0;
+        if (st.st_size <= 0 || static_cast<std::size_t>(st.st_size) < header_bytes) {
+            release_fd_();
+            throw std::runtime_error("shm::segment: adopted descriptor is smaller than requested size");
+        }
+
+#if defined(__linux__)
+        const std::size_t huge = detail::seg::hugetlbfs_page_(fd_);
+#else
+        const std::size_t huge = 0;
+#endif
+        size_ = static_cast<std::size_t>(st.st_size);
+        huge_page_ = huge;
+        map_fd_(opts, huge ? huge : ps, header_bytes);
+    }
+
+    // Descriptor backing the mapping; stays owned by the segment.
+    int fd() const noexcept { return fd_; }
+#endif
+
+    ~segment() noexcept {
+        (void)stop_flusher();
+        stop_tiering();
+        if (table_id_ >= 0) {
+            if (base_) (void)shm::segment_table::clear(static_cast<segment_id>(table_id_), data());
+            table_id_ = -1;
+        }
+#if SHM_PLATFORM_WIN32
+        if (base_ != nullptr) {
+            ::UnmapViewOfFile(base_);
+            base_ = nullptr;
+        }
+        if (hMapFile_ != NULL) {
+            ::CloseHandle(hMapFile_);
+            hMapFile_ = NULL;
+        }
+        size_ = 0;
+        map_size_ = 0;
+        valid_ = false;
+        created_ = false;
+#else
+        if (base_) {
+            ::munmap(base_, map_size_);
+            base_ = nullptr;
+        }
+        if (fd_ != -1) {
+            (void)detail::seg::retry_eintr_call_(::close, fd_);
+            fd_ = -1;
+        }
+        size_ = 0;
+        map_size_ = 0;
+        created_ = false;
+#endif
+    }
+
+    segment(const segment&) = delete;
+    segment& operator=(const segment&) = delete;
+    segment(segment&&) = delete;
+    segment& operator=(segment&&) = delete;
+
+    void* base() const noexcept { return base_; }
+    std::size_t size() const noexcept { return size_; }
+
+    // Usable region: everything after the header page when
+    // segment_options::header is set, otherwise the whole mapping.
+    void* data() const noexcept {
+        return base_ ? static_cast<std::byte*>(base_) + header_bytes_ : nullptr;
+    }
+    std::size_t data_size() const noexcept { return size_ - header_bytes_; }
+
+    segment_header* header() const noexcept {
+        return header_bytes_ ? static_cast<segment_header*>(base_) : nullptr;
+    }
+
+    // Publishes readiness (release) and wakes waiting openers. Only needed
+    // when the creator passed segment_options::defer_ready.
+    void mark_ready() noexcept {
+        segment_header* h = header();
+        if (!h) return;
+        std::atomic_ref<std::uint32_t>(h->state).store(segment_header::kReady, std::memory_order_release);
+        detail::seg::wake_all_(&h->state);
+    }
+
+    bool is_ready() const noexcept {
+        segment_header* h = header();
+        return !h || std::atomic_ref<std::uint32_t>(h->state).load(std::memory_order_acquire) == segment_header::kReady;
+    }
+
+    // True if this object created the segment rather than opening it.
+    bool is_created() const noexcept { return created_; }
+
+    bool is_valid() const noexcept {
+#if SHM_PLATFORM_WIN32
+        return valid_ && base_ != nullptr && size_ != 0;
+#else
+        return fd_ != -1 && base_ != nullptr && size_ != 0;
+#endif
+    }
+
+    static bool remove(const char* name) noexcept {
+#if SHM_PLATFORM_WIN32
+        (void)name;
+        return true;
+#else
+        const std::string n = detail::seg::normalize_name_(name);
+        if (n.empty()) return false;
+        if (!detail::seg::name_is_portable_(n)) return false;
+
+        if (::shm_unlink(n.c_str()) == 0) return true;
+        if (errno == ENOENT) return true;
+        return false;
+#endif
+    }
+
+    // Removes a segment created with `opts`: the hugetlbfs file for the
+    // hugetlb page policies, otherwise the POSIX shm object.
+    static bool remove(const char* name, const segment_options& opts) noexcept {
+#if defined(__linux__)
+        if (hugetlb_page_(opts.pages) != 0) {
+            const std::string n = detail::seg::normalize_name_(name);
+            if (!detail::seg::name_is_portable_(n)) return false;
+            try {
+                const std::string path = hugetlbfs_path_(opts, n);
+                return ::unlink(path.c_str()) == 0 || errno == ENOENT;
+            } catch (...) {
+                return false;
+            }
+        }
+#else
+        (void)opts;
+#endif
+        return remove(name);
+    }
+
+    // Explicit huge page size in use (hugetlb policies), 0 for base pages/THP.
+    std::size_t huge_page_size() const noexcept { return huge_page_; }
+
+    // How many bytes of the mapping are currently backed by huge pages, THP
+    // or hugetlb, as reported by /proc/self/smaps. Only resident pages count,
+    // so THP coverage grows as the range is touched. 0 where unavailable.
+    std::size_t huge_page_bytes() const noexcept {
+        if (!base_) return 0;
+#if SHM_PLATFORM_WIN32
+        return huge_page_ ? map_size_ : 0;
+#elif defined(__linux__)
+        return detail::seg::smaps_huge_bytes_(base_, map_size_);
+#else
+        return 0;
+#endif
+    }
+
+    template <class Tag>
+    void bind() const noexcept {
+        if (!base_) return;
+        shm::segment_base<Tag>::set(data());
+        track_rebind_(+[](void* b) noexcept { shm::segment_base<Tag>::set(b); });
+    }
+
+    // Binds this mapping as the calling thread's thread_anchor<Tag> base until
+    // the returned guard goes out of scope.
+    template <class Tag>
+    [[nodiscard]] scoped_thread_base<Tag> bind_thread() const noexcept {
+        return scoped_thread_base<Tag>(data());
+    }
+
+    // Registers this mapping in segment_table under `id` for fat_offset_ptr.
+    // The slot is cleared again when the segment is destroyed, unless another
+    // mapping has been registered under the same id since. Fails with
+    // invalid_argument when `id` is outside the table.
+    std::error_code bind_id(segment_id id) noexcept {
+        if (!shm::segment_table::valid(id)) return std::make_error_code(std::errc::invalid_argument);
+        if (!base_) return {};
+        if (table_id_ >= 0 && table_id_ != static_cast<int>(id)) {
+            (void)shm::segment_table::clear(static_cast<segment_id>(table_id_), data());
+        }
+        (void)shm::segment_table::set(id, data(), data_size());
+        table_id_ = static_cast<int>(id);
+        return {};
+    }
+
+    bool is_file_backed() const noexcept { return file_backed_; }
+
+    bool is_mirrored() const noexcept { return mirror_; }
+
+    // Maps the same object again, copy-on-write (MAP_PRIVATE; FILE_MAP_COPY
+    // on Windows): the view starts with the live contents, and its writes
+    // copy the touched pages and stay in this process. Untouched pages keep
+    // following the shared object. Offsets are unchanged, so bind the
+    // view's base (bind<Tag>()) and the same offset pointers resolve in it.
+    // Header fields read through the view are only current on pages it
+    // has not written; coordinate (write sections, grow) through the shared
+    // segment. Throws std::system_error if the mapping fails.
+    [[nodiscard]] std::unique_ptr<segment> open_private_view() const {
+        return std::unique_ptr<segment>(new segment(private_view_t{}, *this));
+    }
+
+    bool is_private() const noexcept { return private_; }
+
+    // Private views: drops every private copy, so the whole view shows the
+    // live shared contents again. Costs one madvise on Linux, a remap in
+    // place elsewhere, plus a minor fault per page touched afterwards; a
+    // no-op on shared segments.
+    std::error_code discard() noexcept {
+        if (!private_ || !base_) return {};
+#if SHM_PLATFORM_WIN32
+        // Remap the copy-on-write view, at the same address when possible.
+        void* const old = base_;
+        DWORD access = FILE_MAP_COPY;
+#if defined(FILE_MAP_LARGE_PAGES)
+        if (huge_page_) access |= FILE_MAP_LARGE_PAGES;
+#endif
+        ::UnmapViewOfFile(old);
+        base_ = ::MapViewOfFileEx(hMapFile_, access, 0, 0, size_, old);
+        if (!base_) base_ = ::MapViewOfFile(hMapFile_, access, 0, 0, size_);
+        if (!base_) {
+            valid_ = false;
+            return std::error_code(static_cast<int>(::GetLastError()), std::system_category());
+        }
+        if (base_ != old) {
+            for (auto fn : rebind_) fn(data());
+        }
+        return {};
+#else
+        return discard_bytes_(0, map_size_);
+#endif
+    }
+
+    // Drops the private copies of the pages fully inside [offset, offset +
+    // len) of data(). Not supported on Windows.
+    std::error_code discard(std::size_t offset, std::size_t len) noexcept {
+        if (!private_ || !base_ || offset >= data_size()) return {};
+#if SHM_PLATFORM_WIN32
+        (void)len;
+        return std::make_error_code(std::errc::not_supported);
+#else
+        len = (std::min)(len, data_size() - offset);
+        const std::size_t unit = unit_ ? unit_ : detail::seg::page_size_();
+        const std::size_t lo = detail::seg::round_up_(header_bytes_ + offset, unit);
+        const std::size_t hi = (header_bytes_ + offset + len) / unit * unit;
+        if (hi <= lo) return {};
+        return discard_bytes_(lo, hi - lo);
+#endif
+    }
+
+    // Contiguous view of `len` bytes starting at data offset `pos` modulo
+    // data_size(), running past the end into the mirror. Requires a
+    // mirrored segment and len <= data_size().
+    std::span<std::byte> ring_view(std::size_t pos, std::size_t len) const noexcept {
+        SHM_ASSERT(mirror_ && len <= data_size());
+        return {static_cast<std::byte*>(data()) + pos % data_size(), len};
+    }
+
+    // Pins the whole mapping, header included, in RAM; the lock lasts until
+    // unlock() or unmapping. Fails with the mlock errno (ENOMEM or EPERM
+    // beyond RLIMIT_MEMLOCK).
+    std::error_code lock(lock_mode mode = lock_mode::now) noexcept {
+        return lock_bytes_(0, mirror_ ? map_size_ : size_, mode);
+    }
+
+    // Pins [offset, offset + len) of data(), widened to whole pages.
+    std::error_code lock(std::size_t offset, std::size_t len, lock_mode mode = lock_mode::now) noexcept {
+        if (offset >= data_size()) return {};
+        return lock_bytes_(header_bytes_ + offset, (std::min)(len, data_size() - offset), mode);
+    }
+
+    std::error_code unlock() noexcept { return lock_bytes_(0, mirror_ ? map_size_ : size_, lock_mode::none); }
+
+    std::error_code unlock(std::size_t offset, std::size_t len) noexcept {
+        if (offset >= data_size()) return {};
+        return lock_bytes_(header_bytes_ + offset, (std::min)(len, data_size() - offset), lock_mode::none);
+    }
+
+    // Counts which pages of [offset, offset + len) of data() are in RAM
+    // right now, so a consumer can check that its hot ranges will not fault.
+    // A snapshot: unlocked pages can be reclaimed right after. Not supported
+    // on Windows.
+    std::error_code residency(std::size_t offset, std::size_t len, residency_report& out) const noexcept {
+        out = residency_report{};
+        const std::size_t ps = detail::seg::page_size_();
+        out.page_bytes = ps;
+        if (!base_ || len == 0 || offset >= data_size()) return {};
+#if SHM_PLATFORM_WIN32
+        return std::make_error_code(std::errc::not_supported);
+#else
+        len = (std::min)(len, data_size() - offset);
+        const std::size_t lo = (header_bytes_ + offset) / ps * ps;
+        const std::size_t hi = detail::seg::round_up_(header_bytes_ + offset + len, ps);
+#if defined(__linux__)
+        unsigned char vec[1024];
+#else
+        char vec[1024];
+#endif
+        for (std::size_t at = lo; at < hi;) {
+            const std::size_t n = (std::min)((hi - at) / ps, sizeof(vec));
+            if (::mincore(static_cast<std::byte*>(base_) + at, n * ps, vec) != 0) {
+                return std::error_code(errno, std::generic_category());
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                if (vec[i] & 1) {
+                    ++out.resident;
+                } else if (out.first_absent == residency_report::npos) {
+                    out.first_absent = at + i * ps - header_bytes_;
+                }
+            }
+            at += n * ps;
+        }
+        out.pages = (hi - lo) / ps;
+        return {};
+#endif
+    }
+
+    std::error_code residency(residency_report& out) const noexcept { return residency(0, data_size(), out); }
+
+    // Applies `a` to [offset, offset + len) of data(), clamped to
+    // data_size() and rounded to the mapping's page size (the huge page size
+    // for hugetlb segments). See shm::advice for the rounding direction.
+    std::error_code advise(std::size_t offset, std::size_t len, advice a) noexcept {
+        if (!base_ || offset >= data_size()) return {};
+        const std::size_t granule = unit_ ? unit_ : detail::seg::page_size_();
+        return detail::seg::advise_(static_cast<std::byte*>(data()) + offset, (std::min)(len, data_size() - offset), a,
+                                    granule);
+    }
+
+    std::error_code advise(advice a) noexcept { return advise(0, data_size(), a); }
+
+    // Writes back the whole mapping, header included. A no-op returning
+    // success for segments that are not file-backed.
+    std::error_code flush(flush_mode mode = flush_mode::sync) noexcept {
+        return flush_bytes_(0, size_, mode);
+    }
+
+    // Writes back [offset, offset + len) of data(), widened to whole pages.
+    std::error_code flush(std::size_t offset, std::size_t len, flush_mode mode = flush_mode::sync) noexcept {
+        if (offset >= data_size()) return {};
+        return flush_bytes_(header_bytes_ + offset, (std::min)(len, data_size() - offset), mode);
+    }
 
-        [[nodiscard]] void* release() noexcept {
-            void* out = p;
-            p = nullptr;
-            return out;
+    // Records that [offset, offset + len) of data() was modified, at
+    // segment_options::dirty_chunk granularity. Lock-free; any thread.
+    void mark_dirty(std::size_t offset, std::size_t len) noexcept {
+        if (!dirty_ || len == 0 || offset >= data_size()) return;
+        len = (std::min)(len, data_size() - offset);
+        const std::size_t first = offset / dirty_chunk_;
+        const std::size_t last = (offset + len - 1) / dirty_chunk_;
+
+        std::int64_t newly = 0;
+        for (std::size_t w = first / 64; w <= last / 64; ++w) {
+            const std::size_t lo = (w == first / 64) ? first % 64 : 0;
+            const std::size_t hi = (w == last / 64) ? last % 64 : 63;
+            const std::uint64_t mask = (~std::uint64_t{0} >> (63 - hi)) & (~std::uint64_t{0} << lo);
+            if ((dirty_[w].load(std::memory_order_relaxed) & mask) == mask) continue;
+            const std::uint64_t prev = dirty_[w].fetch_or(mask, std::memory_order_relaxed);
+            newly += std::popcount(mask & ~prev);
         }
-    };
-
-    
-    [[nodiscard]] inline std::uint64_t query_section_max_size_bytes(HANDLE hMap) noexcept {
-        if (hMap == NULL) return 0;
+        if (newly) dirty_bytes_.fetch_add(newly * static_cast<std::int64_t>(dirty_chunk_), std::memory_order_relaxed);
+    }
 
-        // NtQuerySection signature.
-        using NTSTATUS = long;
-        using SECTION_INFORMATION_CLASS = int;
+    // Bytes currently marked dirty and not yet flushed.
+    std::size_t dirty_bytes() const noexcept {
+        const std::int64_t b = dirty_bytes_.load(std::memory_order_relaxed);
+        return b > 0 ? static_cast<std::size_t>(b) : 0;
+    }
 
-        struct LARGE_INTEGER_ {
-            std::int64_t QuadPart;
+    // Flushes the chunks marked with mark_dirty(), coalescing adjacent ones,
+    // and clears them. In sync mode writeback of every run is started first
+    // and a single MS_SYNC over their span waits for it, so scattered chunks
+    // cost one durability barrier rather than one each. Returns the first
+    // error; chunks that failed are not re-marked.
+    std::error_code flush_dirty(flush_mode mode = flush_mode::sync) noexcept {
+        if (!dirty_) return {};
+        constexpr std::size_t npos = static_cast<std::size_t>(-1);
+        std::error_code first_error;
+        std::size_t run = npos;
+        std::size_t span_lo = npos;
+        std::size_t span_hi = 0;
+        std::int64_t cleared = 0;
+
+        auto close_run = [&](std::size_t end) {
+            const std::size_t off = header_bytes_ + run * dirty_chunk_;
+            const std::size_t len = (std::min)((end - run) * dirty_chunk_, size_ - off);
+            const std::error_code ec = flush_bytes_(off, len, flush_mode::async);
+            if (ec && !first_error) first_error = ec;
+            span_lo = (std::min)(span_lo, off);
+            span_hi = off + len;
+            run = npos;
         };
-        struct SECTION_BASIC_INFORMATION_ {
-            void* BaseAddress;
-            unsigned long AllocationAttributes;
-            LARGE_INTEGER_ MaximumSize;
-        };
-
-        constexpr SECTION_INFORMATION_CLASS SectionBasicInformation = 0;
 
-        using NtQuerySectionFn = NTSTATUS (NTAPI*)(HANDLE, SECTION_INFORMATION_CLASS, void*, unsigned long, unsigned long*);
+        for (std::size_t w = 0; w < dirty_words_; ++w) {
+            std::uint64_t bits = 0;
+            if (dirty_[w].load(std::memory_order_relaxed) != 0) {
+                bits = dirty_[w].exchange(0, std::memory_order_acq_rel);
+            }
+            cleared += std::popcount(bits);
+            if (bits == 0 && run == npos) continue;
+            if (bits == ~std::uint64_t{0} && run != npos) continue;
+            for (std::size_t b = 0; b < 64; ++b) {
+                const bool set = (bits >> b) & 1u;
+                if (set && run == npos) run = w * 64 + b;
+                else if (!set && run != npos) close_run(w * 64 + b);
+            }
+        }
+        if (run != npos) close_run(dirty_words_ * 64);
 
-        HMODULE ntdll = ::GetModuleHandleW(L"ntdll.dll");
-        if (!ntdll) return 0;
+        if (mode == flush_mode::sync && span_lo != npos) {
+            const std::error_code ec = flush_bytes_(span_lo, span_hi - span_lo, flush_mode::sync);
+            if (ec && !first_error) first_error = ec;
+        }
 
-        auto* fn = reinterpret_cast<NtQuerySectionFn>(::GetProcAddress(ntdll, "NtQuerySection"));
-        if (!fn) return 0;
+        if (cleared) dirty_bytes_.fetch_sub(cleared * static_cast<std::int64_t>(dirty_chunk_), std::memory_order_relaxed);
+        return first_error;
+    }
 
-        SECTION_BASIC_INFORMATION_ info{};
-        unsigned long ret_len = 0;
-        NTSTATUS st = fn(hMap, SectionBasicInformation, &info, sizeof(info), &ret_len);
-        if (st < 0) return 0;
-        if (info.MaximumSize.QuadPart <= 0) return 0;
+    // Starts a thread that flushes every interval_ms, or sooner once
+    // dirty_threshold bytes are marked: the marked chunks if there are any,
+    // otherwise the whole mapping. Throws std::invalid_argument if the segment
+    // is not file-backed and std::logic_error if a flusher is running.
+    void start_flusher(const flusher_options& fo = {}) {
+        if (!file_backed_) {
+            throw std::invalid_argument("shm::segment: start_flusher requires a file-backed segment");
+        }
+        if (flusher_) throw std::logic_error("shm::segment: flusher already running");
 
-        return static_cast<std::uint64_t>(info.MaximumSize.QuadPart);
+        auto f = std::make_unique<flusher_state_>();
+        f->opts = fo;
+        flusher_state_* st = f.get();
+        f->thread = std::thread([this, st] { run_flusher_(*st); });
+        flusher_ = std::move(f);
     }
 
-    inline void prefetch_best_effort(void* base, std::size_t bytes) noexcept {
-    #if SHM_WIN32_PREFETCH_BYTES_ON_OPEN
-        if (!base || bytes == 0) return;
+    // Stops the flusher after a final flush. Returns the first error any
+    // background flush reported. Safe to call when no flusher is running.
+    std::error_code stop_flusher() noexcept {
+        if (!flusher_) return {};
+        {
+            std::lock_guard<std::mutex> lk(flusher_->m);
+            flusher_->stop = true;
+        }
+        flusher_->cv.notify_one();
+        flusher_->thread.join();
+        const std::error_code ec = flusher_->first_error;
+        flusher_.reset();
+        return ec;
+    }
 
-        using PrefetchVirtualMemoryFn = BOOL (WINAPI*)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+    // Starts hot/cold tiering of the data region. Every interval_ms each
+    // chunk is sampled: it counts as accessed if more of its pages are
+    // resident than at the previous sample (mincore) or, with soft_dirty, if
+    // it was written. Chunks idle for idle_samples samples get
+    // tiering_options::demote unless none of their pages is in RAM; a
+    // demoted chunk that is accessed again counts as refaulted. Reads of
+    // pages that stay resident are invisible to both signals, so use
+    // pageout where mis-demoting read-hot data must show up in
+    // refaulted_bytes. Where the build lacks the demote advice (anything
+    // but Linux 5.4+), tier_step() reports errc::not_supported. Throws
+    // std::logic_error if tiering is running.
+    void start_tiering(const tiering_options& to = {}) {
+#if SHM_PLATFORM_WIN32
+        (void)to;
+        throw std::system_error(std::make_error_code(std::errc::not_supported),
+                                "shm::segment: tiering is not supported on Windows");
+#else
+        if (tiering_) throw std::logic_error("shm::segment: tiering already running");
+        if (to.demote != advice::cold && to.demote != advice::pageout) {
+            throw std::invalid_argument("shm::segment: tiering demotes with advice::cold or advice::pageout");
+        }
+        auto t = std::make_unique<tiering_state_>();
+        t->opts = to;
+        const std::size_t granule = unit_ ? unit_ : detail::seg::page_size_();
+        t->chunk = detail::seg::round_up_((std::max)(to.chunk_bytes, granule), granule);
+#if defined(__linux__)
+        if (to.soft_dirty) {
+            t->pagemap = ::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+            t->clear_refs = ::open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+            if (t->pagemap < 0 || t->clear_refs < 0 || !detail::seg::soft_dirty_works_(t->pagemap, t->clear_refs)) {
+                t->close_fds();
+            }
+        }
+#endif
+        extend_tiering_(*t);
+        tiering_ = std::move(t);
+        resume_tiering_();
+#endif
+    }
 
-        HMODULE k32 = ::GetModuleHandleW(L"kernel32.dll");
-        if (!k32) return;
+    // Stops the tiering thread. Demoted ranges stay demoted.
+    void stop_tiering() noexcept {
+        if (!tiering_) return;
+        halt_tiering_();
+        tiering_.reset();
+    }
 
-        auto* fn = reinterpret_cast<PrefetchVirtualMemoryFn>(::GetProcAddress(k32, "PrefetchVirtualMemory"));
-        if (!fn) return;
+    // Takes one sample now (the thread, if any, keeps running). Fails with
+    // errc::invalid_argument if tiering was not started, or with the
+    // mincore/madvise errno.
+    std::error_code tier_step() noexcept {
+        if (!tiering_) return std::make_error_code(std::errc::invalid_argument);
+        return tier_step_(*tiering_);
+    }
 
-        WIN32_MEMORY_RANGE_ENTRY range{};
-        range.VirtualAddress = base;
-        range.NumberOfBytes = bytes;
+    tiering_stats tier_stats() const noexcept {
+        tiering_stats out;
+        if (!tiering_) return out;
+        out.samples = tiering_->samples.load(std::memory_order_relaxed);
+        out.demoted_bytes = tiering_->demoted_bytes.load(std::memory_order_relaxed);
+        out.refaulted_bytes = tiering_->refaulted_bytes.load(std::memory_order_relaxed);
+        out.cold_bytes = tiering_->cold_bytes.load(std::memory_order_relaxed);
+        out.soft_dirty = tiering_->clear_refs >= 0;
+        return out;
+    }
 
-        (void)fn(::GetCurrentProcess(), 1, &range, 0);
-    #else
-        (void)base;
-        (void)bytes;
-    #endif
+    // Grows the data region to at least `new_size` bytes for every process
+    // attached to the segment: the backing object is extended, the header's
+    // data_size and generation are published, and this mapping is remapped
+    // with refresh(). Never shrinks. Requires segment_options::header; throws
+    // std::system_error if the object cannot be extended or remapped. Darwin
+    // sizes a POSIX shm object only once, so there only file-backed segments
+    // grow and the rest throw errc::not_supported.
+    void grow(std::size_t new_size) {
+        segment_header* h = header();
+        if (!h) throw std::invalid_argument("shm::segment: grow requires segment_options::header");
+#if SHM_PLATFORM_WIN32
+        (void)new_size;
+        throw std::system_error(std::make_error_code(std::errc::not_supported),
+                                "shm::segment: pagefile-backed sections cannot grow");
+#else
+        if (mirror_) throw std::invalid_argument("shm::segment: mirrored segments cannot grow");
+        if (private_) throw std::invalid_argument("shm::segment: grow the shared segment, not a private view");
+#if defined(__APPLE__)
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) throw_errno_("fstat(grow)");
+        if (!S_ISREG(st.st_mode)) {
+            throw std::system_error(std::make_error_code(std::errc::not_supported),
+                                    "shm::segment: Darwin cannot resize a POSIX shm object; grow needs a file-backed segment");
+        }
+#endif
+        {
+            grow_guard_ guard(*h);
+            std::atomic_ref<std::uint64_t> published(h->data_size);
+            if (new_size > published.load(std::memory_order_relaxed)) {
+                const std::size_t total = huge_page_ ? detail::seg::round_up_(header_bytes_ + new_size, huge_page_)
+                                                     : header_bytes_ + new_size;
+                if (::ftruncate(fd_, static_cast<off_t>(total)) != 0) throw_errno_("ftruncate(grow)");
+                published.store(total - header_bytes_, std::memory_order_relaxed);
+                std::atomic_ref<std::uint64_t>(h->generation).fetch_add(1, std::memory_order_release);
+            }
+        }
+        (void)refresh();
+#endif
     }
 
-    #if defined(SHM_WIN32_USE_SDDL_DACL)
+    // Migration-aware write sections (see migrate_segment). begin_write()
+    // blocks while a migration is quiescing writers and returns false once
+    // the segment has moved; reopen forwarded_to() then. Between begin and
+    // end, report every modified range with note_write(). Segments without a
+    // header accept every write and ignore the notes.
+    [[nodiscard]] bool begin_write() noexcept {
+        segment_header* h = header();
+        if (!h) return true;
+        std::atomic_ref<std::uint32_t> state(h->migration);
+        std::atomic_ref<std::uint32_t> writers(h->writers);
+        for (;;) {
+            writers.fetch_add(1, std::memory_order_seq_cst);
+            const std::uint32_t st = state.load(std::memory_order_seq_cst);
+            if (st < segment_header::kQuiescing) return true;
+            writers.fetch_sub(1, std::memory_order_seq_cst);
+            if (st == segment_header::kMoved) return false;
+            (void)detail::seg::wait_while_(&h->migration, st, 100);
+        }
+    }
 
-    struct sddl_security final {
-        SECURITY_ATTRIBUTES sa{};
-        PSECURITY_DESCRIPTOR sd = nullptr;
+    void end_write() noexcept {
+        if (segment_header* h = header()) {
+            std::atomic_ref<std::uint32_t>(h->writers).fetch_sub(1, std::memory_order_release);
+        }
+    }
 
-        sddl_security() noexcept = default;
-        sddl_security(const sddl_security&) = delete;
-        sddl_security& operator=(const sddl_security&) = delete;
+    // Call after the bytes are written. Costs a fence and a load when no
+    // migration is running; the fence orders the write against the
+    // migrator's switch to copying so no update can be missed.
+    void note_write(std::size_t offset, std::size_t len) noexcept {
+        segment_header* h = header();
+        if (!h || len == 0) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (std::atomic_ref<std::uint32_t>(h->migration).load(std::memory_order_acquire) ==
+            segment_header::kMigrationIdle) {
+            return;
+        }
+        constexpr std::size_t kBits = segment_header::kDirtyWords * 64;
+        const unsigned shift = std::atomic_ref<std::uint32_t>(h->dirty_shift).load(std::memory_order_relaxed);
+        const std::size_t first = (std::min)(offset >> shift, kBits - 1);
+        const std::size_t last = (std::min)((offset + len - 1) >> shift, kBits - 1);
+        for (std::size_t w = first / 64; w <= last / 64; ++w) {
+            const std::size_t lo = (w == first / 64) ? first % 64 : 0;
+            const std::size_t hi = (w == last / 64) ? last % 64 : 63;
+            const std::uint64_t mask = (~std::uint64_t{0} >> (63 - hi)) & (~std::uint64_t{0} << lo);
+            std::atomic_ref<std::uint64_t>(h->dirty[w]).fetch_or(mask, std::memory_order_relaxed);
+        }
+    }
 
-        ~sddl_security() noexcept {
-            if (sd) {
-                ::LocalFree(sd);
-                sd = nullptr;
-            }
+    // Name of the segment this one was migrated to, or nullptr.
+    const char* forwarded_to() const noexcept {
+        segment_header* h = header();
+        if (!h || std::atomic_ref<std::uint32_t>(h->migration).load(std::memory_order_acquire) !=
+                      segment_header::kMoved) {
+            return nullptr;
         }
+        return h->forward_name;
+    }
 
-        [[nodiscard]] SECURITY_ATTRIBUTES* build_or_throw(std::wstring_view sddl, std::string_view name_for_errors) {
-            if (sddl.empty()) return nullptr;
+    // Generation of the size this mapping reflects; see stale().
+    std::uint64_t generation() const noexcept { return generation_; }
 
-            if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(
-                    sddl.data(), SDDL_REVISION_1, &sd, nullptr)) {
-                throw win32_error("ConvertStringSecurityDescriptorToSecurityDescriptorW", name_for_errors, last_error());
-            }
+    // True if some process has grown the segment since this mapping was
+    // last refreshed. One acquire load; cheap enough for a hot path.
+    bool stale() const noexcept {
+        segment_header* h = header();
+        return h && std::atomic_ref<std::uint64_t>(h->generation).load(std::memory_order_acquire) != generation_;
+    }
 
-            sa.nLength = sizeof(SECURITY_ATTRIBUTES);
-            sa.lpSecurityDescriptor = sd;
-            sa.bInheritHandle = FALSE;
-            return &sa;
+    // Adopts the newest size published by grow(). Offsets stay valid, but
+    // data() may move: no thread of this process may be using addresses from
+    // the old mapping, and bind_thread() guards must be re-taken. Bases set
+    // with bind() and bind_id() are rebound, and a running flusher is
+    // restarted. Returns true if the mapping changed.
+    bool refresh() {
+        segment_header* h = header();
+        if (!h) return false;
+        const std::uint64_t gen = std::atomic_ref<std::uint64_t>(h->generation).load(std::memory_order_acquire);
+        if (gen == generation_) return false;
+        const std::size_t want =
+            header_bytes_ + std::atomic_ref<std::uint64_t>(h->data_size).load(std::memory_order_relaxed);
+        if (want <= size_) {
+            generation_ = gen;
+            return false;
         }
-    };  
-    #endif
-
+#if SHM_PLATFORM_WIN32
+        return false;
+#else
+        remap_(want);
+        generation_ = gen;
+        return true;
 #endif
-} // namespace detail::seg
-
+    }
 
-class segment {
-public:
-    enum class open_mode { create_only, open_only, open_or_create };
+private:
+    struct private_view_t {};
 
-    segment(const char* name, std::size_t size, open_mode mode)
+    segment(private_view_t, const segment& src)
 #if SHM_PLATFORM_WIN32
         : hMapFile_(NULL)
         , base_(nullptr)
@@ -1279,303 +4725,582 @@ public:
         , map_size_(0)
         , valid_(false)
         , created_(false)
-        , name_(detail::seg::normalize_name_(name))
+        , name_(src.name_)
+    {
+        if (!src.base_ || src.hMapFile_ == NULL) {
+            throw std::invalid_argument("shm::segment: private view of an unmapped segment");
+        }
+        HANDLE dup = NULL;
+        if (!::DuplicateHandle(::GetCurrentProcess(), src.hMapFile_, ::GetCurrentProcess(), &dup, 0, FALSE,
+                               DUPLICATE_SAME_ACCESS)) {
+            throw detail::seg::win32_error("DuplicateHandle(private_view)", name_, detail::seg::last_error());
+        }
+        detail::seg::unique_handle h(dup);
+        DWORD access = FILE_MAP_COPY;
+#if defined(FILE_MAP_LARGE_PAGES)
+        if (src.huge_page_) access |= FILE_MAP_LARGE_PAGES;
+#endif
+        void* view = ::MapViewOfFile(h.get(), access, 0, 0, src.size_);
+        if (!view) throw detail::seg::win32_error("MapViewOfFile(FILE_MAP_COPY)", name_, detail::seg::last_error());
+
+        hMapFile_ = h.release();
+        base_ = view;
+        size_ = src.size_;
+        map_size_ = src.map_size_;
+        valid_ = true;
+        header_bytes_ = src.header_bytes_;
+        huge_page_ = src.huge_page_;
+        generation_ = src.generation_;
+        private_ = true;
+    }
 #else
         : fd_(-1)
         , base_(nullptr)
         , size_(0)
         , map_size_(0)
         , created_(false)
-        , name_(detail::seg::normalize_name_(name))
-#endif
+        , name_(src.name_)
     {
-        if (name_.empty()) {
-            throw std::invalid_argument("shm::segment: name must not be null/empty");
+        if (!src.base_ || src.fd_ < 0) {
+            throw std::invalid_argument("shm::segment: private view of an unmapped segment");
         }
-
-#if SHM_PLATFORM_WIN32
-        const bool may_create = (mode == open_mode::create_only || mode == open_mode::open_or_create);
-        if (may_create && size == 0) {
-            throw std::invalid_argument("shm::segment: size must be > 0 for create modes");
+        fd_ = ::fcntl(src.fd_, F_DUPFD_CLOEXEC, 0);
+        if (fd_ == -1) throw_errno_("dup(private_view)");
+
+        size_ = src.size_;
+        unit_ = src.unit_;
+        map_size_ = detail::seg::round_up_(size_, unit_);
+        huge_page_ = src.huge_page_;
+        pages_ = src.pages_;
+        header_bytes_ = src.header_bytes_;
+        generation_ = src.generation_;
+        private_ = true;
+
+        void* map = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_, 0);
+        if (map == MAP_FAILED) {
+            const int saved = errno;
+            release_fd_();
+            throw_errno_("mmap(private_view)", saved);
         }
+        base_ = map;
+#if defined(MADV_DONTDUMP)
+        (void)::madvise(base_, map_size_, MADV_DONTDUMP);
+#endif
+    }
+#endif
 
-        const std::wstring wname = detail::seg::win32_object_name_from_portable(name_);
-
-        constexpr DWORD kMapAccess   = SHM_WIN32_MAP_ACCESS;
-        constexpr DWORD kPageProtect = PAGE_READWRITE;
-
-        auto harden_handle_noninherit = [](HANDLE h) noexcept {
-            if (h != NULL) (void)::SetHandleInformation(h, HANDLE_FLAG_INHERIT, 0);
-        };
+    struct flusher_state_ {
+        flusher_options opts;
+        std::mutex m;
+        std::condition_variable cv;
+        bool stop = false;
+        std::error_code first_error;
+        std::thread thread;
+    };
 
-        detail::seg::unique_handle h;
-        detail::seg::unique_view   v;
+    struct tiering_state_ {
+        tiering_options opts;
+        std::mutex m;             // guards stop
+        std::condition_variable cv;
+        bool stop = false;
+        std::thread thread;
+        std::mutex step_m;        // serializes samples
+        std::size_t chunk = 0;
+        std::vector<std::uint32_t> idle;        // samples since the last access
+        std::vector<std::uint32_t> resident;    // pages in RAM at the last sample
+        std::vector<std::uint8_t> demoted;
+        std::vector<std::uint8_t> strikes;      // refaults; lengthen the next wait
+        int pagemap = -1;
+        int clear_refs = -1;
+        std::atomic<std::uint64_t> samples{0};
+        std::atomic<std::uint64_t> demoted_bytes{0};
+        std::atomic<std::uint64_t> refaulted_bytes{0};
+        std::atomic<std::uint64_t> cold_bytes{0};
+
+        void close_fds() noexcept {
+#if !SHM_PLATFORM_WIN32
+            if (pagemap >= 0) (void)::close(pagemap);
+            if (clear_refs >= 0) (void)::close(clear_refs);
+#endif
+            pagemap = -1;
+            clear_refs = -1;
+        }
+        ~tiering_state_() { close_fds(); }
+    };
 
-        bool created_local = false;
-        std::size_t exposed_size = 0;
+    void halt_tiering_() noexcept {
+        if (!tiering_ || !tiering_->thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lk(tiering_->m);
+            tiering_->stop = true;
+        }
+        tiering_->cv.notify_one();
+        tiering_->thread.join();
+    }
 
-        const auto& si = detail::seg::sysinfo();
-        const std::size_t create_max =
-            may_create ? detail::seg::round_up(size, static_cast<std::size_t>(si.page_size)) : 0;
+    void resume_tiering_() {
+        tiering_state_* st = tiering_.get();
+        if (!st || st->opts.interval_ms == 0) return;
+        st->stop = false;
+        st->thread = std::thread([this, st] {
+            const auto interval = std::chrono::milliseconds(st->opts.interval_ms);
+            std::unique_lock<std::mutex> lk(st->m);
+            while (!st->cv.wait_for(lk, interval, [st] { return st->stop; })) {
+                lk.unlock();
+                (void)tier_step_(*st);
+                lk.lock();
+            }
+        });
+    }
 
-        SECURITY_ATTRIBUTES* psa = nullptr;
-#if defined(SHM_WIN32_USE_SDDL_DACL)
-        detail::seg::sddl_security sec;
-#ifndef SHM_WIN32_SDDL_STRING
-# error SHM_WIN32_USE_SDDL_DACL requires SHM_WIN32_SDDL_STRING, e.g. L"D:(A;;GA;;;WD)"
+#if !SHM_PLATFORM_WIN32
+    // Adds per-chunk state for data that appeared since the last call
+    // (start, grow), with the current residency as baseline.
+    void extend_tiering_(tiering_state_& st) noexcept {
+        const std::size_t ps = detail::seg::page_size_();
+        const std::size_t chunks = (data_size() + st.chunk - 1) / st.chunk;
+        auto* data = static_cast<std::byte*>(this->data());
+        try {
+            for (std::size_t c = st.idle.size(); c < chunks; ++c) {
+                const std::size_t off = c * st.chunk;
+                const std::ptrdiff_t r =
+                    detail::seg::count_resident_(data + off, (std::min)(st.chunk, data_size() - off), ps);
+                st.idle.push_back(0);
+                st.resident.push_back(r > 0 ? static_cast<std::uint32_t>(r) : 0u);
+                st.demoted.push_back(0);
+                st.strikes.push_back(0);
+            }
+        } catch (...) {
+            // Out of memory: chunks past the end stay untracked.
+        }
+#if defined(__linux__)
+        if (st.clear_refs >= 0) (void)detail::seg::clear_soft_dirty_(st.clear_refs);
 #endif
-        psa = sec.build_or_throw(SHM_WIN32_SDDL_STRING, name_);
+    }
 #endif
 
-        if (mode == open_mode::open_only) {
-            HANDLE hm = ::OpenFileMappingW(kMapAccess, FALSE, wname.c_str());
-            if (hm == NULL) {
-                throw detail::seg::win32_error("OpenFileMappingW(open_only)", name_, detail::seg::last_error());
-            }
-            harden_handle_noninherit(hm);
-            h.reset(hm);
-            created_local = false;
-        } else {
-            ULARGE_INTEGER win_size{};
-            win_size.QuadPart = static_cast<unsigned long long>(create_max);
-
-            ::SetLastError(0);
-            HANDLE hm = ::CreateFileMappingW(INVALID_HANDLE_VALUE,
-                                             psa,
-                                             kPageProtect,
-                                             win_size.HighPart,
-                                             win_size.LowPart,
-                                             wname.c_str());
-            if (hm == NULL) {
-                throw detail::seg::win32_error("CreateFileMappingW", name_, detail::seg::last_error());
+    std::error_code tier_step_(tiering_state_& st) noexcept {
+#if SHM_PLATFORM_WIN32
+        (void)st;
+        return std::make_error_code(std::errc::not_supported);
+#else
+        std::lock_guard<std::mutex> lk(st.step_m);
+        const std::size_t ps = detail::seg::page_size_();
+        auto* data = static_cast<std::byte*>(this->data());
+        std::error_code first_error;
+
+        for (std::size_t c = 0; c < st.idle.size(); ++c) {
+            const std::size_t off = c * st.chunk;
+            const std::size_t len = (std::min)(st.chunk, data_size() - off);
+            std::ptrdiff_t r = detail::seg::count_resident_(data + off, len, ps);
+            if (r < 0) {
+                if (!first_error) first_error = std::error_code(errno, std::generic_category());
+                continue;
             }
-            harden_handle_noninherit(hm);
-            h.reset(hm);
-
-            const DWORD last = ::GetLastError();
-            if (last == ERROR_ALREADY_EXISTS) {
-                created_local = false;
-                if (mode == open_mode::create_only) {
-                    throw detail::seg::win32_error("CreateFileMappingW(create_only exists)", name_, last);
+            bool accessed = static_cast<std::uint32_t>(r) > st.resident[c];
+#if defined(__linux__)
+            if (!accessed && st.pagemap >= 0) accessed = detail::seg::any_soft_dirty_(st.pagemap, data + off, len, ps);
+#endif
+            if (accessed) {
+                if (st.demoted[c]) {
+                    st.demoted[c] = 0;
+                    st.refaulted_bytes.fetch_add(len, std::memory_order_relaxed);
+                    st.cold_bytes.fetch_sub(len, std::memory_order_relaxed);
+                    if (st.strikes[c] < 4) ++st.strikes[c];
+                }
+                st.idle[c] = 0;
+            } else if (!st.demoted[c] && ++st.idle[c] >= (st.opts.idle_samples << st.strikes[c]) && r > 0) {
+                const std::error_code ec = detail::seg::advise_(data + off, len, st.opts.demote, unit_ ? unit_ : ps);
+                if (ec) {
+                    if (!first_error) first_error = ec;
+                } else {
+                    st.demoted[c] = 1;
+                    st.demoted_bytes.fetch_add(len, std::memory_order_relaxed);
+                    st.cold_bytes.fetch_add(len, std::memory_order_relaxed);
+                    // pageout drops pages; later growth is a refault.
+                    const std::ptrdiff_t after = detail::seg::count_resident_(data + off, len, ps);
+                    if (after >= 0) r = after;
                 }
-            } else {
-                created_local = true;
             }
+            st.resident[c] = static_cast<std::uint32_t>(r);
         }
+#if defined(__linux__)
+        // Writes between a chunk's check and this reset are not seen; a
+        // sample is a heuristic, not an access log.
+        if (st.clear_refs >= 0) (void)detail::seg::clear_soft_dirty_(st.clear_refs);
+#endif
+        st.samples.fetch_add(1, std::memory_order_relaxed);
+        return first_error;
+#endif
+    }
 
-        void* view = ::MapViewOfFile(h.get(), kMapAccess, 0, 0, 0);
-        if (!view) {
-            throw detail::seg::win32_error("MapViewOfFile", name_, detail::seg::last_error());
-        }
-        v.reset(view);
+    void run_flusher_(flusher_state_& st) noexcept {
+        using clock = std::chrono::steady_clock;
+        const bool periodic = st.opts.interval_ms != 0;
+        const auto interval = std::chrono::milliseconds(periodic ? st.opts.interval_ms : 1000);
+        const auto threshold = static_cast<std::int64_t>(st.opts.dirty_threshold);
+        const auto step = threshold > 0
+            ? (std::min)(interval, std::chrono::milliseconds((std::max)(st.opts.poll_ms, 1u)))
+            : interval;
+
+        auto flush_once = [&] {
+            const std::error_code ec = dirty_bytes_.load(std::memory_order_relaxed) > 0
+                ? flush_dirty(st.opts.mode) : flush(st.opts.mode);
+            if (ec && !st.first_error) st.first_error = ec;
+        };
 
-        std::uint64_t max_bytes = detail::seg::query_section_max_size_bytes(h.get());
-        if (max_bytes == 0) {
-            MEMORY_BASIC_INFORMATION mbi{};
-            if (::VirtualQuery(v.get(), &mbi, sizeof(mbi)) == 0) {
-                throw detail::seg::win32_error("VirtualQuery", name_, detail::seg::last_error());
-            }
-            max_bytes = static_cast<std::uint64_t>(mbi.RegionSize);
-        }
-        if (max_bytes == 0) {
-            throw detail::seg::win32_error("query mapping size (0)", name_, ERROR_INVALID_PARAMETER);
+        auto due = clock::now() + interval;
+        std::unique_lock<std::mutex> lk(st.m);
+        while (!st.stop) {
+            st.cv.wait_for(lk, step, [&] { return st.stop; });
+            if (st.stop) break;
+            const bool over = threshold > 0 && dirty_bytes_.load(std::memory_order_relaxed) >= threshold;
+            if (!over && (!periodic || clock::now() < due)) continue;
+            lk.unlock();
+            flush_once();
+            lk.lock();
+            due = clock::now() + interval;
         }
+        lk.unlock();
+        flush_once();
+    }
 
-        if (!created_local) {
-            if (size != 0 && max_bytes < static_cast<std::uint64_t>(size)) {
-                throw detail::seg::win32_error("segment(open existing smaller than requested)",
-                                               name_, ERROR_INSUFFICIENT_BUFFER);
-            }
-            exposed_size = (size == 0) ? static_cast<std::size_t>(max_bytes) : size;
-        } else {
-            if (static_cast<std::uint64_t>(size) > max_bytes) {
-                throw detail::seg::win32_error("segment(created smaller than requested)",
-                                               name_, ERROR_INSUFFICIENT_BUFFER);
+    // [off, off + len) relative to base_, widened to pages and clamped to the
+    // mapping.
+    std::error_code flush_bytes_(std::size_t off, std::size_t len, flush_mode mode) noexcept {
+        if (!file_backed_ || !base_ || len == 0) return {};
+#if SHM_PLATFORM_WIN32
+        (void)off;
+        (void)mode;
+        return {};
+#else
+        const std::size_t ps = detail::seg::page_size_();
+        const std::size_t lo = off / ps * ps;
+        const std::size_t hi = (std::min)(detail::seg::round_up_(off + len, ps), map_size_);
+        if (hi <= lo) return {};
+        if (mode == flush_mode::async) {
+#if defined(__linux__) && defined(SYNC_FILE_RANGE_WRITE)
+            if (::sync_file_range(fd_, static_cast<off_t>(lo), static_cast<off_t>(hi - lo), SYNC_FILE_RANGE_WRITE) == 0) {
+                return {};
             }
-            exposed_size = size;
+#endif
         }
-
-        if (!created_local) {
-            constexpr std::size_t want = static_cast<std::size_t>(SHM_WIN32_PREFETCH_BYTES_ON_OPEN);
-            if constexpr (want != 0) {
-                const std::size_t n = (want < exposed_size) ? want : exposed_size;
-                detail::seg::prefetch_best_effort(v.get(), n);
-            }
+        const int flags = (mode == flush_mode::sync) ? MS_SYNC : MS_ASYNC;
+        if (::msync(static_cast<std::byte*>(base_) + lo, hi - lo, flags) != 0) {
+            return std::error_code(errno, std::generic_category());
         }
-
-#if SHM_WIN32_TRY_VIRTUAL_LOCK
-        (void)::VirtualLock(v.get(), exposed_size);
+        return {};
 #endif
+    }
 
-#if SHM_WIN32_ZERO_ON_CREATE
-        if (created_local && exposed_size != 0) {
-            std::memset(v.get(), 0, exposed_size);
+#if !SHM_PLATFORM_WIN32
+    // Private views: [off, off + len) of the mapping (unit aligned) shows
+    // the object again. Only Linux drops private copies on MADV_DONTNEED;
+    // other systems may keep them, so there the range is mapped afresh over
+    // itself. A private view maps the object once from offset 0, so mapping
+    // and file offsets coincide.
+    std::error_code discard_bytes_(std::size_t off, std::size_t len) noexcept {
+        void* p = static_cast<std::byte*>(base_) + off;
+#if defined(__linux__)
+        if (::madvise(p, len, MADV_DONTNEED) != 0) return std::error_code(errno, std::generic_category());
+#else
+        if (::mmap(p, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd_, static_cast<off_t>(off)) ==
+            MAP_FAILED) {
+            return std::error_code(errno, std::generic_category());
         }
 #endif
+        return {};
+    }
+#endif
 
-        hMapFile_ = h.release();
-        base_     = v.release();
-        size_     = exposed_size;
-        map_size_ = static_cast<std::size_t>(max_bytes);
-        created_  = created_local;
-        valid_    = (base_ != nullptr && hMapFile_ != NULL && size_ != 0);
-
+    // mode none unlocks. [off, off + len) is relative to base_.
+    std::error_code lock_bytes_(std::size_t off, std::size_t len, lock_mode mode) noexcept {
+        if (!base_ || len == 0) return {};
+        const std::size_t ps = detail::seg::page_size_();
+        const std::size_t lo = off / ps * ps;
+        const std::size_t hi = detail::seg::round_up_(off + len, ps);
+        void* p = static_cast<std::byte*>(base_) + lo;
+        const std::size_t n = hi - lo;
+#if SHM_PLATFORM_WIN32
+        const BOOL ok = (mode == lock_mode::none) ? ::VirtualUnlock(p, n) : ::VirtualLock(p, n);
+        if (!ok) {
+            const DWORD e = ::GetLastError();
+            // Unlocking pages that were never locked is not an error here.
+            if (mode == lock_mode::none && e == ERROR_NOT_LOCKED) return {};
+            return std::error_code(static_cast<int>(e), std::system_category());
+        }
+        return {};
 #else
-        if (!detail::seg::name_is_portable_(name_)) {
-            throw std::invalid_argument("shm::segment: name must be portable POSIX shm form '/X' with no additional '/'");
+        int rc = 0;
+        if (mode == lock_mode::none) {
+            rc = ::munlock(p, n);
+        } else {
+#if defined(__linux__) && defined(MLOCK_ONFAULT)
+            if (mode == lock_mode::on_fault) {
+                rc = ::mlock2(p, n, MLOCK_ONFAULT);
+                if (rc == 0 || errno != ENOSYS) {
+                    return rc == 0 ? std::error_code{} : std::error_code(errno, std::generic_category());
+                }
+            }
+#endif
+            rc = ::mlock(p, n);
         }
+        return rc == 0 ? std::error_code{} : std::error_code(errno, std::generic_category());
+#endif
+    }
 
-        const bool may_create = (mode == open_mode::create_only || mode == open_mode::open_or_create);
-        if (may_create && size == 0) {
-            throw std::invalid_argument("shm::segment: size must be > 0 for create modes");
+    static constexpr std::size_t hugetlb_page_(page_policy p) noexcept {
+        switch (p) {
+            case page_policy::hugetlb_2m: return std::size_t{1} << 21;
+            case page_policy::hugetlb_1g: return std::size_t{1} << 30;
+            default: return 0;
         }
+    }
 
-        const std::size_t ps = detail::seg::page_size_();
-        const int perms = 0600;
+    static std::string hugetlbfs_path_(const segment_options& opts, const std::string& name) {
+        std::string path = opts.hugetlbfs_dir ? opts.hugetlbfs_dir
+                         : opts.pages == page_policy::hugetlb_1g ? "/dev/hugepages1G" : "/dev/hugepages";
+        while (!path.empty() && path.back() == '/') path.pop_back();
+        path += name;   // name is "/X"
+        return path;
+    }
 
-        int flags = O_RDWR;
-#if defined(O_CLOEXEC)
-        flags |= O_CLOEXEC;
+#if !SHM_PLATFORM_WIN32
+    // Maps fd_ (size_ bytes, rounded to `unit`) and applies opts: page
+    // advice, zeroing when created_, prefault and the header handshake. On
+    // failure the mapping and fd_ are released before the exception escapes.
+    void map_fd_(const segment_options& opts, std::size_t unit, std::size_t header_bytes) {
+        try {
+            check_table_id_(opts);
+        } catch (...) {
+            release_fd_();
+            throw;
+        }
+        if (opts.mirror) {
+            const std::size_t data_bytes = size_ - header_bytes;
+            if (data_bytes == 0 || data_bytes % unit != 0 || header_bytes % unit != 0) {
+                release_fd_();
+                throw std::invalid_argument(
+                    "shm::segment: mirror needs a data size that is a multiple of the page size");
+            }
+            map_size_ = size_ + data_bytes;
+        } else {
+            map_size_ = detail::seg::round_up_(size_, unit);
+        }
+        unit_ = unit;
+        fixed_ = (opts.fixed_address != nullptr);
+        pages_ = opts.pages;
+        mirror_ = opts.mirror;
+
+        int populate_flag = 0;
+#if !defined(MADV_POPULATE_WRITE) && defined(MAP_POPULATE)
+        if (opts.prefault == prefault_mode::populate) populate_flag = MAP_POPULATE;
 #endif
-
-        auto throw_errno = [&](const char* op) -> void {
-            const int e = errno;
-            std::error_code ec(e, std::generic_category());
-            std::string msg;
-            msg.reserve(256);
-            msg.append("shm::segment: ");
-            msg.append(op);
-            msg.append(" failed (name=");
-            msg.append(name_);
-            msg.append(", errno=");
-            msg.append(std::to_string(e));
-            msg.append(", ");
-            msg.append(ec.message());
-            msg.append(")");
-            throw std::system_error(ec, msg);
-        };
-
-        auto close_noexcept = [&](int& fd) noexcept {
-            if (fd != -1) {
-                (void)detail::seg::retry_eintr_call_(::close, fd);
-                fd = -1;
+        int map_flags = MAP_SHARED | populate_flag;
+        if (opts.fixed_address) {
+            if (detail::addr(opts.fixed_address) % unit != 0) {
+                release_fd_();
+                throw std::invalid_argument("shm::segment: fixed_address must be page aligned");
             }
-        };
-
-        auto unlink_noexcept = [&]() noexcept {
-            if (!name_.empty()) (void)::shm_unlink(name_.c_str());
-        };
+#if defined(MAP_FIXED_NOREPLACE)
+            map_flags |= MAP_FIXED_NOREPLACE;
+#endif
+        }
 
-        auto fail_ctor = [&](bool unlink_if_created) -> void {
-            if (base_) {
-                ::munmap(base_, map_size_);
-                base_ = nullptr;
-                size_ = 0;
-                map_size_ = 0;
-            }
-            close_noexcept(fd_);
-            if (unlink_if_created) unlink_noexcept();
-        };
+        void* map = opts.mirror ? map_mirror_(opts.fixed_address, populate_flag, header_bytes, unit)
+                                : ::mmap(opts.fixed_address, map_size_, PROT_READ | PROT_WRITE, map_flags, fd_, 0);
+        if (map == MAP_FAILED) {
+            const int saved = errno;
+            release_fd_();
+            throw_errno_(opts.fixed_address ? "mmap(fixed_address)" : "mmap", saved);
+        }
 
-        int fd = -1;
-        if (mode == open_mode::create_only) {
-            fd = ::shm_open(name_.c_str(), flags | O_CREAT | O_EXCL, perms);
-            if (fd == -1) throw_errno("shm_open(create_only)");
-            created_ = true;
-        } else if (mode == open_mode::open_only) {
-            fd = ::shm_open(name_.c_str(), flags, perms);
-            if (fd == -1) throw_errno("shm_open(open_only)");
-            created_ = false;
-        } else {
-            fd = ::shm_open(name_.c_str(), flags | O_CREAT | O_EXCL, perms);
-            if (fd == -1) {
-                if (errno != EEXIST) throw_errno("shm_open(open_or_create/create)");
-                fd = ::shm_open(name_.c_str(), flags, perms);
-                if (fd == -1) throw_errno("shm_open(open_or_create/open)");
-                created_ = false;
-            } else {
-                created_ = true;
-            }
+        // Kernels without MAP_FIXED_NOREPLACE treat the address as a hint.
+        if (opts.fixed_address && map != opts.fixed_address) {
+            ::munmap(map, map_size_);
+            release_fd_();
+            throw_errno_("mmap(fixed_address)", EEXIST);
         }
 
-        fd_ = fd;
+        base_ = map;
+
+#if defined(MADV_DONTDUMP)
+        (void)::madvise(base_, map_size_, MADV_DONTDUMP);
+#endif
+        switch (opts.pages) {
+#if defined(MADV_HUGEPAGE)
+            case page_policy::thp_advise: (void)::madvise(base_, map_size_, MADV_HUGEPAGE); break;
+#endif
+#if defined(MADV_NOHUGEPAGE)
+            case page_policy::thp_never: (void)::madvise(base_, map_size_, MADV_NOHUGEPAGE); break;
+#endif
+            default: break;
+        }
 
-        std::size_t seg_size = 0;
         if (created_) {
-            if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
-                const int saved = errno;
-                fail_ctor(true);
-                errno = saved;
-                throw_errno("ftruncate(create)");
-            }
-            seg_size = size;
-        } else {
-            struct stat st{};
-            bool ok = false;
+            bool zeroed = (opts.zero != zero_mode::memset);
+#if defined(MADV_REMOVE)
+            if (opts.zero == zero_mode::lazy) zeroed = ::madvise(base_, map_size_, MADV_REMOVE) == 0;
+#else
+            if (opts.zero == zero_mode::lazy) zeroed = false;
+#endif
+            if (!zeroed) std::memset(base_, 0, size_);
+        }
 
-            for (std::size_t attempt = 0; attempt < 200; ++attempt) {
-                if (::fstat(fd_, &st) != 0) {
-                    const int saved = errno;
-                    fail_ctor(false);
-                    errno = saved;
-                    throw_errno("fstat(open)");
-                }
-                if (st.st_size > 0) { ok = true; break; }
-                detail::seg::nanosleep_backoff_(attempt);
+        if (opts.prefault != prefault_mode::none) {
+            bool populated = false;
+#if defined(MADV_POPULATE_WRITE)
+            if (opts.prefault == prefault_mode::populate) {
+                populated = ::madvise(base_, map_size_, MADV_POPULATE_WRITE) == 0;
             }
+#elif defined(MAP_POPULATE)
+            populated = (opts.prefault == prefault_mode::populate);
+#endif
+            if (!populated) detail::seg::touch_pages_(base_, size_, unit, opts.prefault_threads);
+        }
 
-            if (!ok) {
-                fail_ctor(false);
-                throw std::runtime_error("shm::segment: existing segment reports size 0 after retries");
+        if (opts.lock != lock_mode::none) {
+            if (const std::error_code ec = lock_bytes_(0, map_size_, opts.lock)) {
+                release_fd_();
+                throw_errno_(opts.lock == lock_mode::on_fault ? "mlock2(MLOCK_ONFAULT)" : "mlock", ec.value());
             }
+        }
 
-            const std::size_t existing = static_cast<std::size_t>(st.st_size);
-            if (size != 0 && existing < size) {
-                fail_ctor(false);
-                throw std::runtime_error("shm::segment: existing segment smaller than requested size");
+        if (opts.header) {
+            header_bytes_ = header_bytes;
+            if (const char* err = attach_header_(opts)) {
+                release_fd_();
+                header_bytes_ = 0;
+                throw std::runtime_error(err);
             }
-            seg_size = existing;
         }
+        if (opts.table_id >= 0) (void)bind_id(static_cast<segment_id>(opts.table_id));
+    }
 
-        size_ = seg_size;
-        map_size_ = detail::seg::round_up_(seg_size, ps);
-
-        void* map = ::mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
-        if (map == MAP_FAILED) {
+    // Reserves map_size_ bytes of address space, maps the first size_ bytes
+    // of fd_ at its start and the data region again right behind them.
+    // Returns MAP_FAILED with errno set.
+    void* map_mirror_(void* hint, int extra_flags, std::size_t header_bytes, std::size_t unit) const noexcept {
+        int reserve_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+        reserve_flags |= MAP_NORESERVE;
+#endif
+#if defined(MAP_FIXED_NOREPLACE)
+        if (hint) reserve_flags |= MAP_FIXED_NOREPLACE;
+#endif
+        // Over-reserve by one unit so huge-page views can be aligned.
+        const std::size_t slack = (!hint && unit > detail::seg::page_size_()) ? unit : 0;
+        void* r = ::mmap(hint, map_size_ + slack, PROT_NONE, reserve_flags, -1, 0);
+        if (r == MAP_FAILED) return MAP_FAILED;
+
+        auto* raw = static_cast<std::byte*>(r);
+        auto* base = raw + (detail::seg::round_up_(detail::addr(r), unit) - detail::addr(r));
+        if (base != raw) ::munmap(raw, static_cast<std::size_t>(base - raw));
+        if (const std::size_t tail = slack - static_cast<std::size_t>(base - raw)) ::munmap(base + map_size_, tail);
+
+        const int flags = MAP_SHARED | MAP_FIXED | extra_flags;
+        if (::mmap(base, size_, PROT_READ | PROT_WRITE, flags, fd_, 0) == MAP_FAILED ||
+            ::mmap(base + size_, size_ - header_bytes, PROT_READ | PROT_WRITE, flags, fd_,
+                   static_cast<off_t>(header_bytes)) == MAP_FAILED) {
             const int saved = errno;
-            fail_ctor(created_);
+            ::munmap(base, map_size_);
             errno = saved;
-            throw_errno("mmap");
+            return MAP_FAILED;
         }
+        return base;
+    }
 
-        base_ = map;
+    // Cross-process mutex over grow(): the header's grow_lock holds the
+    // owner's pid, and a lock whose owner no longer exists is taken over.
+    struct grow_guard_ {
+        std::atomic_ref<std::uint32_t> word;
+        std::uint32_t self;
+
+        explicit grow_guard_(segment_header& h) noexcept
+            : word(h.grow_lock), self(static_cast<std::uint32_t>(::getpid())) {
+            for (std::size_t attempt = 0;; ++attempt) {
+                std::uint32_t owner = 0;
+                if (word.compare_exchange_strong(owner, self, std::memory_order_acquire)) return;
+                if (owner != self && ::kill(static_cast<pid_t>(owner), 0) == -1 && errno == ESRCH &&
+                    word.compare_exchange_strong(owner, self, std::memory_order_acquire)) {
+                    return;
+                }
+                detail::seg::nanosleep_backoff_(attempt < 4 ? attempt : 4);
+            }
+        }
+        ~grow_guard_() { word.store(0, std::memory_order_release); }
 
-#if defined(MADV_DONTDUMP)
-        (void)::madvise(base_, map_size_, MADV_DONTDUMP);
-#endif
+        grow_guard_(const grow_guard_&) = delete;
+        grow_guard_& operator=(const grow_guard_&) = delete;
+    };
+
+    // Extends the mapping to `total` bytes of the object (already that
+    // large), in place when possible.
+    void remap_(std::size_t total) {
+        if (mirror_) throw_errno_("remap(mirror)", ENOTSUP);
+        const std::size_t new_map = detail::seg::round_up_(total, unit_);
+        std::unique_ptr<flusher_options> restart;
+        if (flusher_) {
+            restart = std::make_unique<flusher_options>(flusher_->opts);
+            (void)stop_flusher();
+        }
+        halt_tiering_();
+
+        void* const old_data = data();
+        if (new_map != map_size_) {
+            void* p = MAP_FAILED;
+            int err = 0;
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+            p = ::mremap(base_, map_size_, new_map, fixed_ ? 0 : MREMAP_MAYMOVE);
+            err = errno;
+#else
+            if (!fixed_) {
+                p = ::mmap(nullptr, new_map, PROT_READ | PROT_WRITE, private_ ? MAP_PRIVATE : MAP_SHARED, fd_, 0);
+                err = errno;
+                if (p != MAP_FAILED) {
+                    ::munmap(base_, map_size_);
 #if defined(MADV_HUGEPAGE)
-        (void)::madvise(base_, map_size_, MADV_HUGEPAGE);
+                    if (pages_ == page_policy::thp_advise) (void)::madvise(p, new_map, MADV_HUGEPAGE);
 #endif
-
-        if (created_) std::memset(base_, 0, size_);
+                }
+            } else {
+                err = ENOMEM;   // cannot extend in place without mremap
+            }
 #endif
-    }
+            if (p == MAP_FAILED) {
+                if (restart) start_flusher(*restart);
+                resume_tiering_();
+                throw_errno_("remap(grow)", err);
+            }
+            base_ = p;
+            map_size_ = new_map;
+        }
+        size_ = total;
+
+        if (dirty_) {
+            const std::size_t words = ((data_size() + dirty_chunk_ - 1) / dirty_chunk_ + 63) / 64;
+            if (words > dirty_words_) {
+                auto bigger = std::make_unique<std::atomic<std::uint64_t>[]>(words);
+                for (std::size_t w = 0; w < dirty_words_; ++w) {
+                    bigger[w].store(dirty_[w].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                dirty_ = std::move(bigger);
+                dirty_words_ = words;
+            }
+        }
 
-    ~segment() noexcept {
-#if SHM_PLATFORM_WIN32
-        if (base_ != nullptr) {
-            ::UnmapViewOfFile(base_);
-            base_ = nullptr;
+        for (auto fn : rebind_) fn(data());
+        if (table_id_ >= 0 && shm::segment_table::base(static_cast<segment_id>(table_id_)) == old_data) {
+            (void)shm::segment_table::set(static_cast<segment_id>(table_id_), data(), data_size());
         }
-        if (hMapFile_ != NULL) {
-            ::CloseHandle(hMapFile_);
-            hMapFile_ = NULL;
+        if (restart) start_flusher(*restart);
+        if (tiering_) {
+            extend_tiering_(*tiering_);
+            resume_tiering_();
         }
-        size_ = 0;
-        map_size_ = 0;
-        valid_ = false;
-        created_ = false;
-#else
+    }
+
+    void release_fd_() noexcept {
         if (base_) {
             ::munmap(base_, map_size_);
             base_ = nullptr;
@@ -1586,47 +5311,98 @@ public:
         }
         size_ = 0;
         map_size_ = 0;
-        created_ = false;
-#endif
     }
 
-    segment(const segment&) = delete;
-    segment& operator=(const segment&) = delete;
-    segment(segment&&) = delete;
-    segment& operator=(segment&&) = delete;
+    [[noreturn]] void throw_errno_(const char* op, int e = errno) const {
+        std::error_code ec(e, std::generic_category());
+        std::string msg;
+        msg.reserve(256);
+        msg.append("shm::segment: ");
+        msg.append(op);
+        msg.append(" failed (name=");
+        msg.append(name_.empty() ? "<anonymous>" : name_);
+        msg.append(", errno=");
+        msg.append(std::to_string(e));
+        msg.append(", ");
+        msg.append(ec.message());
+        msg.append(")");
+        throw std::system_error(ec, msg);
+    }
+#endif
 
-    void* base() const noexcept { return base_; }
-    std::size_t size() const noexcept { return size_; }
+    static void check_table_id_(const segment_options& opts) {
+        if (opts.table_id < -1 || opts.table_id > 0xFFFF ||
+            (opts.table_id >= 0 && !shm::segment_table::valid(static_cast<segment_id>(opts.table_id)))) {
+            throw std::invalid_argument("shm::segment: table_id is outside segment_table");
+        }
+    }
 
-    bool is_valid() const noexcept {
-#if SHM_PLATFORM_WIN32
-        return valid_ && base_ != nullptr && size_ != 0;
-#else
-        return fd_ != -1 && base_ != nullptr && size_ != 0;
-#endif
+    void track_rebind_(void (*fn)(void*) noexcept) const noexcept {
+        for (auto f : rebind_) {
+            if (f == fn) return;
+        }
+        try {
+            rebind_.push_back(fn);
+        } catch (...) {
+            // Out of memory: the base is set, it just won't follow a refresh().
+        }
     }
 
-    static bool remove(const char* name) noexcept {
+    // Creator: stamps the header and, unless deferred, publishes readiness.
+    // Opener: waits for readiness and validates. Returns an error message or
+    // nullptr.
+    const char* attach_header_(const segment_options& opts) noexcept {
+        auto* h = static_cast<segment_header*>(base_);
+        if (created_) {
+            h->magic = segment_header::kMagic;
+            h->header_version = segment_header::kVersion;
+            h->layout_version = opts.layout_version;
+            h->layout_hash = opts.layout_hash;
+            h->data_offset = header_bytes_;
+            h->data_size = size_ - header_bytes_;
+            h->grow_lock = 0;
+            h->generation = 0;
+            h->migration = segment_header::kMigrationIdle;
+            h->writers = 0;
+            generation_ = 0;
+            if (!opts.defer_ready) mark_ready();
+            return nullptr;
+        }
+        if (detail::seg::wait_nonzero_(&h->state, opts.ready_timeout_ms) != segment_header::kReady) {
+            return "shm::segment: timed out waiting for the segment to become ready";
+        }
+        if (h->magic != segment_header::kMagic || h->header_version != segment_header::kVersion) {
+            return "shm::segment: segment has no valid header";
+        }
+        const std::uint64_t gen = std::atomic_ref<std::uint64_t>(h->generation).load(std::memory_order_acquire);
+        const std::uint64_t published = std::atomic_ref<std::uint64_t>(h->data_size).load(std::memory_order_relaxed);
+        if (h->data_offset != header_bytes_) {
+            return "shm::segment: segment header describes an incompatible mapping";
+        }
+        generation_ = gen;
+        if (h->data_offset + published > size_) {
 #if SHM_PLATFORM_WIN32
-        (void)name;
-        return true;
+            return "shm::segment: segment header describes an incompatible mapping";
 #else
-        const std::string n = detail::seg::normalize_name_(name);
-        if (n.empty()) return false;
-        if (!detail::seg::name_is_portable_(n)) return false;
-
-        if (::shm_unlink(n.c_str()) == 0) return true;
-        if (errno == ENOENT) return true;
-        return false;
+            // A grow() landed between the fstat that sized this mapping and
+            // the loads above. grow() extends the object before it publishes
+            // data_size, so the object now covers the header; anything else
+            // is a bad header. Keep the smaller mapping under an older
+            // generation (wrapping from 0 is fine: only equality is tested)
+            // so that stale() reports it and refresh() maps the rest.
+            struct stat st{};
+            if (::fstat(fd_, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < h->data_offset + published) {
+                return "shm::segment: segment header describes an incompatible mapping";
+            }
+            generation_ = gen - 1;
 #endif
+        }
+        if (h->layout_version != opts.layout_version || h->layout_hash != opts.layout_hash) {
+            return "shm::segment: segment layout version or fingerprint mismatch";
+        }
+        return nullptr;
     }
 
-    template <class Tag>
-    void bind() const noexcept {
-        if (base_) shm::segment_base<Tag>::set(base_);
-    }
-
-private:
 #if SHM_PLATFORM_WIN32
     HANDLE hMapFile_ = NULL;
     void*  base_     = nullptr;
@@ -1643,5 +5419,271 @@ private:
     bool created_ = false;
     std::string name_;
 #endif
+    int table_id_ = -1;
+    std::size_t header_bytes_ = 0;
+    std::size_t huge_page_ = 0;
+    bool file_backed_ = false;
+    std::size_t dirty_chunk_ = 0;
+    std::size_t dirty_words_ = 0;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> dirty_;
+    std::atomic<std::int64_t> dirty_bytes_{0};
+    std::unique_ptr<flusher_state_> flusher_;
+    std::unique_ptr<tiering_state_> tiering_;
+    std::uint64_t generation_ = 0;
+    std::size_t unit_ = 0;
+    bool fixed_ = false;
+    bool mirror_ = false;
+    bool private_ = false;
+    page_policy pages_ = page_policy::thp_advise;
+    mutable std::vector<void (*)(void*) noexcept> rebind_;
+};
+
+// RAII form of segment::begin_write()/end_write(). Test it before writing:
+// false means the segment has moved.
+class write_section {
+public:
+    explicit write_section(segment& s) noexcept : seg_(&s), open_(s.begin_write()) {}
+    ~write_section() {
+        if (open_) seg_->end_write();
+    }
+
+    write_section(const write_section&) = delete;
+    write_section& operator=(const write_section&) = delete;
+
+    explicit operator bool() const noexcept { return open_; }
+    void note(std::size_t offset, std::size_t len) noexcept { seg_->note_write(offset, len); }
+
+private:
+    segment* seg_;
+    bool open_;
+};
+
+struct migrate_options {
+    unsigned threads = 0;                               // copy threads; 0: one per hardware thread
+    std::size_t copy_chunk = std::size_t{1} << 20;      // unit of the parallel first pass
+    // Re-copy dirty ranges without stopping writers up to this many times,
+    // or until fewer than quiesce_below dirty bytes remain.
+    unsigned precopy_rounds = 3;
+    std::size_t quiesce_below = std::size_t{1} << 20;
+    std::uint32_t quiesce_timeout_ms = 1000;
+};
+
+struct migrate_stats {
+    std::size_t copied_bytes = 0;     // first pass
+    std::size_t recopied_bytes = 0;   // dirty ranges, all rounds
+    unsigned rounds = 0;              // pre-copy rounds before quiescing
+    std::uint64_t pause_ns = 0;       // time new write sections were held off
 };
+
+// Moves a live segment to a new named segment created with dst_opts (for
+// example a larger size or a hugetlb page policy) while writers keep
+// running. The data is copied in parallel chunks while write sections log
+// dirty ranges into the source header; then new write sections are held
+// off, open ones drained, the remaining dirty ranges copied, and the new
+// name published: src.forwarded_to() returns it, src.stale() turns true and
+// blocked or later begin_write() calls return false. Offsets need no
+// rewriting. The source needs segment_options::header and must not grow
+// meanwhile; the destination gets a header with the same layout identity.
+// On failure (including a writer holding a section past
+// quiesce_timeout_ms) the source is left as it was and dst is removed.
+[[nodiscard]] inline std::unique_ptr<segment> migrate_segment(segment& src, const char* dst_name, std::size_t dst_size,
+                                                              const segment_options& dst_opts,
+                                                              const migrate_options& mo = {},
+                                                              migrate_stats* stats = nullptr) {
+    segment_header* h = src.header();
+    if (!h) throw std::invalid_argument("shm::migrate_segment: source needs segment_options::header");
+    if (!dst_name || std::strlen(dst_name) >= sizeof(h->forward_name)) {
+        throw std::invalid_argument("shm::migrate_segment: destination name too long");
+    }
+
+    std::atomic_ref<std::uint32_t> state(h->migration);
+    if (state.load(std::memory_order_acquire) != segment_header::kMigrationIdle) {
+        throw std::logic_error("shm::migrate_segment: segment is already migrating or moved");
+    }
+
+    const std::size_t bytes = src.data_size();
+    constexpr std::size_t kBits = segment_header::kDirtyWords * 64;
+    unsigned shift = 12;
+    while (((bytes + (std::size_t{1} << shift) - 1) >> shift) > kBits) ++shift;
+
+    segment_options o = dst_opts;
+    o.header = true;
+    o.defer_ready = true;
+    o.layout_version = h->layout_version;
+    o.layout_hash = h->layout_hash;
+    auto dst = std::make_unique<segment>(dst_name, (std::max)(dst_size, bytes), segment::open_mode::create_only, o);
+
+    std::atomic_ref<std::uint32_t>(h->dirty_shift).store(shift, std::memory_order_relaxed);
+    for (auto& w : h->dirty) std::atomic_ref<std::uint64_t>(w).store(0, std::memory_order_relaxed);
+    std::uint32_t idle = segment_header::kMigrationIdle;
+    if (!state.compare_exchange_strong(idle, segment_header::kCopying, std::memory_order_seq_cst)) {
+        dst.reset();
+        (void)segment::remove(dst_name, o);
+        throw std::logic_error("shm::migrate_segment: segment is already migrating or moved");
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    const auto* from = static_cast<const std::byte*>(src.data());
+    auto* to = static_cast<std::byte*>(dst->data());
+    migrate_stats st;
+
+    auto copy_units = [&](std::size_t unit, const std::size_t* index, std::size_t count) {
+        detail::seg::parallel_slices_(count, mo.threads, [&](std::size_t first, std::size_t last) noexcept {
+            for (std::size_t i = first; i < last; ++i) {
+                const std::size_t u = index ? index[i] : i;
+                const std::size_t off = u * unit;
+                if (off < bytes) std::memcpy(to + off, from + off, (std::min)(unit, bytes - off));
+            }
+        });
+    };
+
+    // Claims every logged chunk and copies it again.
+    std::vector<std::size_t> dirty;
+    auto recopy = [&] {
+        dirty.clear();
+        for (std::size_t w = 0; w < segment_header::kDirtyWords; ++w) {
+            std::atomic_ref<std::uint64_t> word(h->dirty[w]);
+            if (word.load(std::memory_order_relaxed) == 0) continue;
+            for (std::uint64_t bits = word.exchange(0, std::memory_order_acq_rel); bits; bits &= bits - 1) {
+                dirty.push_back(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+            }
+        }
+        copy_units(std::size_t{1} << shift, dirty.data(), dirty.size());
+        st.recopied_bytes += dirty.size() << shift;
+        return dirty.size() << shift;
+    };
+    auto logged_bytes = [&] {
+        std::size_t n = 0;
+        for (auto& w : h->dirty) n += std::popcount(std::atomic_ref<std::uint64_t>(w).load(std::memory_order_relaxed));
+        return n << shift;
+    };
+
+    try {
+        const std::size_t chunk = mo.copy_chunk ? mo.copy_chunk : (std::size_t{1} << 20);
+        copy_units(chunk, nullptr, (bytes + chunk - 1) / chunk);
+        st.copied_bytes = bytes;
+
+        while (st.rounds < mo.precopy_rounds && logged_bytes() > mo.quiesce_below) {
+            (void)recopy();
+            ++st.rounds;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        state.store(segment_header::kQuiescing, std::memory_order_seq_cst);
+        std::atomic_ref<std::uint32_t> writers(h->writers);
+        const auto deadline = t0 + std::chrono::milliseconds(mo.quiesce_timeout_ms);
+        for (std::size_t attempt = 0; writers.load(std::memory_order_seq_cst) != 0; ++attempt) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                throw std::runtime_error("shm::migrate_segment: timed out waiting for open write sections");
+            }
+            if (attempt < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        (void)recopy();
+        dst->mark_ready();
+
+        std::memcpy(h->forward_name, dst_name, std::strlen(dst_name) + 1);
+        std::atomic_ref<std::uint64_t>(h->generation).fetch_add(1, std::memory_order_release);
+        state.store(segment_header::kMoved, std::memory_order_release);
+        detail::seg::wake_all_(&h->migration);
+        st.pause_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+    } catch (...) {
+        state.store(segment_header::kMigrationIdle, std::memory_order_release);
+        detail::seg::wake_all_(&h->migration);
+        dst.reset();
+        (void)segment::remove(dst_name, o);
+        throw;
+    }
+
+    if (stats) *stats = st;
+    return dst;
+}
+
+#if !SHM_PLATFORM_WIN32
+namespace detail::seg {
+    union fd_cmsg_ {
+        cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    };
+}
+
+// Passes `fd` over a connected AF_UNIX socket as SCM_RIGHTS ancillary data,
+// with a single payload byte. The caller keeps its own descriptor.
+inline void send_fd(int sock, int fd) {
+    char byte = 0;
+    iovec iov{&byte, 1};
+    detail::seg::fd_cmsg_ ctrl{};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(c), &fd, sizeof(int));
+
+    int flags = 0;
+#if defined(MSG_NOSIGNAL)
+    flags |= MSG_NOSIGNAL;
+#endif
+    ssize_t n;
+    do {
+        n = ::sendmsg(sock, &msg, flags);
+    } while (n == -1 && errno == EINTR);
+    if (n != 1) {
+        throw std::system_error(n == -1 ? errno : EIO, std::generic_category(), "shm::send_fd: sendmsg failed");
+    }
+}
+
+// Receives a descriptor sent with send_fd(). The result is close-on-exec and
+// owned by the caller; hand it to segment(adopt_fd, fd).
+[[nodiscard]] inline int recv_fd(int sock) {
+    char byte = 0;
+    iovec iov{&byte, 1};
+    detail::seg::fd_cmsg_ ctrl{};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    int flags = 0;
+#if defined(MSG_CMSG_CLOEXEC)
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    ssize_t n;
+    do {
+        n = ::recvmsg(sock, &msg, flags);
+    } while (n == -1 && errno == EINTR);
+    if (n == -1) {
+        throw std::system_error(errno, std::generic_category(), "shm::recv_fd: recvmsg failed");
+    }
+    if (n == 0) {
+        throw std::system_error(std::make_error_code(std::errc::connection_reset), "shm::recv_fd: peer closed");
+    }
+
+    int fd = -1;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS && c->cmsg_len == CMSG_LEN(sizeof(int))) {
+            std::memcpy(&fd, CMSG_DATA(c), sizeof(int));
+            break;
+        }
+    }
+    if (fd == -1 || (msg.msg_flags & MSG_CTRUNC)) {
+        if (fd != -1) (void)::close(fd);
+        throw std::system_error(std::make_error_code(std::errc::bad_message), "shm::recv_fd: no descriptor received");
+    }
+#if !defined(MSG_CMSG_CLOEXEC)
+    (void)::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+    return fd;
+}
+#endif
 }
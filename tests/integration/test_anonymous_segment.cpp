@@ -0,0 +1,187 @@
+#include "shmTypes.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+#if !defined(_WIN32)
+
+struct Root {
+    std::uint64_t magic;
+    std::uint64_t counter;
+};
+
+static void test_anonymous_create() {
+    shm::segment s(shm::anonymous_segment, 1 << 20);
+    CHECK(s.is_valid());
+    CHECK(s.fd() >= 0);
+    CHECK(s.size() == (1u << 20));
+
+    struct stat st{};
+    CHECK(::fstat(s.fd(), &st) == 0);
+    CHECK(static_cast<std::size_t>(st.st_size) == s.size());
+
+    const auto* p = static_cast<const unsigned char*>(s.data());
+    for (std::size_t i = 0; i < s.size(); i += 4096) CHECK(p[i] == 0);
+}
+
+static void test_adopt_in_process() {
+    shm::segment creator(shm::anonymous_segment, 4096);
+    static_cast<Root*>(creator.data())->magic = 0xfeedu;
+
+    const int dup = ::dup(creator.fd());
+    CHECK(dup >= 0);
+    shm::segment view(shm::adopt_fd, dup);
+    CHECK(view.fd() == dup);
+    CHECK(view.size() == creator.size());
+    CHECK(view.data() != creator.data());
+    CHECK(static_cast<Root*>(view.data())->magic == 0xfeedu);
+
+    static_cast<Root*>(view.data())->counter = 7;
+    CHECK(static_cast<Root*>(creator.data())->counter == 7);
+}
+
+static void test_adopt_rejects_bad_fd() {
+    bool threw = false;
+    try {
+        shm::segment s(shm::adopt_fd, -1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // A descriptor with no bytes behind it is closed, not leaked.
+    int p[2];
+    CHECK(::pipe(p) == 0);
+    threw = false;
+    try {
+        shm::segment s(shm::adopt_fd, p[0]);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(::fcntl(p[0], F_GETFD) == -1);
+    ::close(p[1]);
+}
+
+// The intended use: the creator passes the fd to a child over a socketpair;
+// the child maps it, updates the root and exits.
+static void test_fd_passing_across_fork() {
+    shm::segment_options o;
+    o.header = true;
+    shm::segment creator(shm::anonymous_segment, 1 << 16, o);
+    auto* root = static_cast<Root*>(creator.data());
+    root->magic = 0xabcdu;
+
+    int sv[2];
+    CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+    const pid_t pid = ::fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        ::close(sv[0]);
+        int rc = 1;
+        try {
+            shm::segment child(shm::adopt_fd, shm::recv_fd(sv[1]), o);
+            auto* r = static_cast<Root*>(child.data());
+            if (child.data_size() == (1u << 16) && r->magic == 0xabcdu) {
+                r->counter = 42;
+                rc = 0;
+            }
+        } catch (...) {
+        }
+        ::_exit(rc);
+    }
+
+    ::close(sv[1]);
+    shm::send_fd(sv[0], creator.fd());
+    int status = 0;
+    CHECK(::waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(root->counter == 42);
+
+    // The peer is gone: recv_fd reports it instead of returning garbage.
+    bool threw = false;
+    try {
+        (void)shm::recv_fd(sv[0]);
+    } catch (const std::system_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    ::close(sv[0]);
+}
+
+// memfd_create(MFD_HUGETLB) draws on the kernel's internal hugetlbfs mount,
+// so only the 2 MiB pool has to have a free page.
+static bool hugetlb_2m_pool_available() {
+#if defined(__linux__)
+    std::ifstream in("/sys/kernel/mm/hugepages/hugepages-2048kB/free_hugepages");
+    std::size_t free_pages = 0;
+    return (in >> free_pages) && free_pages >= 1;
+#else
+    return false;
+#endif
+}
+
+static void test_anonymous_hugetlb() {
+    shm::segment_options o;
+    o.pages = shm::page_policy::hugetlb_2m;
+#if defined(__linux__)
+    if (!hugetlb_2m_pool_available()) {
+        std::cerr << "skip: no free 2 MiB huge pages\n";
+        return;
+    }
+    shm::segment s(shm::anonymous_segment, 100, o);
+    CHECK(s.huge_page_size() == (std::size_t{1} << 21));
+    CHECK(s.size() == (std::size_t{1} << 21));
+
+    shm::segment view(shm::adopt_fd, ::dup(s.fd()));
+    CHECK(view.huge_page_size() == s.huge_page_size());
+#else
+    // Without memfd_create there is no anonymous hugetlb object.
+    bool threw = false;
+    try {
+        shm::segment s(shm::anonymous_segment, 100, o);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+#endif
+}
+
+#endif
+
+} // namespace
+
+int main() {
+#if !defined(_WIN32)
+    test_anonymous_create();
+    test_adopt_in_process();
+    test_adopt_rejects_bad_fd();
+    test_fd_passing_across_fork();
+    test_anonymous_hugetlb();
+#endif
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+struct Node {
+    std::uint32_t value;
+    shm::fat_offset_ptr<Node> next;
+};
+
+static_assert(sizeof(shm::fat_offset_ptr<Node>) == 8);
+static_assert(std::is_trivially_copyable_v<shm::fat_offset_ptr<Node>>);
+
+// Three heap "segments" linked into one chain that hops between them, then
+// re-registered at different addresses to model another process.
+static void test_cross_segment_chain_relocates() {
+    constexpr std::size_t N = 1024;
+    std::vector<std::byte> a(N), b(N), c(N);
+    std::vector<std::byte> a2(N), b2(N), c2(N);
+
+    shm::segment_table::set(1, a.data(), N);
+    shm::segment_table::set(2, b.data(), N);
+    shm::segment_table::set(7, c.data(), N);
+
+    auto* n0 = new (a.data() + 64)  Node{10, nullptr};
+    auto* n1 = new (b.data() + 128) Node{11, nullptr};
+    auto* n2 = new (c.data() + 256) Node{12, nullptr};
+    auto* n3 = new (a.data() + 512) Node{13, nullptr};
+
+    n0->next = shm::fat_offset_ptr<Node>(2, n1);
+    n1->next = shm::fat_offset_ptr<Node>(n2);  // looked up in the table
+    n2->next = shm::fat_offset_ptr<Node>(1, n3);
+
+    CHECK(n0->next.id() == 2);
+    CHECK(n0->next.offset() == 128);
+    CHECK(n1->next.id() == 7);
+    CHECK(n2->next.get() == n3);
+    CHECK(n3->next == nullptr);
+
+    std::memcpy(a2.data(), a.data(), N);
+    std::memcpy(b2.data(), b.data(), N);
+    std::memcpy(c2.data(), c.data(), N);
+    shm::segment_table::set(1, a2.data(), N);
+    shm::segment_table::set(2, b2.data(), N);
+    shm::segment_table::set(7, c2.data(), N);
+
+    std::uint32_t sum = 0;
+    int hops = 0;
+    for (Node* cur = std::launder(reinterpret_cast<Node*>(a2.data() + 64)); cur; cur = cur->next.get()) {
+        sum += cur->value;
+        CHECK(++hops < 8);
+    }
+    CHECK(hops == 4);
+    CHECK(sum == 46);
+
+    shm::segment_table::clear(1);
+    shm::segment_table::clear(2);
+    shm::segment_table::clear(7);
+    CHECK(shm::segment_table::base(1) == nullptr);
+}
+
+static void test_segment_bind_id_registers_and_clears() {
+    std::string name = "/shm_fat_ptr_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    constexpr std::size_t kSize = 64 * 1024;
+    {
+        shm::segment seg(name.c_str(), kSize, shm::segment::open_mode::create_only);
+        seg.bind_id(42);
+        CHECK(shm::segment_table::base(42) == seg.base());
+        CHECK(shm::segment_table::size(42) == seg.size());
+
+        auto* n = new (static_cast<std::byte*>(seg.base()) + 4096) Node{5, nullptr};
+        shm::fat_offset_ptr<Node> p(n);
+        CHECK(p.id() == 42);
+        CHECK(p.offset() == 4096);
+        CHECK(p->value == 5);
+    }
+    CHECK(shm::segment_table::base(42) == nullptr);
+    (void)shm::segment::remove(name.c_str());
+}
+
+// Ids past the table are refused at run time, and a stored word naming one
+// (e.g. from an untrusted image) decodes to null instead of reading past it.
+static void test_out_of_range_id_is_rejected() {
+    static_assert(shm::segment_table::capacity < 300);
+    alignas(8) static std::byte buf[256];
+    CHECK(!shm::segment_table::set(300, buf, sizeof(buf)));
+    CHECK(shm::segment_table::base(300) == nullptr);
+    CHECK(shm::segment_table::size(300) == 0);
+
+    shm::fat_offset_ptr<Node> p;
+    const std::uint64_t bits = (std::uint64_t{300} << shm::fat_offset_ptr<Node>::id_shift) | 1;
+    std::memcpy(static_cast<void*>(&p), &bits, sizeof(bits));
+    CHECK(p.get() == nullptr);
+
+    std::string name = "/shm_fat_ptr_oor_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    {
+        shm::segment seg(name.c_str(), 4096, shm::segment::open_mode::create_only);
+        CHECK(seg.bind_id(300) == std::errc::invalid_argument);
+    }
+    (void)shm::segment::remove(name.c_str());
+}
+
+// A segment whose id was taken over by a later bind_id() leaves the new
+// registration in place when it goes away.
+static void test_displaced_owner_keeps_slot() {
+    std::string na = "/shm_fat_ptr_a_" + std::to_string(get_pid_u32());
+    std::string nb = "/shm_fat_ptr_b_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(na.c_str());
+    (void)shm::segment::remove(nb.c_str());
+    {
+        shm::segment b(nb.c_str(), 4096, shm::segment::open_mode::create_only);
+        {
+            shm::segment a(na.c_str(), 4096, shm::segment::open_mode::create_only);
+            CHECK(!a.bind_id(9));
+            CHECK(!b.bind_id(9));
+            CHECK(!a.bind_id(10));   // moving a must not clear b's slot either
+            CHECK(shm::segment_table::base(9) == b.base());
+        }
+        CHECK(shm::segment_table::base(9) == b.base());
+        CHECK(shm::segment_table::base(10) == nullptr);
+    }
+    CHECK(shm::segment_table::base(9) == nullptr);
+    (void)shm::segment::remove(na.c_str());
+    (void)shm::segment::remove(nb.c_str());
+}
+
+// segment_options::table_id registers the mapping as part of attaching, so
+// stored fat pointers decode with no separate bind_id() call.
+static void test_table_id_option_registers_on_attach() {
+    std::string name = "/shm_fat_ptr_opt_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::fat_offset_ptr<Node> stored;
+    {
+        shm::segment_options o;
+        o.table_id = 21;
+        shm::segment seg(name.c_str(), 8192, shm::segment::open_mode::create_only, o);
+        CHECK(shm::segment_table::base(21) == seg.data());
+        auto* n = new (static_cast<std::byte*>(seg.data()) + 64) Node{8, nullptr};
+        stored = shm::fat_offset_ptr<Node>(21, n);
+        CHECK(stored->value == 8);
+    }
+    // Nothing is registered under 21 any more: the stored word decodes to null.
+    CHECK(shm::segment_table::base(21) == nullptr);
+    CHECK(stored && stored.get() == nullptr);
+
+    {
+        shm::segment_options o;
+        o.table_id = 21;
+        shm::segment again(name.c_str(), 0, shm::segment::open_mode::open_only, o);
+        CHECK(stored.get() != nullptr && stored->value == 8);
+    }
+
+    shm::segment_options bad;
+    bad.table_id = 70000;
+    bool threw = false;
+    try {
+        shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only, bad);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    (void)shm::segment::remove(name.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_cross_segment_chain_relocates();
+    test_segment_bind_id_registers_and_clears();
+    test_out_of_range_id_is_rejected();
+    test_displaced_owner_keeps_slot();
+    test_table_id_option_registers_on_attach();
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include "shmTypes.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+#if !defined(_WIN32)
+
+struct FileTag {};
+
+struct Root {
+    std::uint64_t count;
+    shm::segment_offset_ptr<std::uint64_t, FileTag> last;
+};
+
+constexpr std::size_t kSize = std::size_t{1} << 20;
+
+static std::string temp_path(const char* tag) {
+    return "/tmp/shm_file_" + std::string(tag) + "_" + std::to_string(get_pid_u32());
+}
+
+static void test_persists_across_reopen() {
+    const std::string path = temp_path("persist");
+    std::remove(path.c_str());
+
+    shm::segment_options o;
+    o.header = true;
+    o.layout_hash = shm::layout_fingerprint<Root>();
+    {
+        shm::segment s(shm::file_backed, path.c_str(), kSize, shm::segment::open_mode::create_only, o);
+        CHECK(s.is_file_backed());
+        CHECK(s.data_size() == kSize);
+        s.bind<FileTag>();
+        auto* root = static_cast<Root*>(s.data());
+        auto* values = reinterpret_cast<std::uint64_t*>(root + 1);
+        for (std::uint64_t i = 0; i < 100; ++i) values[i] = i * i;
+        root->count = 100;
+        root->last = &values[99];
+        CHECK(!s.flush());
+    }
+
+    // The file is the data: its size and bytes are what the segment held.
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    CHECK(static_cast<std::size_t>(in.tellg()) > kSize);
+
+    {
+        shm::segment s(shm::file_backed, path.c_str(), 0, shm::segment::open_mode::open_only, o);
+        CHECK(!s.is_created());
+        s.bind<FileTag>();
+        auto* root = static_cast<Root*>(s.data());
+        CHECK(root->count == 100);
+        CHECK(*root->last == 99u * 99u);
+    }
+
+    bool threw = false;
+    try {
+        shm::segment s(shm::file_backed, path.c_str(), kSize, shm::segment::open_mode::create_only, o);
+    } catch (const std::system_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    std::remove(path.c_str());
+
+    threw = false;
+    try {
+        shm::segment s(shm::file_backed, path.c_str(), 0, shm::segment::open_mode::open_only);
+    } catch (const std::system_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+static void test_dirty_tracking() {
+    const std::string path = temp_path("dirty");
+    std::remove(path.c_str());
+
+    shm::segment_options o;
+    o.dirty_chunk = 64 * 1024;
+    shm::segment s(shm::file_backed, path.c_str(), kSize, shm::segment::open_mode::open_or_create, o);
+    CHECK(s.is_created());
+    CHECK(s.dirty_bytes() == 0);
+
+    auto* p = static_cast<unsigned char*>(s.data());
+    p[10] = 1;
+    s.mark_dirty(10, 1);
+    s.mark_dirty(20, 100);                 // same chunk: counted once
+    CHECK(s.dirty_bytes() == 64 * 1024);
+
+    std::memset(p + 100 * 1024, 2, 300 * 1024);
+    s.mark_dirty(100 * 1024, 300 * 1024);  // chunks 1..6
+    CHECK(s.dirty_bytes() == 7 * 64 * 1024);
+
+    s.mark_dirty(kSize - 1, 1000);         // clamped to the last chunk
+    s.mark_dirty(kSize + 10, 10);          // ignored
+    CHECK(s.dirty_bytes() == 8 * 64 * 1024);
+
+    CHECK(!s.flush_dirty(shm::flush_mode::async));
+    CHECK(s.dirty_bytes() == 0);
+    CHECK(!s.flush_dirty());
+
+    CHECK(!s.flush(0, 4096));
+    CHECK(!s.flush(kSize - 1, 1 << 30, shm::flush_mode::async));
+    CHECK(!s.flush(kSize + 1, 1));
+    std::remove(path.c_str());
+}
+
+static void test_background_flusher() {
+    const std::string path = temp_path("flusher");
+    std::remove(path.c_str());
+    shm::segment s(shm::file_backed, path.c_str(), kSize, shm::segment::open_mode::create_only);
+
+    shm::flusher_options fo;
+    fo.interval_ms = 0;                    // threshold only
+    fo.dirty_threshold = 128 * 1024;
+    fo.poll_ms = 1;
+    s.start_flusher(fo);
+
+    bool threw = false;
+    try {
+        s.start_flusher(fo);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    std::memset(s.data(), 3, 64 * 1024);
+    s.mark_dirty(0, 64 * 1024);            // below the threshold
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(s.dirty_bytes() == 64 * 1024);
+
+    s.mark_dirty(512 * 1024, 128 * 1024);  // crosses it
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (s.dirty_bytes() != 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(s.dirty_bytes() == 0);
+
+    s.mark_dirty(0, 1);
+    CHECK(!s.stop_flusher());              // final flush on stop
+    CHECK(s.dirty_bytes() == 0);
+    CHECK(!s.stop_flusher());
+    std::remove(path.c_str());
+}
+
+#endif
+
+static void test_flusher_needs_file() {
+    const std::string name = "/shm_file_plain_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment s(name.c_str(), 4096, shm::segment::open_mode::create_only);
+    CHECK(!s.is_file_backed());
+    CHECK(!s.flush());
+    s.mark_dirty(0, 10);
+    CHECK(s.dirty_bytes() == 0);
+
+    bool threw = false;
+    try {
+        s.start_flusher();
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    (void)shm::segment::remove(name.c_str());
+}
+
+} // namespace
+
+int main() {
+#if !defined(_WIN32)
+    test_persists_across_reopen();
+    test_dirty_tracking();
+    test_background_flusher();
+#endif
+    test_flusher_needs_file();
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+// Far from the usual heap, stack and library ranges on 64-bit targets.
+constexpr shm::detail::uptr kBase =
+    static_cast<shm::detail::uptr>(sizeof(void*) == 8 ? 0x5a0000000000ull : 0x50000000ull);
+
+struct Node {
+    std::uint32_t value;
+    shm::fixed_offset_ptr<Node, kBase> next;
+};
+
+static_assert(sizeof(shm::fixed_offset_ptr<Node, kBase>) == sizeof(std::uint32_t));
+static_assert(std::is_trivially_copyable_v<shm::fixed_offset_ptr<Node, kBase>>);
+static_assert(shm::fixed_anchor<kBase>::base(nullptr) == kBase);
+
+static void test_fixed_mapping_roundtrip() {
+    std::string name = "/shm_fixed_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    constexpr std::size_t kSize = 64 * 1024;
+    shm::segment_options opts;
+    opts.fixed_address = reinterpret_cast<void*>(kBase);
+
+    {
+        shm::segment seg(name.c_str(), kSize, shm::segment::open_mode::create_only, opts);
+        CHECK(seg.base() == opts.fixed_address);
+
+        auto* bytes = static_cast<std::byte*>(seg.base());
+        auto* a = new (bytes + 64)  Node{1, nullptr};
+        auto* b = new (bytes + 128) Node{2, nullptr};
+        auto* c = new (bytes + 4096) Node{3, nullptr};
+        a->next = b;
+        b->next = c;
+
+        CHECK(a->next.raw_storage() == 128 + 1);
+        CHECK(b->next.get() == c);
+        CHECK(c->next == nullptr);
+
+        // The range is taken; a second view must not silently land elsewhere
+        // or replace the first one.
+        bool threw = false;
+        try {
+            shm::segment again(name.c_str(), 0, shm::segment::open_mode::open_only, opts);
+        } catch (const std::system_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(a->next->value == 2);
+    }
+
+    // Reopen at the same address: the stored offsets decode without a base.
+    {
+        shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only, opts);
+        CHECK(seg.base() == opts.fixed_address);
+        std::uint32_t sum = 0;
+        for (Node* cur = std::launder(reinterpret_cast<Node*>(static_cast<std::byte*>(seg.base()) + 64));
+             cur; cur = cur->next.get()) {
+            sum += cur->value;
+        }
+        CHECK(sum == 6);
+    }
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_misaligned_fixed_address_rejected() {
+    std::string name = "/shm_fixed_bad_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment_options opts;
+    opts.fixed_address = reinterpret_cast<void*>(kBase + 16);
+
+    bool threw = false;
+    try {
+        shm::segment seg(name.c_str(), 4096, shm::segment::open_mode::create_only, opts);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    (void)shm::segment::remove(name.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_fixed_mapping_roundtrip();
+    test_misaligned_fixed_address_rejected();
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+#if !defined(_WIN32)
+
+constexpr std::size_t kRing = 64 * 1024;
+
+static shm::segment_options mirror_opts(bool header = false) {
+    shm::segment_options o;
+    o.mirror = true;
+    o.header = header;
+    return o;
+}
+
+// Writes through the mirror and reads back through the primary view, and
+// the other way round.
+static void check_aliasing(const shm::segment& s) {
+    CHECK(s.is_mirrored());
+    auto* p = static_cast<unsigned char*>(s.data());
+    const std::size_t n = s.data_size();
+    for (std::size_t i = 0; i < n; i += 4093) p[n + i] = static_cast<unsigned char>(i * 7u + 1u);
+    for (std::size_t i = 0; i < n; i += 4093) CHECK(p[i] == static_cast<unsigned char>(i * 7u + 1u));
+    p[n - 1] = 0x5a;
+    CHECK(p[2 * n - 1] == 0x5a);
+
+    // A run crossing the end is one contiguous span.
+    const char msg[] = "wrap-around message";
+    const std::size_t pos = 3 * n - 7;                     // any position, taken modulo n
+    auto v = s.ring_view(pos, sizeof(msg));
+    CHECK(v.data() == static_cast<std::byte*>(s.data()) + n - 7);
+    std::memcpy(v.data(), msg, sizeof(msg));
+    CHECK(std::memcmp(p + n - 7, msg, 7) == 0);
+    CHECK(std::memcmp(p, msg + 7, sizeof(msg) - 7) == 0);
+}
+
+static void test_named_mirror_across_fork() {
+    const std::string name = "/shm_mirror_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment s(name.c_str(), kRing, shm::segment::open_mode::create_only, mirror_opts());
+    CHECK(s.data_size() == kRing);
+    check_aliasing(s);
+
+    const pid_t pid = ::fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        int rc = 1;
+        try {
+            shm::segment c(name.c_str(), 0, shm::segment::open_mode::open_only, mirror_opts());
+            auto v = c.ring_view(kRing - 4, 8);
+            std::memcpy(v.data(), "ABCDEFGH", 8);
+            rc = 0;
+        } catch (...) {
+        }
+        ::_exit(rc);
+    }
+    int status = 0;
+    CHECK(::waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    const auto* p = static_cast<const char*>(s.data());
+    CHECK(std::memcmp(p + kRing - 4, "ABCD", 4) == 0);
+    CHECK(std::memcmp(p, "EFGH", 4) == 0);
+
+    // The primary view alone still works for a non-mirrored opener.
+    shm::segment plain(name.c_str(), 0, shm::segment::open_mode::open_only);
+    CHECK(!plain.is_mirrored());
+    CHECK(std::memcmp(static_cast<const char*>(plain.data()), "EFGH", 4) == 0);
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_mirror_with_header_and_zeroing() {
+    const std::string name = "/shm_mirror_hdr_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment_options o = mirror_opts(true);
+    o.zero = shm::zero_mode::memset;
+    o.prefault = shm::prefault_mode::touch;
+    shm::segment s(name.c_str(), kRing, shm::segment::open_mode::create_only, o);
+    CHECK(s.is_ready());
+    CHECK(s.data_size() == kRing);
+    const auto* p = static_cast<const unsigned char*>(s.data());
+    for (std::size_t i = 0; i < 2 * kRing; ++i) CHECK(p[i] == 0);
+    check_aliasing(s);
+    CHECK(s.header()->magic == shm::segment_header::kMagic);
+
+    bool threw = false;
+    try {
+        s.grow(2 * kRing);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(s.data_size() == kRing);
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_mirror_anonymous_and_adopted() {
+    shm::segment s(shm::anonymous_segment, kRing, mirror_opts());
+    check_aliasing(s);
+
+    shm::segment a(shm::adopt_fd, ::dup(s.fd()), mirror_opts());
+    CHECK(a.data_size() == kRing);
+    auto v = a.ring_view(kRing - 2, 4);
+    std::memcpy(v.data(), "wxyz", 4);
+    const auto* p = static_cast<const char*>(s.data());
+    CHECK(std::memcmp(p + kRing - 2, "wx", 2) == 0);
+    CHECK(std::memcmp(p, "yz", 2) == 0);
+}
+
+static void test_mirror_rejects_unaligned_size() {
+    const std::string name = "/shm_mirror_bad_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    bool threw = false;
+    try {
+        shm::segment s(name.c_str(), kRing + 100, shm::segment::open_mode::create_only, mirror_opts());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // The failed creator left nothing behind.
+    shm::segment s(name.c_str(), kRing, shm::segment::open_mode::create_only, mirror_opts());
+    CHECK(s.is_mirrored());
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_mirror_at_fixed_address() {
+    const std::string name = "/shm_mirror_fixed_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    void* probe = nullptr;
+    {
+        shm::segment tmp(shm::anonymous_segment, 4 * kRing);
+        probe = tmp.data();
+    }
+    shm::segment_options o = mirror_opts();
+    o.fixed_address = probe;
+    shm::segment s(name.c_str(), kRing, shm::segment::open_mode::create_only, o);
+    CHECK(s.base() == probe);
+    check_aliasing(s);
+    (void)shm::segment::remove(name.c_str());
+}
+
+#else
+
+static void test_mirror_not_supported() {
+    const std::string name = "/shm_mirror_" + std::to_string(get_pid_u32());
+    shm::segment_options o;
+    o.mirror = true;
+    bool threw = false;
+    try {
+        shm::segment s(name.c_str(), 64 * 1024, shm::segment::open_mode::create_only, o);
+    } catch (const std::system_error& e) {
+        threw = e.code() == std::errc::not_supported;
+    }
+    CHECK(threw);
+}
+
+#endif
+
+} // namespace
+
+int main() {
+#if !defined(_WIN32)
+    test_named_mirror_across_fork();
+    test_mirror_with_header_and_zeroing();
+    test_mirror_anonymous_and_adopted();
+    test_mirror_rejects_unaligned_size();
+    test_mirror_at_fixed_address();
+#else
+    test_mirror_not_supported();
+#endif
+    return 0;
+}
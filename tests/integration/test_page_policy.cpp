@@ -0,0 +1,151 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+#if defined(__linux__)
+  #include <sys/vfs.h>
+  #include <fstream>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+constexpr std::size_t k2M = std::size_t{1} << 21;
+
+static void test_thp_policies() {
+    const std::string name = "/shm_pages_" + std::to_string(get_pid_u32());
+    for (auto p : {shm::page_policy::thp_advise, shm::page_policy::system_default, shm::page_policy::thp_never}) {
+        (void)shm::segment::remove(name.c_str());
+        shm::segment_options o;
+        o.pages = p;
+        shm::segment s(name.c_str(), 4 * k2M, shm::segment::open_mode::create_only, o);
+        CHECK(s.size() == 4 * k2M);
+        CHECK(s.huge_page_size() == 0);
+        std::memset(s.data(), 0x5A, s.data_size());
+        // Coverage can never exceed the mapping, and MADV_NOHUGEPAGE must
+        // keep it at zero.
+        CHECK(s.huge_page_bytes() <= s.size());
+        if (p == shm::page_policy::thp_never) CHECK(s.huge_page_bytes() == 0);
+    }
+    (void)shm::segment::remove(name.c_str());
+}
+
+// Explicit huge pages depend on the host: a 2 MiB hugetlbfs mount at
+// /dev/hugepages and at least two free 2 MiB pages on Linux, the lock-pages
+// privilege on Windows. Only those host conditions skip the test; any other
+// failure is a real one.
+static bool hugetlb_2m_available() {
+#if defined(__linux__)
+    struct statfs fs{};
+    if (::statfs("/dev/hugepages", &fs) != 0) return false;
+    if (static_cast<unsigned long>(fs.f_type) != 0x958458f6UL || static_cast<std::size_t>(fs.f_bsize) != k2M) {
+        return false;   // not a hugetlbfs mount, or a different page size
+    }
+    std::ifstream in("/sys/kernel/mm/hugepages/hugepages-2048kB/free_hugepages");
+    std::size_t free_pages = 0;
+    return (in >> free_pages) && free_pages >= 2;
+#else
+    return true;
+#endif
+}
+
+static void test_hugetlb_2m() {
+    const std::string name = "/shm_pages_huge_" + std::to_string(get_pid_u32());
+    shm::segment_options o;
+    o.pages = shm::page_policy::hugetlb_2m;
+    (void)shm::segment::remove(name.c_str(), o);
+
+#if defined(_WIN32) || defined(__linux__)
+    if (!hugetlb_2m_available()) {
+        std::cerr << "skip: no 2 MiB hugetlbfs mount with free pages\n";
+        return;
+    }
+    try {
+        shm::segment s(name.c_str(), k2M + 1, shm::segment::open_mode::create_only, o);
+        CHECK(s.huge_page_size() == k2M);
+        CHECK(s.size() == 2 * k2M);           // rounded up to whole huge pages
+        CHECK(s.data_size() >= k2M + 1);
+        std::memset(s.data(), 1, s.data_size());
+        CHECK(s.huge_page_bytes() == s.size());
+
+        shm::segment opener(name.c_str(), 0, shm::segment::open_mode::open_only, o);
+        CHECK(opener.size() == s.size());
+        CHECK(static_cast<unsigned char*>(opener.data())[k2M] == 1);
+#if defined(_WIN32)
+    } catch (const std::system_error& e) {
+        if (e.code().value() != ERROR_PRIVILEGE_NOT_HELD) throw;
+        std::cerr << "skip: SeLockMemoryPrivilege not held\n";
+#endif
+    } catch (...) {
+        (void)shm::segment::remove(name.c_str(), o);
+        throw;
+    }
+#else
+    // Platform without large pages: refused up front, never base pages.
+    bool threw = false;
+    try {
+        shm::segment s(name.c_str(), k2M + 1, shm::segment::open_mode::create_only, o);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+#endif
+    CHECK(shm::segment::remove(name.c_str(), o));
+}
+
+static void test_bad_hugetlbfs_dir() {
+#if defined(__linux__)
+    const std::string name = "/shm_pages_dir_" + std::to_string(get_pid_u32());
+    shm::segment_options o;
+    o.pages = shm::page_policy::hugetlb_2m;
+    o.hugetlbfs_dir = "/tmp";   // not hugetlbfs
+    bool threw = false;
+    try {
+        shm::segment s(name.c_str(), k2M, shm::segment::open_mode::create_only, o);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    // The failed creator must not leave its file behind.
+    CHECK(::access(("/tmp" + name).c_str(), F_OK) != 0);
+#endif
+}
+
+} // namespace
+
+int main() {
+    test_thp_policies();
+    test_hugetlb_2m();
+    test_bad_hugetlbfs_dir();
+    return 0;
+}
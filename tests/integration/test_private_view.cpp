@@ -0,0 +1,223 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+struct ViewTag {};
+
+struct Order {
+    std::uint64_t qty;
+    shm::segment_offset_ptr<Order, ViewTag> next;
+};
+
+struct Book {
+    std::uint64_t count;
+    shm::segment_offset_ptr<Order, ViewTag> head;
+};
+
+constexpr std::size_t kSize = 1 << 20;
+constexpr std::uint64_t kOrders = 2000;   // spans several pages
+
+static shm::segment_options book_opts() {
+    shm::segment_options o;
+    o.header = true;
+    o.layout_hash = shm::layout_fingerprint<Book, Order>();
+    return o;
+}
+
+static Order* orders(const shm::segment& s) {
+    return reinterpret_cast<Order*>(static_cast<Book*>(s.data()) + 1);
+}
+
+static void build_book(shm::segment& s) {
+    s.bind<ViewTag>();
+    auto* book = static_cast<Book*>(s.data());
+    Order* o = orders(s);
+    for (std::uint64_t i = 0; i < kOrders; ++i) {
+        o[i].qty = i;
+        o[i].next = (i + 1 < kOrders) ? &o[i + 1] : nullptr;
+    }
+    book->head = &o[0];
+    book->count = kOrders;
+}
+
+static std::uint64_t total_qty(shm::segment& s) {
+    s.bind<ViewTag>();
+    std::uint64_t sum = 0;
+    for (const Order* o = static_cast<const Book*>(s.data())->head.get(); o; o = o->next.get()) sum += o->qty;
+    return sum;
+}
+
+constexpr std::uint64_t kLive = (kOrders - 1) * kOrders / 2;
+
+static void test_what_if_updates_stay_private() {
+    const std::string name = "/shm_view_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment live(name.c_str(), kSize, shm::segment::open_mode::create_only, book_opts());
+    build_book(live);
+
+    auto view = live.open_private_view();
+    CHECK(view->is_private());
+    CHECK(!live.is_private());
+    CHECK(view->data() != live.data());
+    CHECK(view->data_size() == live.data_size());
+    CHECK(view->is_ready());
+    CHECK(total_qty(*view) == kLive);
+
+    // Hypothetical update through the view's own pointers.
+    view->bind<ViewTag>();
+    for (Order* o = static_cast<Book*>(view->data())->head.get(); o; o = o->next.get()) o->qty += 1;
+    CHECK(total_qty(*view) == kLive + kOrders);
+    CHECK(total_qty(live) == kLive);
+
+    // Another opener of the object sees only the live book.
+    shm::segment other(name.c_str(), 0, shm::segment::open_mode::open_only, book_opts());
+    CHECK(total_qty(other) == kLive);
+
+    // Discarding returns the view to the live book; live updates then reach
+    // it through the pages it has not copied.
+    CHECK(!view->discard());
+    CHECK(total_qty(*view) == kLive);
+    orders(live)[kOrders - 1].qty += 1000;
+    CHECK(total_qty(*view) == kLive + 1000);
+    (void)shm::segment::remove(name.c_str());
+}
+
+#if !defined(_WIN32)
+
+static void test_partial_discard_is_page_granular() {
+    shm::segment live(shm::anonymous_segment, kSize);
+    auto* p = static_cast<unsigned char*>(live.data());
+    std::memset(p, 1, kSize);
+
+    auto view = live.open_private_view();
+    auto* v = static_cast<unsigned char*>(view->data());
+    std::memset(v, 2, kSize);
+    const std::size_t ps = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    // Only pages fully inside the range go back to the live contents.
+    CHECK(!view->discard(ps / 2, 2 * ps));
+    CHECK(v[ps / 2] == 2 && v[ps - 1] == 2);
+    CHECK(v[ps] == 1 && v[2 * ps - 1] == 1);
+    CHECK(v[2 * ps] == 2);
+
+    // Discard on the shared segment is a no-op.
+    CHECK(!live.discard());
+    CHECK(p[0] == 1);
+}
+
+#if !defined(__APPLE__)   // Darwin cannot grow a shm segment
+
+static void test_view_follows_grow_and_cannot_grow() {
+    const std::string name = "/shm_view_grow_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment live(name.c_str(), kSize, shm::segment::open_mode::create_only, book_opts());
+    build_book(live);
+    auto view = live.open_private_view();
+
+    bool threw = false;
+    try {
+        view->grow(2 * kSize);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    live.grow(4 * kSize);
+    auto* fresh = static_cast<unsigned char*>(live.data()) + 3 * kSize;
+    fresh[0] = 0x77;
+    CHECK(view->stale());
+    CHECK(view->refresh());
+    CHECK(view->is_private());
+    CHECK(view->data_size() == live.data_size());
+    CHECK(static_cast<unsigned char*>(view->data())[3 * kSize] == 0x77);
+
+    static_cast<unsigned char*>(view->data())[3 * kSize] = 0x11;
+    CHECK(fresh[0] == 0x77);
+    CHECK(total_qty(*view) == kLive);
+    (void)shm::segment::remove(name.c_str());
+}
+
+#endif
+
+static void test_file_backed_view_never_writes_back() {
+    const std::string path = "/tmp/shm_view_" + std::to_string(get_pid_u32());
+    std::remove(path.c_str());
+    {
+        shm::segment live(shm::file_backed, path.c_str(), 4096, shm::segment::open_mode::create_only);
+        std::memset(live.data(), 'a', 4096);
+        CHECK(!live.flush());
+
+        auto view = live.open_private_view();
+        CHECK(!view->is_file_backed());
+        std::memset(view->data(), 'b', 4096);
+        CHECK(!view->flush());
+    }
+    std::ifstream in(path, std::ios::binary);
+    char c = 0;
+    in.get(c);
+    CHECK(c == 'a');
+    std::remove(path.c_str());
+}
+
+static void test_view_of_mirrored_segment() {
+    shm::segment_options o;
+    o.mirror = true;
+    shm::segment live(shm::anonymous_segment, 64 * 1024, o);
+    static_cast<unsigned char*>(live.data())[0] = 9;
+    auto view = live.open_private_view();
+    CHECK(!view->is_mirrored());
+    CHECK(view->data_size() == live.data_size());
+    CHECK(static_cast<unsigned char*>(view->data())[0] == 9);
+}
+
+#endif
+
+} // namespace
+
+int main() {
+    test_what_if_updates_stay_private();
+#if !defined(_WIN32)
+    test_partial_discard_is_page_granular();
+#if !defined(__APPLE__)
+    test_view_follows_grow_and_cannot_grow();
+#endif
+    test_file_backed_view_never_writes_back();
+    test_view_of_mirrored_segment();
+#endif
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+#if !defined(_WIN32)
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+struct AdviseTag {};
+
+#if !defined(_WIN32)
+
+constexpr std::size_t kSize = 256 * 1024;
+
+static shm::segment_options small_pages() {
+    shm::segment_options o;
+    o.pages = shm::page_policy::thp_never;
+    return o;
+}
+
+static bool ok_or_unsupported(std::error_code ec) {
+    return !ec || ec == std::errc::not_supported || ec == std::errc::invalid_argument;
+}
+
+static void test_hints_succeed() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    std::memset(s.data(), 1, kSize);
+    CHECK(!s.advise(shm::advice::willneed));
+    CHECK(!s.advise(shm::advice::sequential));
+    CHECK(!s.advise(shm::advice::random));
+    CHECK(!s.advise(shm::advice::normal));
+    CHECK(!s.advise(10, 100, shm::advice::willneed));          // unaligned range
+    CHECK(!s.advise(kSize + 1, 100, shm::advice::willneed));   // past the end: nothing to do
+    CHECK(ok_or_unsupported(s.advise(shm::advice::cold)));
+    CHECK(ok_or_unsupported(s.advise(shm::advice::pageout)));
+    CHECK(ok_or_unsupported(s.advise(shm::advice::mergeable)));
+    CHECK(static_cast<unsigned char*>(s.data())[kSize - 1] == 1);
+}
+
+// On a shared mapping dontneed only drops this process's page mappings; the
+// next access refaults the data from the object.
+static void test_dontneed_on_shared_keeps_data() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    auto* p = static_cast<unsigned char*>(s.data());
+    for (std::size_t i = 0; i < kSize; ++i) p[i] = static_cast<unsigned char>(i * 13u);
+
+    shm::residency_report r;
+    CHECK(!s.residency(r));
+    CHECK(r.fully_resident());
+    CHECK(!s.advise(shm::advice::dontneed));
+    for (std::size_t i = 0; i < kSize; ++i) CHECK(p[i] == static_cast<unsigned char>(i * 13u));
+}
+
+static void test_populate() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    shm::residency_report r;
+    CHECK(!s.residency(r));
+    CHECK(r.resident == 0);
+
+    const std::error_code ec = s.advise(0, kSize / 2, shm::advice::populate_write);
+#if defined(MADV_POPULATE_WRITE)
+    CHECK(ok_or_unsupported(ec));
+    if (!ec) {
+        CHECK(!s.residency(0, kSize / 2, r));
+        CHECK(r.fully_resident());
+        CHECK(!s.residency(kSize / 2, kSize / 2, r));
+        CHECK(r.resident == 0);
+    }
+#else
+    CHECK(ec == std::errc::not_supported);
+#endif
+}
+
+// dontneed shrinks to whole pages inside the range: on a private mapping,
+// where Linux discards the data, only the fully covered page is zeroed.
+// Other systems may keep every page, so only the kept pages are checked
+// there.
+static void test_dontneed_rounds_inward() {
+    const std::size_t ps = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    void* m = ::mmap(nullptr, 4 * ps, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(m != MAP_FAILED);
+    auto* p = static_cast<unsigned char*>(m);
+    std::memset(p, 0xAB, 4 * ps);
+
+    CHECK(!shm::advise(p + 100, 2 * ps, shm::advice::dontneed));
+    CHECK(p[99] == 0xAB && p[ps - 1] == 0xAB);                 // page 0 kept
+#if defined(__linux__)
+    CHECK(p[ps] == 0 && p[2 * ps - 1] == 0);                   // page 1 dropped
+#endif
+    CHECK(p[2 * ps] == 0xAB && p[2 * ps + 99] == 0xAB);        // page 2 kept
+
+    // A range inside one page covers no whole page.
+    std::memset(p, 0xCD, 4 * ps);
+    CHECK(!shm::advise(p + 1, ps - 2, shm::advice::dontneed));
+    CHECK(p[1] == 0xCD && p[ps - 2] == 0xCD);
+
+    // Other advice widens outward and therefore accepts the same range.
+    CHECK(!shm::advise(p + 1, ps - 2, shm::advice::willneed));
+    ::munmap(m, 4 * ps);
+}
+
+static void test_allocator_advise() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    shm::linear_allocator<AdviseTag> a(s.data(), kSize);
+
+    auto* log = a.allocate<std::uint64_t>(4096);
+    CHECK(log != nullptr);
+    for (std::uint64_t i = 0; i < 4096; ++i) log[i] = i;
+
+    CHECK(!a.advise(shm::advice::willneed));
+    CHECK(!a.advise(shm::advice::sequential));
+    CHECK(ok_or_unsupported(a.advise(shm::advice::pageout)));
+    CHECK(!a.advise(kSize, 10, shm::advice::willneed));        // beyond the arena
+    for (std::uint64_t i = 0; i < 4096; ++i) CHECK(log[i] == i);
+}
+
+#else
+
+static void test_windows_advice() {
+    alignas(64) static unsigned char buf[4096];
+    CHECK(!shm::advise(buf, sizeof(buf), shm::advice::normal));
+    CHECK(shm::advise(buf, sizeof(buf), shm::advice::willneed) == std::errc::not_supported);
+}
+
+#endif
+
+} // namespace
+
+int main() {
+#if !defined(_WIN32)
+    test_hints_succeed();
+    test_dontneed_on_shared_keeps_data();
+    test_populate();
+    test_dontneed_rounds_inward();
+    test_allocator_advise();
+#else
+    test_windows_advice();
+#endif
+    return 0;
+}
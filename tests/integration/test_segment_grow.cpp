@@ -0,0 +1,292 @@
+#include "shmTypes.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+struct GrowTag {};
+
+struct Node {
+    std::uint64_t value;
+    shm::segment_offset_ptr<Node, GrowTag> next;
+};
+
+struct Root {
+    std::uint64_t count;
+    shm::segment_offset_ptr<Node, GrowTag> head;
+};
+
+constexpr std::size_t kInitial = 64 * 1024;
+
+static shm::segment_options grow_opts() {
+    shm::segment_options o;
+    o.header = true;
+    o.layout_hash = shm::layout_fingerprint<Root, Node>();
+    return o;
+}
+
+static std::uint64_t walk_sum(const Root* root) {
+    std::uint64_t sum = 0;
+    for (const Node* n = root->head.get(); n; n = n->next.get()) sum += n->value;
+    return sum;
+}
+
+static void test_grow_requires_header() {
+    const std::string name = "/shm_grow_nohdr_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment s(name.c_str(), 4096, shm::segment::open_mode::create_only);
+    bool threw = false;
+    try {
+        s.grow(8192);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(!s.stale());
+    CHECK(!s.refresh());
+    (void)shm::segment::remove(name.c_str());
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+// Builds a list, lets a child attach, grows the segment past the child's
+// mapping, appends nodes in the new space, and checks that the child sees
+// the list after refresh() with only the Tag rebind.
+static void test_grow_and_lazy_remap_across_fork() {
+    const std::string name = "/shm_grow_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment s(name.c_str(), kInitial, shm::segment::open_mode::create_only, grow_opts());
+    s.bind<GrowTag>();
+    CHECK(s.generation() == 0);
+
+    auto* root = static_cast<Root*>(s.data());
+    auto* nodes = reinterpret_cast<Node*>(root + 1);
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        nodes[i].value = i;
+        nodes[i].next = (i + 1 < 100) ? &nodes[i + 1] : nullptr;
+    }
+    root->head = &nodes[0];
+    root->count = 100;
+
+    int to_child[2];
+    int to_parent[2];
+    CHECK(::pipe(to_child) == 0 && ::pipe(to_parent) == 0);
+
+    const pid_t pid = ::fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        int rc = 1;
+        try {
+            shm::segment c(name.c_str(), 0, shm::segment::open_mode::open_only, grow_opts());
+            c.bind<GrowTag>();
+            const std::size_t before = c.data_size();
+            char b = 'r';
+            (void)!::write(to_parent[1], &b, 1);
+            (void)!::read(to_child[0], &b, 1);            // parent has grown
+
+            bool ok = before == kInitial && c.stale() && c.refresh() && !c.stale();
+            ok = ok && c.data_size() >= 16 * kInitial && c.generation() == 1;
+            const auto* r = static_cast<const Root*>(c.data());
+            ok = ok && r->count == 200 && walk_sum(r) == 199u * 200u / 2u;
+            rc = ok ? 0 : 2;
+        } catch (...) {
+        }
+        ::_exit(rc);
+    }
+
+    char b = 0;
+    CHECK(::read(to_parent[0], &b, 1) == 1);
+
+    s.grow(16 * kInitial);
+    CHECK(s.generation() == 1);
+    CHECK(!s.stale());
+    CHECK(s.data_size() >= 16 * kInitial);
+
+    // The bound base followed the (possibly moved) mapping.
+    root = static_cast<Root*>(s.data());
+    CHECK(walk_sum(root) == 99u * 100u / 2u);
+
+    // Append nodes in the newly added space, linked from the old tail.
+    auto* fresh = reinterpret_cast<Node*>(static_cast<std::byte*>(s.data()) + 8 * kInitial);
+    Node* tail = root->head.get();
+    while (tail->next) tail = tail->next.get();
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        fresh[i].value = 100 + i;
+        fresh[i].next = (i + 1 < 100) ? &fresh[i + 1] : nullptr;
+    }
+    tail->next = &fresh[0];
+    root->count = 200;
+
+    CHECK(::write(to_child[1], &b, 1) == 1);
+    int status = 0;
+    CHECK(::waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // Growing to a smaller size is a no-op.
+    s.grow(kInitial);
+    CHECK(s.generation() == 1);
+
+    ::close(to_child[0]); ::close(to_child[1]);
+    ::close(to_parent[0]); ::close(to_parent[1]);
+    (void)shm::segment::remove(name.c_str());
+}
+
+// Concurrent growers are serialized by the header lock, so the object only
+// ever gets larger and every generation is published once.
+static void test_concurrent_growers() {
+    const std::string name = "/shm_grow_race_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment a(name.c_str(), kInitial, shm::segment::open_mode::create_only, grow_opts());
+    shm::segment b(name.c_str(), 0, shm::segment::open_mode::open_only, grow_opts());
+
+    std::thread ta([&] { for (std::size_t i = 1; i <= 20; ++i) a.grow(kInitial + i * 8192); });
+    std::thread tb([&] { for (std::size_t i = 1; i <= 20; ++i) b.grow(kInitial + i * 4096); });
+    ta.join();
+    tb.join();
+
+    (void)a.refresh();
+    (void)b.refresh();
+    CHECK(a.data_size() == kInitial + 20 * 8192);
+    CHECK(b.data_size() == a.data_size());
+    CHECK(a.generation() == b.generation());
+    CHECK(a.header()->grow_lock == 0);
+    (void)shm::segment::remove(name.c_str());
+}
+
+// Openers racing a grower size their mapping before the new data_size may
+// be published. They must attach anyway, as stale, and catch up on refresh().
+static void test_open_races_grow() {
+    const std::string name = "/shm_grow_open_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment g(name.c_str(), kInitial, shm::segment::open_mode::create_only, grow_opts());
+
+    std::atomic<bool> done{false};
+    std::thread grower([&] {
+        for (std::size_t i = 1; i <= 200; ++i) g.grow(kInitial + i * 4096);
+        done.store(true);
+    });
+    std::size_t opens = 0;
+    while (!done.load() || opens == 0) {
+        shm::segment o(name.c_str(), 0, shm::segment::open_mode::open_only, grow_opts());
+        (void)o.refresh();
+        ++opens;
+    }
+    grower.join();
+
+    shm::segment last(name.c_str(), 0, shm::segment::open_mode::open_only, grow_opts());
+    (void)last.refresh();
+    CHECK(last.data_size() == kInitial + 200 * 4096);
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_grow_anonymous() {
+    shm::segment m(shm::anonymous_segment, kInitial, grow_opts());
+    shm::segment view(shm::adopt_fd, ::dup(m.fd()), grow_opts());
+    m.grow(2 * kInitial);
+    CHECK(view.stale());
+    CHECK(view.refresh());
+    CHECK(view.data_size() == 2 * kInitial);
+}
+
+#endif
+
+#if defined(__APPLE__)
+
+static void test_grow_shm_not_supported() {
+    const std::string name = "/shm_grow_mac_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment s(name.c_str(), kInitial, shm::segment::open_mode::create_only, grow_opts());
+    bool threw = false;
+    try {
+        s.grow(2 * kInitial);
+    } catch (const std::system_error& e) {
+        threw = e.code() == std::errc::not_supported;
+    }
+    CHECK(threw);
+    CHECK(s.generation() == 0 && s.data_size() == kInitial);
+    (void)shm::segment::remove(name.c_str());
+}
+
+#endif
+
+#if !defined(_WIN32)
+
+static void test_grow_file_backed() {
+    const std::string path = "/tmp/shm_grow_file_" + std::to_string(get_pid_u32());
+    std::remove(path.c_str());
+    {
+        shm::segment f(shm::file_backed, path.c_str(), kInitial, shm::segment::open_mode::create_only, grow_opts());
+        f.start_flusher();
+        f.grow(4 * kInitial);
+        CHECK(f.data_size() == 4 * kInitial);
+        std::memset(static_cast<std::byte*>(f.data()) + 3 * kInitial, 7, kInitial);
+        f.mark_dirty(3 * kInitial, kInitial);     // tracking covers the new range
+        CHECK(f.dirty_bytes() == kInitial);
+        CHECK(!f.stop_flusher());
+        CHECK(f.dirty_bytes() == 0);
+    }
+    {
+        shm::segment f(shm::file_backed, path.c_str(), 0, shm::segment::open_mode::open_only, grow_opts());
+        CHECK(f.data_size() == 4 * kInitial);
+        CHECK(f.generation() == 1);
+        CHECK(static_cast<unsigned char*>(f.data())[4 * kInitial - 1] == 7);
+    }
+    std::remove(path.c_str());
+}
+
+#endif
+
+} // namespace
+
+int main() {
+    test_grow_requires_header();
+#if !defined(_WIN32) && !defined(__APPLE__)
+    test_grow_and_lazy_remap_across_fork();
+    test_concurrent_growers();
+    test_open_races_grow();
+    test_grow_anonymous();
+#endif
+#if defined(__APPLE__)
+    test_grow_shm_not_supported();
+#endif
+#if !defined(_WIN32)
+    test_grow_file_backed();
+#endif
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "shmTypes.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+struct Root {
+    std::uint64_t items;
+    std::uint64_t checksum;
+};
+
+struct RootV2 {
+    std::uint64_t items;
+    std::uint64_t checksum;
+    std::uint32_t flags;
+};
+
+constexpr std::uint64_t kLayout = shm::layout_fingerprint<Root>();
+
+static_assert(shm::layout_fingerprint<Root>() != shm::layout_fingerprint<RootV2>());
+static_assert(shm::layout_fingerprint<Root, RootV2>() != shm::layout_fingerprint<RootV2, Root>());
+static_assert(shm::layout_fingerprint<Root>(1) != shm::layout_fingerprint<Root>(2));
+
+static shm::segment_options header_opts(std::uint64_t hash = kLayout) {
+    shm::segment_options o;
+    o.header = true;
+    o.layout_version = 3;
+    o.layout_hash = hash;
+    o.ready_timeout_ms = 5000;
+    return o;
+}
+
+static void test_opener_waits_for_deferred_ready() {
+    std::string name = "/shm_hdr_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    constexpr std::size_t kSize = 64 * 1024;
+    auto copts = header_opts();
+    copts.defer_ready = true;
+    shm::segment creator(name.c_str(), kSize, shm::segment::open_mode::create_only, copts);
+
+    CHECK(creator.header() != nullptr);
+    CHECK(creator.header()->magic == shm::segment_header::kMagic);
+    CHECK(creator.data_size() == kSize);
+    CHECK(creator.data() != creator.base());
+    CHECK(!creator.is_ready());
+
+    std::atomic<bool> published{false};
+    std::atomic<bool> saw_unpublished{false};
+    std::uint64_t seen_items = 0;
+
+    std::thread opener([&] {
+        shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only, header_opts());
+        if (!published.load(std::memory_order_acquire)) saw_unpublished = true;
+        CHECK(seg.is_ready());
+        CHECK(seg.data_size() == kSize);
+        seen_items = static_cast<Root*>(seg.data())->items;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto* root = static_cast<Root*>(creator.data());
+    root->items = 1234;
+    root->checksum = 99;
+    published.store(true, std::memory_order_release);
+    creator.mark_ready();
+    opener.join();
+
+    CHECK(!saw_unpublished);
+    CHECK(seen_items == 1234);
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_layout_mismatch_rejected() {
+    std::string name = "/shm_hdr_mis_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment creator(name.c_str(), 4096, shm::segment::open_mode::create_only, header_opts());
+    CHECK(creator.is_ready());
+
+    bool threw = false;
+    try {
+        shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only,
+                         header_opts(shm::layout_fingerprint<RootV2>()));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    auto wrong_version = header_opts();
+    wrong_version.layout_version = 4;
+    threw = false;
+    try {
+        shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only, wrong_version);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // A matching opener attaches immediately.
+    shm::segment ok(name.c_str(), 4096, shm::segment::open_mode::open_or_create, header_opts());
+    CHECK(ok.is_ready());
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_timeout_without_ready() {
+    std::string name = "/shm_hdr_to_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    // A segment without a header never becomes ready.
+    shm::segment plain(name.c_str(), 8192, shm::segment::open_mode::create_only);
+    auto opts = header_opts();
+    opts.ready_timeout_ms = 50;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    bool threw = false;
+    try {
+        shm::segment seg(name.c_str(), 0, shm::segment::open_mode::open_only, opts);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    const auto waited = std::chrono::steady_clock::now() - t0;
+    CHECK(threw);
+    CHECK(waited >= std::chrono::milliseconds(40));
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_bind_uses_data_region() {
+    struct HdrTag {};
+    std::string name = "/shm_hdr_bind_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment seg(name.c_str(), 4096, shm::segment::open_mode::create_only, header_opts());
+    seg.bind<HdrTag>();
+    CHECK(shm::segment_base<HdrTag>::get() == seg.data());
+    (void)shm::segment::remove(name.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_opener_waits_for_deferred_ready();
+    test_layout_mismatch_rejected();
+    test_timeout_without_ready();
+    test_bind_uses_data_region();
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+// Small enough for the historical 64 KiB RLIMIT_MEMLOCK default.
+constexpr std::size_t kSize = 32 * 1024;
+
+static shm::segment_options small_pages() {
+    shm::segment_options o;
+    o.pages = shm::page_policy::thp_never;   // keep residency page-granular
+    return o;
+}
+
+static void test_lock_option_and_whole_segment_calls() {
+    const std::string name = "/shm_lock_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment_options o = small_pages();
+    o.header = true;
+    o.lock = shm::lock_mode::now;
+    shm::segment s(name.c_str(), kSize, shm::segment::open_mode::create_only, o);
+    CHECK(s.is_ready());
+
+    static_cast<unsigned char*>(s.data())[kSize - 1] = 1;
+    CHECK(!s.unlock());
+    CHECK(!s.unlock());                        // unlocking twice is harmless
+    CHECK(!s.lock());
+    CHECK(!s.unlock());
+    (void)shm::segment::remove(name.c_str());
+}
+
+#if !defined(_WIN32)
+
+static void test_range_lock_and_residency() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    const std::size_t ps = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    shm::residency_report r;
+    CHECK(!s.residency(r));
+    CHECK(r.page_bytes == ps);
+    CHECK(r.pages == kSize / ps);
+    CHECK(r.resident == 0);                    // nothing touched yet
+    CHECK(r.first_absent == 0);
+    CHECK(!r.fully_resident());
+
+    // Lock the second half; unaligned bounds widen to whole pages.
+    CHECK(!s.lock(kSize / 2 + 10, kSize / 2 - 20));
+    CHECK(!s.residency(kSize / 2, kSize / 2, r));
+    CHECK(r.fully_resident());
+    CHECK(r.first_absent == shm::residency_report::npos);
+
+    CHECK(!s.residency(r));
+    CHECK(r.resident == kSize / 2 / ps);
+    CHECK(r.first_absent == 0);
+
+    CHECK(!s.unlock(kSize / 2, kSize / 2));
+
+    // Out-of-range requests are empty, not errors.
+    CHECK(!s.residency(kSize, 100, r));
+    CHECK(r.pages == 0 && r.fully_resident());
+    CHECK(!s.lock(kSize + 1, 100));
+}
+
+static void test_lock_on_fault() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    const std::size_t ps = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    CHECK(!s.lock(shm::lock_mode::on_fault));
+    shm::residency_report r;
+    CHECK(!s.residency(r));
+#if defined(__linux__) && defined(MLOCK_ONFAULT)
+    CHECK(r.resident == 0);                    // locked lazily
+    static_cast<volatile unsigned char*>(s.data())[3 * ps] = 7;
+    CHECK(!s.residency(r));
+    CHECK(r.resident == 1);
+    CHECK(r.first_absent == 0);
+    CHECK(!s.residency(3 * ps, 1, r));
+    CHECK(r.pages == 1 && r.fully_resident());
+#else
+    CHECK(r.fully_resident());                 // fell back to mlock
+#endif
+    CHECK(!s.unlock());
+}
+
+static void test_residency_with_header_offsets() {
+    shm::segment_options o = small_pages();
+    o.header = true;
+    shm::segment s(shm::anonymous_segment, kSize, o);
+    const std::size_t ps = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    auto* p = static_cast<unsigned char*>(s.data());
+    p[0] = 1;
+    p[ps] = 1;
+    shm::residency_report r;
+    CHECK(!s.residency(r));
+    CHECK(r.pages == kSize / ps);
+    CHECK(r.resident == 2);
+    CHECK(r.first_absent == 2 * ps);           // data offset, header excluded
+}
+
+#else
+
+static void test_residency_not_supported() {
+    const std::string name = "/shm_lock_res_" + std::to_string(get_pid_u32());
+    shm::segment s(name.c_str(), kSize, shm::segment::open_mode::create_only, small_pages());
+    shm::residency_report r;
+    CHECK(s.residency(r) == std::errc::not_supported);
+}
+
+#endif
+
+} // namespace
+
+int main() {
+    test_lock_option_and_whole_segment_calls();
+#if !defined(_WIN32)
+    test_range_lock_and_residency();
+    test_lock_on_fault();
+    test_residency_with_header_offsets();
+#else
+    test_residency_not_supported();
+#endif
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include "shmTypes.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+struct MigrateTag {};
+
+struct Node {
+    std::uint64_t value;
+    shm::segment_offset_ptr<Node, MigrateTag> next;
+};
+
+struct Root {
+    std::uint64_t count;
+    shm::segment_offset_ptr<Node, MigrateTag> head;
+};
+
+constexpr std::size_t kSize = std::size_t{8} << 20;
+constexpr std::size_t kListNodes = 1000;
+// Words past the list that the writer thread keeps rewriting.
+constexpr std::size_t kWordsAt = 64 * 1024;
+constexpr std::size_t kWords = (kSize - kWordsAt) / sizeof(std::uint64_t);
+
+static shm::segment_options migrate_opts() {
+    shm::segment_options o;
+    o.header = true;
+    o.layout_hash = shm::layout_fingerprint<Root, Node>();
+    return o;
+}
+
+static void build_list(shm::segment& s) {
+    s.bind<MigrateTag>();
+    auto* root = static_cast<Root*>(s.data());
+    auto* nodes = reinterpret_cast<Node*>(root + 1);
+    for (std::uint64_t i = 0; i < kListNodes; ++i) {
+        nodes[i].value = i;
+        nodes[i].next = (i + 1 < kListNodes) ? &nodes[i + 1] : nullptr;
+    }
+    root->head = &nodes[0];
+    root->count = kListNodes;
+}
+
+static std::uint64_t walk_sum(shm::segment& s) {
+    s.bind<MigrateTag>();
+    const auto* root = static_cast<const Root*>(s.data());
+    std::uint64_t sum = 0;
+    for (const Node* n = root->head.get(); n; n = n->next.get()) sum += n->value;
+    return sum;
+}
+
+static void test_migrate_requires_header_and_short_name() {
+    const std::string name = "/shm_mig_nohdr_" + std::to_string(get_pid_u32());
+    const std::string dst = name + "_dst";
+    (void)shm::segment::remove(name.c_str());
+    shm::segment plain(name.c_str(), 4096, shm::segment::open_mode::create_only);
+    CHECK(plain.begin_write());
+    plain.note_write(0, 8);
+    plain.end_write();
+    CHECK(plain.forwarded_to() == nullptr);
+
+    bool threw = false;
+    try {
+        (void)shm::migrate_segment(plain, dst.c_str(), 4096, {});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment s(name.c_str(), 4096, shm::segment::open_mode::create_only, migrate_opts());
+    threw = false;
+    try {
+        (void)shm::migrate_segment(s, std::string(80, 'x').c_str(), 4096, {});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(s.begin_write());
+    s.end_write();
+    (void)shm::segment::remove(name.c_str());
+}
+
+// A writer keeps updating random words (mirrored in a private image) while
+// the segment migrates; every update it made must be in the destination.
+static void test_migrate_under_concurrent_writes() {
+    const std::string name = "/shm_mig_" + std::to_string(get_pid_u32());
+    const std::string dst_name = name + "_dst";
+    (void)shm::segment::remove(name.c_str());
+    (void)shm::segment::remove(dst_name.c_str());
+
+    shm::segment s(name.c_str(), kSize, shm::segment::open_mode::create_only, migrate_opts());
+    build_list(s);
+    auto* words = reinterpret_cast<std::uint64_t*>(static_cast<std::byte*>(s.data()) + kWordsAt);
+    std::vector<std::uint64_t> expected(kWords);
+    for (std::size_t i = 0; i < kWords; ++i) expected[i] = words[i] = i;
+
+    std::atomic<bool> started{false};
+    std::atomic<std::uint64_t> writes{0};
+    std::thread writer([&] {
+        std::uint64_t x = 0x9e3779b97f4a7c15ull;
+        for (;;) {
+            shm::write_section ws(s);
+            if (!ws) break;
+            for (int k = 0; k < 16; ++k) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                const std::size_t i = x % kWords;
+                words[i] = x;
+                expected[i] = x;
+                ws.note(kWordsAt + i * sizeof(std::uint64_t), sizeof(std::uint64_t));
+            }
+            writes.fetch_add(1, std::memory_order_relaxed);
+            started.store(true, std::memory_order_release);
+        }
+    });
+    while (!started.load(std::memory_order_acquire)) std::this_thread::yield();
+
+    shm::migrate_options mo;
+    mo.threads = 3;
+    mo.copy_chunk = 256 * 1024;
+    mo.quiesce_below = 0;
+    shm::migrate_stats st;
+    auto dst = shm::migrate_segment(s, dst_name.c_str(), 2 * kSize, migrate_opts(), mo, &st);
+    writer.join();
+
+    CHECK(dst && dst->is_ready());
+    CHECK(dst->data_size() >= 2 * kSize);
+    CHECK(st.copied_bytes == kSize);
+    CHECK(writes.load() > 0);
+    CHECK(s.forwarded_to() != nullptr && dst_name == s.forwarded_to());
+    CHECK(s.stale());
+    CHECK(!s.begin_write());
+
+    const auto* moved = reinterpret_cast<const std::uint64_t*>(static_cast<const std::byte*>(dst->data()) + kWordsAt);
+    CHECK(std::memcmp(moved, expected.data(), kWords * sizeof(std::uint64_t)) == 0);
+    CHECK(walk_sum(*dst) == (kListNodes - 1) * kListNodes / 2);
+
+    // Another process opens the destination by the published name.
+    shm::segment opener(s.forwarded_to(), 0, shm::segment::open_mode::open_only, migrate_opts());
+    CHECK(opener.is_ready());
+    CHECK(walk_sum(opener) == (kListNodes - 1) * kListNodes / 2);
+
+    (void)shm::segment::remove(name.c_str());
+    (void)shm::segment::remove(dst_name.c_str());
+}
+
+// A write section held past the timeout aborts the migration and leaves the
+// source usable.
+static void test_migrate_times_out_and_rolls_back() {
+    const std::string name = "/shm_mig_to_" + std::to_string(get_pid_u32());
+    const std::string dst_name = name + "_dst";
+    (void)shm::segment::remove(name.c_str());
+    (void)shm::segment::remove(dst_name.c_str());
+
+    shm::segment s(name.c_str(), 1 << 20, shm::segment::open_mode::create_only, migrate_opts());
+    CHECK(s.begin_write());
+
+    shm::migrate_options mo;
+    mo.quiesce_timeout_ms = 20;
+    bool threw = false;
+    try {
+        (void)shm::migrate_segment(s, dst_name.c_str(), 1 << 20, migrate_opts(), mo);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    s.end_write();
+
+    CHECK(s.forwarded_to() == nullptr);
+    CHECK(!s.stale());
+    CHECK(s.begin_write());
+    s.end_write();
+
+    threw = false;
+    try {
+        shm::segment gone(dst_name.c_str(), 0, shm::segment::open_mode::open_only);
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // A second attempt with no open sections goes through.
+    auto dst = shm::migrate_segment(s, dst_name.c_str(), 1 << 20, migrate_opts(), mo);
+    CHECK(dst && dst->is_ready());
+    CHECK(s.forwarded_to() != nullptr);
+
+    bool again = false;
+    try {
+        (void)shm::migrate_segment(s, (dst_name + "2").c_str(), 1 << 20, migrate_opts(), mo);
+    } catch (const std::logic_error&) {
+        again = true;
+    }
+    CHECK(again);
+
+    (void)shm::segment::remove(name.c_str());
+    (void)shm::segment::remove(dst_name.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_migrate_requires_header_and_short_name();
+    test_migrate_under_concurrent_writes();
+    test_migrate_times_out_and_rolls_back();
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+constexpr std::size_t kSize = (std::size_t{1} << 20) + 123;   // not a page multiple
+
+static bool all_zero(const shm::segment& s) {
+    const auto* p = static_cast<const unsigned char*>(s.data());
+    for (std::size_t i = 0; i < s.data_size(); ++i) {
+        if (p[i] != 0) return false;
+    }
+    return true;
+}
+
+static void fill(const shm::segment& s) {
+    auto* p = static_cast<unsigned char*>(s.data());
+    for (std::size_t i = 0; i < s.data_size(); ++i) p[i] = static_cast<unsigned char>(i * 31u + 7u);
+}
+
+static bool holds_fill(const shm::segment& s) {
+    const auto* p = static_cast<const unsigned char*>(s.data());
+    for (std::size_t i = 0; i < s.data_size(); ++i) {
+        if (p[i] != static_cast<unsigned char>(i * 31u + 7u)) return false;
+    }
+    return true;
+}
+
+static void test_every_mode_starts_zeroed() {
+    const std::string name = "/shm_start_" + std::to_string(get_pid_u32());
+    const shm::zero_mode zs[] = {shm::zero_mode::none, shm::zero_mode::memset, shm::zero_mode::lazy};
+    const shm::prefault_mode ps[] = {shm::prefault_mode::none, shm::prefault_mode::populate,
+                                     shm::prefault_mode::touch};
+
+    for (auto z : zs) {
+        for (auto pf : ps) {
+            (void)shm::segment::remove(name.c_str());
+            shm::segment_options o;
+            o.zero = z;
+            o.prefault = pf;
+            o.prefault_threads = 3;
+            shm::segment s(name.c_str(), kSize, shm::segment::open_mode::create_only, o);
+            CHECK(s.is_valid());
+            CHECK(s.size() == kSize);
+            CHECK(all_zero(s));
+            fill(s);
+            CHECK(holds_fill(s));
+        }
+    }
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_prefault_on_open_preserves_contents() {
+    const std::string name = "/shm_start_open_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment creator(name.c_str(), kSize, shm::segment::open_mode::create_only);
+    fill(creator);
+
+    for (auto pf : {shm::prefault_mode::populate, shm::prefault_mode::touch}) {
+        shm::segment_options o;
+        o.prefault = pf;
+        o.prefault_threads = 4;
+        // Zeroing only applies to the creator; an opener must never clear data.
+        o.zero = shm::zero_mode::memset;
+        shm::segment opener(name.c_str(), 0, shm::segment::open_mode::open_only, o);
+        CHECK(holds_fill(opener));
+    }
+    CHECK(holds_fill(creator));
+    (void)shm::segment::remove(name.c_str());
+}
+
+static void test_prefault_with_header() {
+    const std::string name = "/shm_start_hdr_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+
+    shm::segment_options o;
+    o.header = true;
+    o.zero = shm::zero_mode::lazy;
+    o.prefault = shm::prefault_mode::touch;
+    shm::segment creator(name.c_str(), kSize, shm::segment::open_mode::create_only, o);
+    CHECK(creator.is_ready());
+    CHECK(creator.data_size() == kSize);
+    CHECK(all_zero(creator));
+    fill(creator);
+
+    shm::segment opener(name.c_str(), 0, shm::segment::open_mode::open_only, o);
+    CHECK(holds_fill(opener));
+    (void)shm::segment::remove(name.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_every_mode_starts_zeroed();
+    test_prefault_on_open_preserves_contents();
+    test_prefault_with_header();
+    return 0;
+}
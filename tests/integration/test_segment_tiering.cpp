@@ -0,0 +1,240 @@
+#include "shmTypes.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+#define CHECK(expr)                                                                                 \
+    do {                                                                                            \
+        if (!(expr)) {                                                                              \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";      \
+            std::abort();                                                                           \
+        }                                                                                           \
+    } while (0)
+
+static inline std::uint32_t get_pid_u32() noexcept {
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+constexpr std::size_t kChunk = 64 * 1024;
+constexpr std::size_t kChunks = 8;
+constexpr std::size_t kSize = kChunk * kChunks;
+
+#if !defined(_WIN32)
+
+static std::size_t page_size() {
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// Demotion needs MADV_COLD/MADV_PAGEOUT (Linux 5.4+). Elsewhere tier_step()
+// reports not_supported (or the kernel's EINVAL) once a chunk goes idle,
+// and the demotion tests are skipped.
+static bool demote_supported(shm::advice a) {
+    const std::size_t ps = page_size();
+    void* m = ::mmap(nullptr, ps, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(m != MAP_FAILED);
+    *static_cast<volatile char*>(m) = 1;
+    const bool ok = !shm::advise(m, ps, a);
+    ::munmap(m, ps);
+    if (!ok) std::cerr << "skip: demotion advice not supported here\n";
+    return ok;
+}
+
+static shm::segment_options small_pages() {
+    shm::segment_options o;
+    o.pages = shm::page_policy::thp_never;
+    return o;
+}
+
+static shm::tiering_options manual(shm::advice demote, std::uint32_t idle) {
+    shm::tiering_options t;
+    t.interval_ms = 0;
+    t.idle_samples = idle;
+    t.chunk_bytes = kChunk;
+    t.demote = demote;
+    return t;
+}
+
+static void test_tiering_argument_checks() {
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    CHECK(s.tier_step() == std::errc::invalid_argument);
+    CHECK(s.tier_stats().samples == 0);
+
+    bool threw = false;
+    try {
+        s.start_tiering(manual(shm::advice::willneed, 1));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    s.start_tiering(manual(shm::advice::cold, 1));
+    threw = false;
+    try {
+        s.start_tiering(manual(shm::advice::cold, 1));
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    s.stop_tiering();
+    s.stop_tiering();
+    CHECK(s.tier_step() == std::errc::invalid_argument);
+}
+
+// Idle chunks are demoted after idle_samples samples; a chunk that gains
+// resident pages counts as accessed and resets its idle count. Chunks with
+// nothing in RAM are left alone.
+static void test_idle_chunks_are_demoted() {
+    if (!demote_supported(shm::advice::cold)) return;
+    const std::size_t ps = page_size();
+    CHECK(kChunk >= 3 * ps);
+    shm::segment s(shm::anonymous_segment, kSize, small_pages());
+    auto* p = static_cast<unsigned char*>(s.data());
+    for (std::size_t c = 1; c < kChunks; ++c) p[c * kChunk] = 1;
+    s.start_tiering(manual(shm::advice::cold, 3));
+
+    for (std::size_t i = 0; i < 2; ++i) {
+        CHECK(!s.tier_step());
+        // Fault in one new page of chunk 0 per sample: always accessed.
+        p[i * ps] = 1;
+    }
+    CHECK(s.tier_stats().demoted_bytes == 0);
+    CHECK(!s.tier_step());
+    p[2 * ps] = 1;
+
+    const shm::tiering_stats st = s.tier_stats();
+    CHECK(st.samples == 3);
+    CHECK(st.demoted_bytes == (kChunks - 1) * kChunk);
+    CHECK(st.cold_bytes == st.demoted_bytes);
+    CHECK(st.refaulted_bytes == 0);
+
+    // Chunk 5 comes back into use: a refault.
+    p[5 * kChunk + ps] = 1;
+    CHECK(!s.tier_step());
+    const shm::tiering_stats back = s.tier_stats();
+    CHECK(back.refaulted_bytes == kChunk);
+    CHECK(back.cold_bytes == (kChunks - 2) * kChunk);
+
+    // A refaulted chunk waits twice as long before its next demotion;
+    // chunk 0, now idle too, goes after the usual three samples.
+    for (int i = 0; i < 5; ++i) CHECK(!s.tier_step());
+    CHECK(s.tier_stats().cold_bytes == (kChunks - 1) * kChunk);
+    CHECK(!s.tier_step());
+    CHECK(s.tier_stats().cold_bytes == kSize);
+    CHECK(s.tier_stats().demoted_bytes == (kChunks + 1) * kChunk);
+    CHECK(static_cast<unsigned char*>(s.data())[5 * kChunk] == 1);
+}
+
+// pageout on clean file pages really evicts them; reading them back is
+// reported as a refault.
+static void test_pageout_and_refault_on_file() {
+    if (!demote_supported(shm::advice::pageout)) return;
+    const std::string path = "/tmp/shm_tier_" + std::to_string(get_pid_u32());
+    std::remove(path.c_str());
+    shm::segment s(shm::file_backed, path.c_str(), kSize, shm::segment::open_mode::create_only, small_pages());
+    std::memset(s.data(), 0x5a, kSize);
+    CHECK(!s.flush());
+    CHECK(!s.advise(shm::advice::random));   // no read-ahead into neighbouring chunks
+
+    s.start_tiering(manual(shm::advice::pageout, 1));
+    CHECK(!s.tier_step());
+    CHECK(s.tier_stats().demoted_bytes == kSize);
+
+    shm::residency_report r;
+    CHECK(!s.residency(3 * kChunk, kChunk, r));
+    const bool evicted = !r.fully_resident();
+    unsigned sum = 0;
+    for (std::size_t i = 3 * kChunk; i < 4 * kChunk; ++i) sum += static_cast<unsigned char*>(s.data())[i];
+    CHECK(sum == 0x5a * kChunk);
+
+    CHECK(!s.tier_step());
+    CHECK(s.tier_stats().refaulted_bytes == (evicted ? kChunk : 0));
+    s.stop_tiering();
+    std::remove(path.c_str());
+}
+
+// Also needs grow() on a shm segment, which Darwin lacks; the demotion
+// check already skips every non-Linux system.
+static void test_background_thread_and_grow() {
+    if (!demote_supported(shm::advice::cold)) return;
+    const std::string name = "/shm_tier_" + std::to_string(get_pid_u32());
+    (void)shm::segment::remove(name.c_str());
+    shm::segment_options o = small_pages();
+    o.header = true;
+    shm::segment s(name.c_str(), kSize, shm::segment::open_mode::create_only, o);
+    std::memset(s.data(), 1, kSize);
+
+    shm::tiering_options t = manual(shm::advice::cold, 1);
+    t.interval_ms = 5;
+    s.start_tiering(t);
+
+    auto wait_for = [&](auto pred) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!pred(s.tier_stats()) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return pred(s.tier_stats());
+    };
+    CHECK(wait_for([](const shm::tiering_stats& st) { return st.demoted_bytes == kSize; }));
+
+    // Growing restarts sampling over the larger region.
+    s.grow(2 * kSize);
+    std::memset(static_cast<unsigned char*>(s.data()) + kSize, 1, kSize);
+    CHECK(wait_for([](const shm::tiering_stats& st) { return st.demoted_bytes == 2 * kSize; }));
+    s.stop_tiering();
+    (void)shm::segment::remove(name.c_str());
+}
+
+#else
+
+static void test_tiering_not_supported() {
+    const std::string name = "/shm_tier_" + std::to_string(get_pid_u32());
+    shm::segment s(name.c_str(), kSize, shm::segment::open_mode::create_only);
+    bool threw = false;
+    try {
+        s.start_tiering();
+    } catch (const std::system_error& e) {
+        threw = e.code() == std::errc::not_supported;
+    }
+    CHECK(threw);
+}
+
+#endif
+
+} // namespace
+
+int main() {
+#if !defined(_WIN32)
+    test_tiering_argument_checks();
+    test_idle_chunks_are_demoted();
+    test_pageout_and_refault_on_file();
+    test_background_thread_and_grow();
+#else
+    test_tiering_not_supported();
+#endif
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "shmTypes.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct AtomicTag {};
+struct StackTag {};
+
+static void test_layout_and_lock_freedom() {
+    using A32 = shm::atomic_offset_ptr<int, shm::self_anchor, std::int32_t>;
+    using A64 = shm::atomic_offset_ptr<int, shm::segment_anchor<AtomicTag>, std::uint64_t>;
+    using AT  = shm::atomic_tagged_offset_ptr<int, shm::segment_anchor<AtomicTag>, std::uint32_t>;
+
+    static_assert(sizeof(A32) == sizeof(std::int32_t));
+    static_assert(sizeof(A64) == sizeof(std::uint64_t));
+    static_assert(sizeof(AT) == sizeof(std::uint64_t));
+    static_assert(A32::is_always_lock_free && A64::is_always_lock_free && AT::is_always_lock_free);
+    static_assert(!std::is_copy_constructible_v<A32>);
+
+    A32 a;
+    CHECK(a.is_lock_free());
+    CHECK(a.load() == nullptr);
+    CHECK(a.raw_storage() == 0);
+}
+
+static void test_self_anchor_encodes_per_address() {
+    constexpr std::size_t N = 256;
+    alignas(std::max_align_t) std::byte buf[N];
+    std::memset(buf, 0, N);
+
+    using A = shm::atomic_offset_ptr<int, shm::self_anchor, std::int32_t>;
+    auto* a = new (buf + 16) A(nullptr);
+    auto* b = new (buf + 64) A(nullptr);
+    auto* target = new (buf + 128) int(5);
+
+    a->store(target, std::memory_order_release);
+    b->store(target, std::memory_order_release);
+    CHECK(a->load(std::memory_order_acquire) == target);
+    CHECK(b->load(std::memory_order_acquire) == target);
+    CHECK(a->raw_storage() != b->raw_storage());
+
+    shm::offset_ptr<int, shm::self_anchor, std::int32_t>* plain =
+        new (buf + 16) shm::offset_ptr<int, shm::self_anchor, std::int32_t>(target);
+    CHECK(plain->raw_storage() == b->raw_storage() + (64 - 16));
+
+    int* expected = target;
+    auto* other = new (buf + 192) int(6);
+    CHECK(b->compare_exchange_strong(expected, other));
+    CHECK(b->load() == other);
+
+    expected = target;
+    CHECK(!b->compare_exchange_strong(expected, nullptr));
+    CHECK(expected == other);
+
+    CHECK(b->exchange(nullptr) == other);
+    CHECK(b->raw_storage() == 0);
+}
+
+static void test_segment_anchor_survives_relocation() {
+    constexpr std::size_t N = 256;
+    alignas(std::max_align_t) std::byte region_a[N];
+    alignas(std::max_align_t) std::byte region_b[N];
+    std::memset(region_a, 0, N);
+    std::memset(region_b, 0, N);
+
+    using A = shm::atomic_offset_ptr<int, shm::segment_anchor<AtomicTag>, std::uint32_t>;
+
+    shm::segment_base<AtomicTag>::set(region_a);
+    auto* slot = new (region_a) A(nullptr);
+    new (region_a + 64) int(99);
+    *slot = reinterpret_cast<int*>(region_a + 64);
+
+    std::memcpy(region_b, region_a, N);
+    shm::segment_base<AtomicTag>::set(region_b);
+
+    auto* slot_b = std::launder(reinterpret_cast<A*>(region_b));
+    int* p = *slot_b;
+    CHECK(p == reinterpret_cast<int*>(region_b + 64));
+    CHECK(*p == 99);
+}
+
+static void test_tagged_cas_detects_aba() {
+    constexpr std::size_t N = 256;
+    alignas(std::max_align_t) std::byte region[N];
+    std::memset(region, 0, N);
+    shm::segment_base<AtomicTag>::set(region);
+
+    using AT = shm::atomic_tagged_offset_ptr<int, shm::segment_anchor<AtomicTag>, std::uint32_t>;
+    auto* x = new (region + 64) int(1);
+    auto* y = new (region + 128) int(2);
+
+    AT head(AT::value_type{x, 0});
+    AT::value_type seen = head.load();
+    CHECK(seen.ptr == x);
+    CHECK(seen.tag == 0);
+
+    // A -> B -> A with version bumps; the stale snapshot must lose.
+    CHECK(head.compare_exchange_strong(seen, AT::value_type{y, seen.tag + 1}));
+    AT::value_type cur = head.load();
+    CHECK(head.compare_exchange_strong(cur, AT::value_type{x, cur.tag + 1}));
+
+    AT::value_type stale{x, 0};
+    CHECK(!head.compare_exchange_strong(stale, AT::value_type{nullptr, 7}));
+    CHECK(stale.ptr == x);
+    CHECK(stale.tag == 2);
+
+    CHECK(head.exchange(AT::value_type{nullptr, 0}) == (AT::value_type{x, 2}));
+    CHECK(head.raw_storage() == 0);
+}
+
+// Treiber stack over a segment-resident node array, using the tagged head to
+// defeat ABA when nodes are recycled.
+static void test_tagged_treiber_stack_mt() {
+    struct Node {
+        shm::segment_offset_ptr<Node, StackTag, std::uint32_t> next;
+        std::uint32_t value;
+    };
+    using Head = shm::atomic_tagged_offset_ptr<Node, shm::segment_anchor<StackTag>, std::uint32_t>;
+
+    constexpr std::size_t kNodes = 64;
+    constexpr int kThreads = 4;
+    constexpr int kRounds = 20000;
+
+    std::vector<std::byte> region(sizeof(Head) + 64 + kNodes * sizeof(Node) + alignof(Node));
+    std::byte* base = region.data();
+    shm::segment_base<StackTag>::set(base);
+
+    auto* head = new (base) Head();
+    auto* nodes = reinterpret_cast<Node*>(base + 64);
+
+    auto push = [&](Node* n) {
+        Head::value_type h = head->load(std::memory_order_relaxed);
+        for (;;) {
+            n->next = h.ptr;
+            if (head->compare_exchange_weak(h, Head::value_type{n, h.tag + 1},
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) return;
+        }
+    };
+    auto pop = [&]() -> Node* {
+        Head::value_type h = head->load(std::memory_order_acquire);
+        for (;;) {
+            if (!h.ptr) return nullptr;
+            Node* next = h.ptr->next.get();
+            if (head->compare_exchange_weak(h, Head::value_type{next, h.tag + 1},
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) return h.ptr;
+        }
+    };
+
+    for (std::size_t i = 0; i < kNodes; ++i) {
+        Node* n = new (&nodes[i]) Node{nullptr, static_cast<std::uint32_t>(i)};
+        push(n);
+    }
+
+    std::vector<std::thread> ts;
+    for (int t = 0; t < kThreads; ++t) {
+        ts.emplace_back([&] {
+            for (int r = 0; r < kRounds; ++r) {
+                Node* n = pop();
+                if (n) push(n);
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+
+    std::vector<bool> seen(kNodes, false);
+    std::size_t count = 0;
+    while (Node* n = pop()) {
+        CHECK(n->value < kNodes);
+        CHECK(!seen[n->value]);
+        seen[n->value] = true;
+        ++count;
+    }
+    CHECK(count == kNodes);
+}
+
+} // namespace
+
+int main() {
+    test_layout_and_lock_freedom();
+    test_self_anchor_encodes_per_address();
+    test_segment_anchor_survives_relocation();
+    test_tagged_cas_detects_aba();
+    test_tagged_treiber_stack_mt();
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct BatchTag {};
+
+struct Item {
+    std::uint64_t v;
+};
+
+static std::uint64_t lcg(std::uint64_t& s) noexcept {
+    s = s * 6364136223846793005ull + 1442695040888963407ull;
+    return s >> 33;
+}
+
+// Every length up to a few vector widths, so both the SIMD body and the scalar
+// tail are exercised, with ~1/4 nulls sprinkled in.
+template <class OffsetT>
+static void check_roundtrip_for() {
+    constexpr std::size_t kItems = 512;
+    std::vector<Item> region(kItems);
+    shm::segment_base<BatchTag>::set(region.data());
+
+    using P = shm::segment_offset_ptr<Item, BatchTag, OffsetT>;
+
+    std::uint64_t seed = 12345;
+    for (std::size_t n = 0; n <= 67; ++n) {
+        std::vector<Item*> raw(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::uint64_t r = lcg(seed);
+            raw[i] = (r % 4 == 0) ? nullptr : &region[r % kItems];
+        }
+
+        std::vector<P> enc(n + 1, P(nullptr));
+        const P sentinel(&region[7]);
+        enc[n] = sentinel;
+        shm::encode_n(raw.data(), n, enc.data());
+        CHECK(enc[n].raw_storage() == sentinel.raw_storage());
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const P expect(raw[i]);
+            CHECK(enc[i].raw_storage() == expect.raw_storage());
+        }
+
+        std::vector<Item*> dec(n + 1, reinterpret_cast<Item*>(&seed));
+        shm::decode_n(enc.data(), n, dec.data());
+        CHECK(dec[n] == reinterpret_cast<Item*>(&seed));
+        for (std::size_t i = 0; i < n; ++i) {
+            CHECK(dec[i] == raw[i]);
+            CHECK(dec[i] == enc[i].get());
+        }
+    }
+}
+
+static void test_signed_offsets_reach_backwards() {
+    constexpr std::size_t kItems = 64;
+    std::vector<Item> region(kItems);
+    shm::segment_base<BatchTag>::set(&region[32]);
+
+    using P = shm::segment_offset_ptr<Item, BatchTag, std::int32_t>;
+    std::vector<Item*> raw;
+    for (std::size_t i = 0; i < kItems; ++i) raw.push_back(i % 5 == 0 ? nullptr : &region[i]);
+
+    std::vector<P> enc(raw.size());
+    shm::encode_n(raw.data(), raw.size(), enc.data());
+    std::vector<Item*> dec(raw.size());
+    shm::decode_n(enc.data(), enc.size(), dec.data());
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        CHECK(dec[i] == raw[i]);
+        CHECK(enc[i].get() == raw[i]);
+    }
+}
+
+static void test_self_anchor_falls_back_per_element() {
+    using P = shm::offset_ptr<Item, shm::self_anchor, std::int32_t>;
+    Item items[8]{};
+    Item* raw[8] = {&items[0], nullptr, &items[2], &items[3], nullptr, &items[5], &items[6], &items[7]};
+
+    P enc[8];
+    shm::encode_n(raw, 8, enc);
+    Item* dec[8]{};
+    shm::decode_n(enc, 8, dec);
+    for (int i = 0; i < 8; ++i) CHECK(dec[i] == raw[i]);
+}
+
+} // namespace
+
+int main() {
+    check_roundtrip_for<std::uint32_t>();
+    check_roundtrip_for<std::int32_t>();
+    check_roundtrip_for<std::uint64_t>();
+    check_roundtrip_for<std::int64_t>();
+    check_roundtrip_for<std::uint16_t>();
+    test_signed_offsets_reach_backwards();
+    test_self_anchor_falls_back_per_element();
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct WalkTag {};
+
+struct Node {
+    std::uint32_t chain;
+    std::uint32_t pos;
+    shm::segment_offset_ptr<Node, WalkTag> next;
+};
+
+// Builds `chains` lists with lengths 0, 1, 2, ... (mod 7) whose nodes are
+// interleaved in the region, and returns the decoded heads.
+static std::vector<Node*> build(std::byte* region, std::size_t chains) {
+    std::vector<Node*> heads(chains, nullptr);
+    std::vector<Node*> tails(chains, nullptr);
+    auto* nodes = reinterpret_cast<Node*>(region);
+    std::size_t used = 0;
+    for (std::uint32_t pos = 0; pos < 7; ++pos) {
+        for (std::size_t c = 0; c < chains; ++c) {
+            if (pos >= c % 7) continue;
+            Node* n = new (&nodes[used++]) Node{static_cast<std::uint32_t>(c), pos, nullptr};
+            if (tails[c]) tails[c]->next = n; else heads[c] = n;
+            tails[c] = n;
+        }
+    }
+    return heads;
+}
+
+template <std::size_t Width>
+static void check_walk(std::size_t chains) {
+    std::vector<std::byte> region(chains * 7 * sizeof(Node) + sizeof(Node));
+    shm::segment_base<WalkTag>::set(region.data());
+    const auto heads = build(region.data(), chains);
+
+    std::vector<std::uint32_t> seen(chains, 0);
+    shm::interleaved_walk<Width>(heads.data(), heads.size(), [&](std::size_t c, Node* n) {
+        CHECK(n->chain == c);
+        CHECK(n->pos == seen[c]);  // in order within a chain
+        ++seen[c];
+        n->next.prefetch();
+        return n->next.get();
+    });
+    for (std::size_t c = 0; c < chains; ++c) CHECK(seen[c] == c % 7);
+}
+
+static void test_walks_every_node_in_chain_order() {
+    check_walk<1>(20);
+    check_walk<4>(3);
+    check_walk<4>(50);
+    check_walk<16>(0);
+    check_walk<16>(1);
+    check_walk<16>(300);
+}
+
+static void test_early_termination() {
+    std::vector<std::byte> region(64 * 7 * sizeof(Node));
+    shm::segment_base<WalkTag>::set(region.data());
+    const auto heads = build(region.data(), 64);
+
+    // Stop every chain at its second node, as a hash probe stops on a hit.
+    std::size_t steps = 0;
+    shm::interleaved_walk<8>(heads.data(), heads.size(), [&](std::size_t, Node* n) -> Node* {
+        ++steps;
+        return n->pos == 1 ? nullptr : n->next.get();
+    });
+    std::size_t expected = 0;
+    for (std::size_t c = 0; c < 64; ++c) expected += (c % 7 >= 2) ? 2 : c % 7;
+    CHECK(steps == expected);
+}
+
+static void test_prefetch_on_null_is_harmless() {
+    shm::segment_offset_ptr<Node, WalkTag> p;
+    p.prefetch();
+    shm::offset_ptr<Node> q;
+    q.prefetch();
+    shm::fat_offset_ptr<Node> f;
+    f.prefetch();
+}
+
+} // namespace
+
+int main() {
+    test_walks_every_node_in_chain_order();
+    test_early_termination();
+    test_prefetch_on_null_is_harmless();
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct RefTag {};
+
+struct Owner {
+    std::uint32_t id;
+};
+
+struct Slot {
+    shm::segment_offset_ref<Owner, RefTag> owner;
+    std::uint32_t value;
+};
+
+using SelfRef = shm::offset_ref<Owner>;
+using SegRef  = shm::segment_offset_ref<Owner, RefTag>;
+
+static_assert(sizeof(SegRef) == sizeof(std::uint32_t));
+static_assert(std::is_trivially_copyable_v<SegRef>);
+static_assert(!std::is_trivially_copyable_v<SelfRef>);
+static_assert(!std::is_default_constructible_v<SegRef>);
+static_assert(!std::is_constructible_v<SegRef, Owner&&>);
+
+static void test_segment_ref_raw_displacement_and_relocation() {
+    constexpr std::size_t N = 256;
+    alignas(16) std::byte a[N];
+    alignas(16) std::byte b[N];
+    std::memset(a, 0, N);
+
+    shm::segment_base<RefTag>::set(a);
+
+    auto* o = new (a + 0) Owner{7};
+    auto* s = new (a + 64) Slot{*o, 1};
+
+    // Raw displacement: an owner at the segment base encodes as 0.
+    CHECK(s->owner.raw_storage() == 0);
+    CHECK(&s->owner.get() == o);
+    CHECK(s->owner->id == 7);
+
+    auto* o2 = new (a + 128) Owner{9};
+    s->owner = *o2;
+    CHECK(s->owner.raw_storage() == 128);
+    Owner& r = s->owner;
+    CHECK(&r == o2);
+
+    std::memcpy(b, a, N);
+    shm::segment_base<RefTag>::set(b);
+    auto* s_b = std::launder(reinterpret_cast<Slot*>(b + 64));
+    CHECK(s_b->owner.address() == reinterpret_cast<Owner*>(b + 128));
+    CHECK((*s_b->owner).id == 9);
+}
+
+static void test_conversions_with_offset_ptr() {
+    alignas(16) std::byte a[128];
+    shm::segment_base<RefTag>::set(a);
+    auto* o = new (a + 32) Owner{3};
+
+    shm::segment_offset_ptr<Owner, RefTag> p(o);
+    SegRef ref(p);
+    CHECK(ref.address() == o);
+
+    shm::segment_offset_ptr<Owner, RefTag> back = ref;
+    CHECK(back == p);
+    CHECK(back.raw_storage() == static_cast<std::uint32_t>(ref.raw_storage() + 1));
+    CHECK(ref.to_ptr().get() == o);
+}
+
+static void test_self_ref_rebases_on_copy() {
+    struct Holder {
+        Owner o;
+        SelfRef ref;
+    };
+    alignas(Holder) std::byte buf_a[sizeof(Holder)];
+    alignas(Holder) std::byte buf_b[sizeof(Holder)];
+    auto* h = new (buf_a) Holder{Owner{5}, SelfRef(*reinterpret_cast<Owner*>(buf_a))};
+    CHECK(h->ref.raw_storage() == -static_cast<std::int32_t>(offsetof(Holder, ref)));
+    CHECK(h->ref->id == 5);
+
+    auto* h2 = new (buf_b) Holder{Owner{6}, h->ref};
+    CHECK(h2->ref.address() == &h->o);
+    CHECK(h2->ref == h->ref);
+
+    h2->ref = h2->o;
+    CHECK(h2->ref->id == 6);
+    CHECK(h2->ref.raw_storage() == h->ref.raw_storage());
+}
+
+} // namespace
+
+int main() {
+    test_segment_ref_raw_displacement_and_relocation();
+    test_conversions_with_offset_ptr();
+    test_self_ref_rebases_on_copy();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "shmTypes.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <numeric>
+#include <ranges>
+#include <span>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct SpanTag {};
+
+using USpan = shm::segment_offset_span<std::uint32_t, SpanTag>;
+
+static_assert(std::contiguous_iterator<USpan::iterator>);
+static_assert(std::ranges::contiguous_range<USpan>);
+static_assert(std::is_trivially_copyable_v<USpan>);
+
+template <class OffsetT>
+static void check_offset_domain_ops() {
+    using P = shm::segment_offset_ptr<std::uint64_t, SpanTag, OffsetT>;
+
+    alignas(8) std::byte region[1024];
+    shm::segment_base<SpanTag>::set(region);
+    auto* arr = reinterpret_cast<std::uint64_t*>(region + 64);
+
+    P p(arr);
+    P q = p + 10;
+    CHECK(q.get() == arr + 10);
+    CHECK(q.raw_storage() == static_cast<OffsetT>(p.raw_storage() + 80));
+    CHECK(q - p == 10);
+    CHECK(p - q == -10);
+    CHECK(p < q);
+    CHECK(!(q < p));
+    CHECK(q >= p);
+
+    q -= 3;
+    CHECK(q.get() == arr + 7);
+    ++q;
+    --q;
+    --q;
+    CHECK(q.get() == arr + 6);
+    CHECK(q == P(arr + 6));
+    CHECK(q != p);
+    CHECK(P(nullptr) == nullptr);
+    CHECK(!(p == nullptr));
+
+    // Mixed pointee types on one anchor still compare by address.
+    shm::segment_offset_ptr<void, SpanTag, OffsetT> v(static_cast<void*>(arr + 6));
+    CHECK(v == q);
+}
+
+static void test_offset_domain_arithmetic() {
+    check_offset_domain_ops<std::uint32_t>();
+    check_offset_domain_ops<std::int32_t>();
+    check_offset_domain_ops<std::uint64_t>();
+
+    // Unsigned offsets: null orders first, as a null raw pointer would.
+    alignas(8) std::byte region[64];
+    shm::segment_base<SpanTag>::set(region);
+    shm::segment_offset_ptr<std::uint64_t, SpanTag> null_p, first(reinterpret_cast<std::uint64_t*>(region));
+    CHECK(null_p < first);
+}
+
+static void test_span_over_segment_array() {
+    constexpr std::size_t N = 4096;
+    alignas(64) std::byte a[N];
+    alignas(64) std::byte b[N];
+    std::memset(a, 0, N);
+    shm::segment_base<SpanTag>::set(a);
+
+    // The span header and the array both live in the segment.
+    auto* hdr = new (a) USpan();
+    auto* data = reinterpret_cast<std::uint32_t*>(a + 64);
+    constexpr std::size_t count = 500;
+    *hdr = USpan(data, count);
+    for (std::size_t i = 0; i < count; ++i) data[i] = static_cast<std::uint32_t>((i * 7919) % count);
+
+    CHECK(hdr->size() == count);
+    CHECK(!hdr->empty());
+    CHECK(std::accumulate(hdr->begin(), hdr->end(), std::uint64_t{0}) == count * (count - 1) / 2);
+
+    std::ranges::sort(*hdr);
+    CHECK(std::ranges::is_sorted(*hdr));
+    CHECK(hdr->front() == 0);
+    CHECK(hdr->back() == count - 1);
+    CHECK((*hdr)[42] == 42);
+
+    std::memcpy(b, a, N);
+    shm::segment_base<SpanTag>::set(b);
+    auto* moved = std::launder(reinterpret_cast<USpan*>(b));
+    CHECK(moved->data() == reinterpret_cast<std::uint32_t*>(b + 64));
+    std::span<std::uint32_t> s = *moved;
+    CHECK(s.size() == count);
+    CHECK(std::ranges::equal(s, std::views::iota(std::uint32_t{0}, std::uint32_t{count})));
+
+    USpan empty;
+    CHECK(empty.empty());
+    CHECK(empty.begin() == empty.end());
+}
+
+} // namespace
+
+int main() {
+    test_offset_domain_arithmetic();
+    test_span_over_segment_array();
+    return 0;
+}
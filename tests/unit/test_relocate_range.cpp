@@ -0,0 +1,155 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <tuple>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct RelTag {};
+
+struct Item {
+    std::uint32_t value;
+    shm::offset_ptr<Item> next;                        // within the array
+    shm::offset_ptr<std::uint64_t> external;           // outside the array
+    shm::offset_ref<Item> owner;                       // non-nullable, within
+    shm::segment_offset_ptr<std::uint64_t, RelTag> seg; // detached, untouched
+};
+
+} // namespace
+
+template <>
+struct shm::link_fields<Item> {
+    static constexpr auto value = std::make_tuple(&Item::next, &Item::external, &Item::owner, &Item::seg);
+};
+
+namespace {
+
+struct AtomicItem {
+    std::uint32_t value;
+    shm::atomic_offset_ptr<AtomicItem> next;                // within the array
+    shm::atomic_tagged_offset_ptr<std::uint64_t> external;  // outside, tagged
+};
+
+} // namespace
+
+template <>
+struct shm::link_fields<AtomicItem> {
+    static constexpr auto value = std::make_tuple(&AtomicItem::next, &AtomicItem::external);
+};
+
+namespace {
+
+constexpr std::size_t N = 16;
+
+static void fill(Item* items, std::uint64_t* ext, std::byte* seg_base) {
+    shm::segment_base<RelTag>::set(seg_base);
+    for (std::size_t i = 0; i < N; ++i) {
+        new (&items[i]) Item{static_cast<std::uint32_t>(i), nullptr, nullptr, shm::offset_ref<Item>(items[0]),
+                             shm::segment_offset_ptr<std::uint64_t, RelTag>(ext + i % 4)};
+        items[i].external = ext + (i % 4);
+    }
+    for (std::size_t i = 0; i + 1 < N; ++i) items[i].next = &items[i + 1];
+}
+
+static void verify(Item* items, std::uint64_t* ext) {
+    for (std::size_t i = 0; i < N; ++i) {
+        CHECK(items[i].value == i);
+        CHECK(items[i].next.get() == (i + 1 < N ? &items[i + 1] : nullptr));
+        CHECK(items[i].external.get() == ext + i % 4);
+        CHECK(&items[i].owner.get() == &items[0]);
+        CHECK(items[i].seg.get() == ext + i % 4);
+    }
+}
+
+static void test_relocate_to_separate_buffer() {
+    std::uint64_t ext[4] = {1, 2, 3, 4};
+    alignas(Item) std::byte from[sizeof(Item) * N];
+    alignas(Item) std::byte to[sizeof(Item) * N];
+    auto* src = reinterpret_cast<Item*>(from);
+    auto* dst = reinterpret_cast<Item*>(to);
+
+    fill(src, ext, reinterpret_cast<std::byte*>(ext));
+    verify(src, ext);
+    shm::relocate_range(dst, src, N);
+    verify(std::launder(dst), ext);
+}
+
+static void test_relocate_overlapping() {
+    std::uint64_t ext[4] = {5, 6, 7, 8};
+    alignas(Item) std::byte buf[sizeof(Item) * (N + 3)];
+    auto* items = reinterpret_cast<Item*>(buf);
+
+    fill(items, ext, reinterpret_cast<std::byte*>(ext));
+    shm::relocate_range(items + 3, items, N);   // shift up
+    verify(std::launder(items + 3), ext);
+    shm::relocate_range(items, items + 3, N);   // and back down
+    verify(std::launder(items), ext);
+}
+
+static void test_empty_and_identity() {
+    alignas(Item) std::byte buf[sizeof(Item)];
+    auto* items = reinterpret_cast<Item*>(buf);
+    shm::relocate_range(items, items, 1);
+    shm::relocate_range(items, items + 1, 0);
+}
+
+static void fill_atomic(AtomicItem* items, std::uint64_t* ext) {
+    for (std::size_t i = 0; i < N; ++i) {
+        auto* it = new (&items[i]) AtomicItem{};
+        it->value = static_cast<std::uint32_t>(i);
+        it->external.store({ext + i % 4, static_cast<std::uint32_t>(100 + i)});
+    }
+    for (std::size_t i = 0; i + 1 < N; ++i) items[i].next.store(&items[i + 1]);
+}
+
+static void verify_atomic(AtomicItem* items, std::uint64_t* ext) {
+    for (std::size_t i = 0; i < N; ++i) {
+        CHECK(items[i].value == i);
+        CHECK(items[i].next.load() == (i + 1 < N ? &items[i + 1] : nullptr));
+        const auto v = items[i].external.load();
+        CHECK(v.ptr == ext + i % 4);
+        CHECK(v.tag == 100 + i);
+    }
+}
+
+static void test_relocate_atomic_fields() {
+    std::uint64_t ext[4] = {9, 10, 11, 12};
+    alignas(AtomicItem) std::byte from[sizeof(AtomicItem) * N];
+    alignas(AtomicItem) std::byte to[sizeof(AtomicItem) * N];
+    auto* src = reinterpret_cast<AtomicItem*>(from);
+    auto* dst = reinterpret_cast<AtomicItem*>(to);
+
+    fill_atomic(src, ext);
+    verify_atomic(src, ext);
+    shm::relocate_range(dst, src, N);
+    verify_atomic(std::launder(dst), ext);
+
+    alignas(AtomicItem) std::byte buf[sizeof(AtomicItem) * (N + 2)];
+    auto* items = reinterpret_cast<AtomicItem*>(buf);
+    fill_atomic(items, ext);
+    shm::relocate_range(items + 2, items, N);   // overlapping
+    verify_atomic(std::launder(items + 2), ext);
+}
+
+} // namespace
+
+int main() {
+    test_relocate_to_separate_buffer();
+    test_relocate_overlapping();
+    test_relocate_atomic_fields();
+    test_empty_and_identity();
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct ScaleTag {};
+
+struct alignas(16) Vertex {
+    std::uint64_t id;
+    shm::scaled_segment_offset_ptr<Vertex, ScaleTag> next;  // units of alignof(Vertex)
+};
+
+static void test_scale_resolution_and_reach() {
+    using P16 = shm::scaled_segment_offset_ptr<Vertex, ScaleTag>;
+    using P8  = shm::scaled_segment_offset_ptr<void, ScaleTag, std::uint32_t, 8>;
+
+    static_assert(sizeof(P16) == sizeof(std::uint32_t));
+    static_assert(std::is_trivially_copyable_v<P16>);
+    static_assert(P16::scale() == 16);
+    static_assert(P8::scale() == 8);
+    static_assert(P16::max_reach() == (std::uint64_t{0xFFFFFFFFu} << 4));
+    static_assert(P8::max_reach() == (std::uint64_t{0xFFFFFFFFu} << 3));
+}
+
+static void test_roundtrip_and_relocation() {
+    constexpr std::size_t N = 1024;
+    alignas(64) std::byte region_a[N];
+    alignas(64) std::byte region_b[N];
+    std::memset(region_a, 0, N);
+    std::memset(region_b, 0, N);
+
+    shm::segment_base<ScaleTag>::set(region_a);
+
+    auto* v0 = new (region_a + 0)   Vertex{10, nullptr};
+    auto* v1 = new (region_a + 32)  Vertex{11, nullptr};
+    auto* v2 = new (region_a + 512) Vertex{12, nullptr};
+    v0->next = v1;
+    v1->next = v2;
+
+    CHECK(v0->next.raw_storage() == 32 / 16 + 1);
+    CHECK(v1->next.raw_storage() == 512 / 16 + 1);
+    CHECK(v0->next.get() == v1);
+    CHECK(v0->next < v1->next);
+    CHECK(v2->next == nullptr);
+
+    std::memcpy(region_b, region_a, N);
+    shm::segment_base<ScaleTag>::set(region_b);
+
+    auto* h = std::launder(reinterpret_cast<Vertex*>(region_b));
+    std::uint64_t sum = 0;
+    int hops = 0;
+    for (Vertex* cur = h; cur; cur = cur->next.get()) {
+        sum += cur->id;
+        CHECK(++hops < 8);
+    }
+    CHECK(hops == 3);
+    CHECK(sum == 33);
+}
+
+static void test_offsets_beyond_4gib() {
+    // Only addresses are formed here; nothing beyond the buffer is touched.
+    alignas(64) static std::byte anchor[64];
+    shm::segment_base<ScaleTag>::set(anchor);
+
+    using P = shm::scaled_segment_offset_ptr<void, ScaleTag, std::uint32_t, 16>;
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(anchor);
+
+    for (std::uint64_t off : {std::uint64_t{0}, std::uint64_t{16},
+                              std::uint64_t{5} << 30, std::uint64_t{48} << 30,
+                              P::max_reach() - 16}) {
+        void* target = reinterpret_cast<void*>(base + static_cast<std::uintptr_t>(off));
+        P p(target);
+        CHECK(p.get() == target);
+        CHECK(static_cast<std::uint64_t>(p.raw_storage()) == off / 16 + 1);
+    }
+}
+
+} // namespace
+
+int main() {
+    test_scale_resolution_and_reach();
+    test_roundtrip_and_relocation();
+    if constexpr (sizeof(void*) == 8) test_offsets_beyond_4gib();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <tuple>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct GraphTag {};
+
+struct Vertex {
+    std::uint32_t id;
+    std::uint32_t weight;
+    shm::segment_offset_ptr<Vertex, GraphTag> left;
+    shm::segment_tagged_ptr<Vertex, GraphTag, 2> right;  // 2 mark bits
+};
+
+} // namespace
+
+template <>
+struct shm::link_fields<Vertex> {
+    static constexpr auto value = std::make_tuple(&Vertex::left, &Vertex::right);
+};
+
+namespace {
+
+static_assert(shm::has_link_fields<Vertex>);
+static_assert(!shm::has_link_fields<int>);
+static_assert(shm::link_count_v<Vertex> == 2);
+
+// 0 -> (1, 2), 1 -> (3, null), 2 -> (3, 0): shared child and a back edge.
+static Vertex* build(std::byte* region) {
+    auto* v = reinterpret_cast<Vertex*>(region);
+    for (std::uint32_t i = 0; i < 5; ++i) new (&v[i]) Vertex{i, i * 10, nullptr, shm::segment_tagged_ptr<Vertex, GraphTag, 2>()};
+    v[0].left = &v[1];
+    v[0].right.set(&v[2], 1);
+    v[1].left = &v[3];
+    v[2].left = &v[3];
+    v[2].right.set(&v[0], 3);
+    return &v[0];  // v[4] is unreachable
+}
+
+static void test_swizzle_preserves_shape() {
+    alignas(Vertex) std::byte region[sizeof(Vertex) * 5];
+    shm::segment_base<GraphTag>::set(region);
+    Vertex* root = build(region);
+
+    auto g = shm::swizzle(root);
+    CHECK(g.size() == 4);
+
+    auto* r = g.root();
+    CHECK(r->origin == root);
+    CHECK(r->value.id == 0);
+    auto* a = r->links[0];
+    auto* b = r->links[1];
+    CHECK(a->value.id == 1 && b->value.id == 2);
+    CHECK(a->links[0] == b->links[0]);   // shared child copied once
+    CHECK(a->links[1] == nullptr);
+    CHECK(b->links[1] == r);             // cycle kept
+    CHECK(a->links[0]->value.weight == 30);
+
+    std::uint64_t sum = 0;
+    for (const auto& n : g) sum += n.value.weight;
+    CHECK(sum == 0 + 10 + 20 + 30);
+}
+
+static void test_unswizzle_publishes_changes() {
+    alignas(Vertex) std::byte region[sizeof(Vertex) * 5];
+    alignas(Vertex) std::byte moved[sizeof(Vertex) * 5];
+    shm::segment_base<GraphTag>::set(region);
+    Vertex* root = build(region);
+
+    auto g = shm::swizzle(root);
+    auto* r = g.root();
+    auto* a = r->links[0];
+    auto* b = r->links[1];
+    // Swap the children of the root, drop the back edge, bump a weight.
+    r->links[0] = b;
+    r->links[1] = a;
+    b->links[1] = nullptr;
+    a->value.weight = 99;
+    shm::unswizzle(g);
+
+    // The published form is still position independent.
+    std::memcpy(moved, region, sizeof(region));
+    shm::segment_base<GraphTag>::set(moved);
+    auto* v = std::launder(reinterpret_cast<Vertex*>(moved));
+    CHECK(v[0].left.get() == &v[2]);
+    CHECK(v[0].right.get() == &v[1]);
+    CHECK(v[0].right.tag() == 1);       // tag survives the rewrite
+    CHECK(v[2].right.get() == nullptr);
+    CHECK(v[2].right.tag() == 3);
+    CHECK(v[1].weight == 99);
+    CHECK(v[1].left.get() == &v[3]);
+}
+
+static void test_null_root() {
+    auto g = shm::swizzle<Vertex>(nullptr);
+    CHECK(g.size() == 0);
+    CHECK(g.root() == nullptr);
+}
+
+} // namespace
+
+int main() {
+    test_swizzle_preserves_shape();
+    test_unswizzle_publishes_changes();
+    test_null_root();
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct TagT {};
+
+struct alignas(8) Node8 {
+    std::uint64_t v;
+};
+
+static void test_null_encoding_unchanged() {
+    using P = shm::segment_tagged_ptr<Node8, TagT, 3, std::uint32_t>;
+    static_assert(sizeof(P) == sizeof(std::uint32_t));
+    static_assert(std::is_trivially_copyable_v<P>);
+    static_assert(P::align_shift() == 3);
+
+    P p;
+    CHECK(!p);
+    CHECK(p.get() == nullptr);
+    CHECK(p.tag() == 0);
+    CHECK(p.raw_storage() == 0);
+
+    p.set_tag(5);
+    CHECK(!p);
+    CHECK(p.get() == nullptr);
+    CHECK(p.tag() == 5);
+}
+
+static void test_low_bits_carry_tag_without_losing_range() {
+    constexpr std::size_t N = 512;
+    alignas(64) std::byte region[N];
+    std::memset(region, 0, N);
+    shm::segment_base<TagT>::set(region);
+
+    using P = shm::segment_tagged_ptr<Node8, TagT, 3, std::uint32_t>;
+    using Plain = shm::segment_offset_ptr<Node8, TagT, std::uint32_t>;
+
+    auto* n0 = new (region) Node8{1};
+    auto* n5 = new (region + 40) Node8{2};
+
+    P a(n0, 7);
+    CHECK(a.get() == n0);
+    CHECK(a.tag() == 7);
+    CHECK(!!a);
+
+    P b(n5);
+    CHECK(b.get() == n5);
+    CHECK(b.tag() == 0);
+
+    // With TagBits == log2(alignof(T)) the pointer part is plain offset_ptr
+    // storage shifted into the unused low bits.
+    Plain pl(n5);
+    CHECK(static_cast<std::uint32_t>(b.raw_storage()) == (pl.raw_storage() - 1) + 8);
+
+    b.set_tag(3);
+    CHECK(b.get() == n5);
+    CHECK(b.tag() == 3);
+    b.set_ptr(n0);
+    CHECK(b.get() == n0);
+    CHECK(b.tag() == 3);
+    b = nullptr;
+    CHECK(!b);
+    CHECK(b.tag() == 3);
+
+    P c = a;
+    CHECK(c == a);
+    c.set_tag(6);
+    CHECK(!(c == a));
+}
+
+static void test_high_bits_as_version_counter() {
+    constexpr std::size_t N = 1024;
+    alignas(64) std::byte region[N];
+    std::memset(region, 0, N);
+    shm::segment_base<TagT>::set(region);
+
+    // 8 tag bits on an 8-aligned type: 3 low bits are free, 5 come from the top.
+    using P = shm::segment_tagged_ptr<Node8, TagT, 8, std::uint32_t>;
+    auto* n = new (region + 8 * 100) Node8{3};
+
+    P p(n, 0xFF);
+    CHECK(p.get() == n);
+    CHECK(p.tag() == 0xFF);
+    CHECK(p->v == 3);
+
+    for (unsigned v = 0; v < 256; ++v) {
+        p.set_tag(static_cast<P::tag_type>(v));
+        CHECK(p.get() == n);
+        CHECK(p.tag() == v);
+    }
+}
+
+static void test_self_anchor_rebases_and_keeps_tag() {
+    struct Link {
+        shm::tagged_offset_ptr<Link, 2, shm::self_anchor, std::int32_t> next;
+        std::int32_t pad;
+    };
+    static_assert(!std::is_trivially_copyable_v<decltype(Link::next)>);
+
+    alignas(16) std::byte buf[256];
+    std::memset(buf, 0, sizeof(buf));
+
+    auto* a = new (buf + 0) Link{};
+    auto* b = new (buf + 64) Link{};
+    auto* c = new (buf + 128) Link{};
+
+    a->next.set(c, 2);
+    CHECK(a->next.get() == c);
+    CHECK(a->next.tag() == 2);
+
+    // Backward link exercises the signed path.
+    c->next.set(a, 1);
+    CHECK(c->next.get() == a);
+    CHECK(c->next.tag() == 1);
+
+    b->next = a->next;
+    CHECK(b->next.get() == c);
+    CHECK(b->next.tag() == 2);
+    CHECK(b->next.raw_storage() != a->next.raw_storage());
+}
+
+} // namespace
+
+int main() {
+    test_null_encoding_unchanged();
+    test_low_bits_carry_tag_without_losing_range();
+    test_high_bits_as_version_counter();
+    test_self_anchor_rebases_and_keeps_tag();
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct ShardTag {};
+
+struct Item {
+    std::uint32_t value;
+    shm::thread_offset_ptr<Item, ShardTag> next;
+};
+
+static_assert(sizeof(shm::thread_offset_ptr<Item, ShardTag>) == sizeof(std::uint32_t));
+static_assert(std::is_trivially_copyable_v<shm::thread_offset_ptr<Item, ShardTag>>);
+
+constexpr std::size_t kItems  = 64;
+constexpr std::size_t kShards = 4;
+
+// Every shard has the same layout: item i links to item i+1, values differ
+// by shard, so a walk decoded against the wrong base gives the wrong sum.
+static void build_shard(std::byte* region, std::uint32_t shard) {
+    shm::scoped_thread_base<ShardTag> bind(region);
+    auto* items = reinterpret_cast<Item*>(region);
+    for (std::size_t i = 0; i < kItems; ++i) {
+        new (&items[i]) Item{static_cast<std::uint32_t>(shard * 1000 + i), nullptr};
+    }
+    for (std::size_t i = 0; i + 1 < kItems; ++i) items[i].next = &items[i + 1];
+}
+
+static std::uint64_t walk(std::byte* region) {
+    std::uint64_t sum = 0;
+    for (const Item* it = reinterpret_cast<Item*>(region); it; it = it->next.get()) sum += it->value;
+    return sum;
+}
+
+static std::uint64_t expected_sum(std::uint32_t shard) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < kItems; ++i) sum += shard * 1000 + i;
+    return sum;
+}
+
+static void test_scoped_binding_nests() {
+    alignas(Item) std::byte a[16];
+    alignas(Item) std::byte b[16];
+
+    CHECK(shm::thread_segment_base<ShardTag>::get() == nullptr);
+    {
+        shm::scoped_thread_base<ShardTag> outer(a);
+        CHECK(shm::thread_segment_base<ShardTag>::get() == a);
+        {
+            shm::scoped_thread_base<ShardTag> inner(b);
+            CHECK(shm::thread_segment_base<ShardTag>::get() == b);
+        }
+        CHECK(shm::thread_segment_base<ShardTag>::get() == a);
+    }
+    CHECK(shm::thread_segment_base<ShardTag>::get() == nullptr);
+}
+
+static void test_shards_on_separate_threads() {
+    std::vector<std::vector<Item>> storage(kShards, std::vector<Item>(kItems));
+    auto region = [&](std::size_t s) { return reinterpret_cast<std::byte*>(storage[s].data()); };
+
+    for (std::size_t s = 0; s < kShards; ++s) build_shard(region(s), static_cast<std::uint32_t>(s));
+
+    // Same layout, so the encoded bytes are identical across shards.
+    CHECK(std::memcmp(&storage[0][0].next, &storage[1][0].next, sizeof(Item::next)) == 0);
+
+    std::vector<std::uint64_t> sums(kShards, 0);
+    std::vector<std::thread> workers;
+    for (std::size_t s = 0; s < kShards; ++s) {
+        workers.emplace_back([&, s] {
+            shm::scoped_thread_base<ShardTag> bind(region(s));
+            for (int rep = 0; rep < 100; ++rep) sums[s] = walk(region(s));
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    for (std::size_t s = 0; s < kShards; ++s) CHECK(sums[s] == expected_sum(static_cast<std::uint32_t>(s)));
+    CHECK(shm::thread_segment_base<ShardTag>::get() == nullptr);
+}
+
+} // namespace
+
+int main() {
+    test_scoped_binding_nests();
+    test_shards_on_separate_threads();
+    return 0;
+}
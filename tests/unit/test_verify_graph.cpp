@@ -0,0 +1,144 @@
+#include "shmTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <tuple>
+
+namespace {
+
+#define CHECK(expr)                                                                             \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            std::cerr << "CHECK failed: " #expr " @ " << __FILE__ << ":" << __LINE__ << "\n";  \
+            std::abort();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+struct VTag {};
+
+struct alignas(8) Blob {
+    std::uint64_t bytes[4];
+};
+
+struct Tree {
+    std::uint32_t key;
+    shm::segment_offset_ptr<Tree, VTag> left;
+    shm::segment_offset_ptr<Tree, VTag> right;
+    shm::segment_offset_ptr<Blob, VTag> payload;  // leaf type, no link_fields
+};
+
+} // namespace
+
+template <>
+struct shm::link_fields<Tree> {
+    static constexpr auto value = std::make_tuple(&Tree::left, &Tree::right, &Tree::payload);
+};
+
+namespace {
+
+using error = shm::verify_result::error;
+
+constexpr std::size_t kSize = 4096;
+
+struct Image {
+    alignas(64) std::byte bytes[kSize];
+    Tree* t(std::size_t i) { return reinterpret_cast<Tree*>(bytes + 64 + i * sizeof(Tree)); }
+    Blob* blob() { return reinterpret_cast<Blob*>(bytes + 2048); }
+};
+
+// root(0) -> 1, 2; 1 -> 3; 2 -> 3 (shared); 3 -> payload blob.
+static Tree* build(Image& img) {
+    std::memset(img.bytes, 0, kSize);
+    shm::segment_base<VTag>::set(img.bytes);
+    for (std::uint32_t i = 0; i < 4; ++i) new (img.t(i)) Tree{i, nullptr, nullptr, nullptr};
+    new (img.blob()) Blob{};
+    img.t(0)->left = img.t(1);
+    img.t(0)->right = img.t(2);
+    img.t(1)->left = img.t(3);
+    img.t(2)->right = img.t(3);
+    img.t(3)->payload = img.blob();
+    return img.t(0);
+}
+
+static void test_valid_graph() {
+    Image img;
+    Tree* root = build(img);
+    auto r = shm::verify_graph(img.bytes, kSize, root);
+    CHECK(r);
+    CHECK(r.objects == 5);
+    CHECK(r.links == 5);
+    CHECK(r.bytes == 4 * sizeof(Tree) + sizeof(Blob));
+    CHECK(shm::verify_graph<Tree>(img.bytes, kSize, nullptr));
+}
+
+static void test_out_of_range_offset() {
+    Image img;
+    Tree* root = build(img);
+    // Corrupt a stored offset so it points past the end of the image.
+    const std::uint32_t bad = kSize + 100;
+    std::memcpy(static_cast<void*>(&img.t(1)->left), &bad, sizeof(bad));
+    auto r = shm::verify_graph(img.bytes, kSize, root);
+    CHECK(r.code == error::out_of_range);
+    CHECK(r.where == img.bytes + kSize + 99);
+
+    // An object that starts inside but runs past the end is rejected too.
+    build(img);
+    img.t(3)->payload = reinterpret_cast<Blob*>(img.bytes + kSize - 16);
+    CHECK(shm::verify_graph(img.bytes, kSize, root).code == error::out_of_range);
+
+    // So is a root outside the image.
+    CHECK(shm::verify_graph(img.bytes, 64, root).code == error::out_of_range);
+}
+
+static void test_misaligned_offset() {
+    Image img;
+    Tree* root = build(img);
+    const std::uint32_t bad = 2048 + 3 + 1;  // "+1" encoding
+    std::memcpy(static_cast<void*>(&img.t(3)->payload), &bad, sizeof(bad));
+    auto r = shm::verify_graph(img.bytes, kSize, root);
+    CHECK(r.code == error::misaligned);
+    CHECK(r.where == img.bytes + 2051);
+}
+
+static void test_cycles() {
+    Image img;
+    Tree* root = build(img);
+    img.t(3)->right = img.t(0);
+    auto r = shm::verify_graph(img.bytes, kSize, root);
+    CHECK(r.code == error::cycle);
+    CHECK(r.where == root);
+
+    shm::verify_options allow;
+    allow.allow_cycles = true;
+    auto ok = shm::verify_graph(img.bytes, kSize, root, allow);
+    CHECK(ok);
+    CHECK(ok.objects == 5);
+
+    // Self-loop.
+    build(img);
+    img.t(2)->left = img.t(2);
+    CHECK(shm::verify_graph(img.bytes, kSize, root).code == error::cycle);
+}
+
+static void test_object_limit() {
+    Image img;
+    Tree* root = build(img);
+    shm::verify_options opt;
+    opt.max_objects = 3;
+    CHECK(shm::verify_graph(img.bytes, kSize, root, opt).code == error::too_many);
+}
+
+} // namespace
+
+int main() {
+    test_valid_graph();
+    test_out_of_range_offset();
+    test_misaligned_offset();
+    test_cycles();
+    test_object_limit();
+    return 0;
+}